@@ -0,0 +1,34 @@
+# SPDX-FileCopyrightText: © 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+#
+# SPDX-License-Identifier: AGPL-3.0-or-later
+
+"""Overhead of the native EIH (1PN) kernel against the Newtonian one"""
+
+import time
+
+from project.simulation.model import CPPPointMass, CPPRelativistic
+from project.utils import Dir
+from project.utils.data import BodyList
+
+TIME_STEP = 3600.0
+STOP_TIME = 365.25 * 86400.0
+
+
+def steps_per_second(
+    force_model: CPPPointMass | CPPRelativistic, bl: BodyList
+) -> float:
+    steps = int(STOP_TIME / TIME_STEP) + 1
+    start = time.perf_counter()
+    force_model._rk4_backend(bl.y_0, TIME_STEP, STOP_TIME, bl.n, bl.mu, progress=False)
+    return steps / (time.perf_counter() - start)
+
+
+if __name__ == "__main__":
+    for name in ["solar_system_20260101", "solar_system_moons_20260101"]:
+        bl = BodyList.load(Dir.data / f"{name}.toml")
+        newton = steps_per_second(CPPPointMass(), bl)
+        eih = steps_per_second(CPPRelativistic(), bl)
+        print(
+            f"{name} (n={bl.n}): Newton {newton:,.0f} steps/s, "
+            f"EIH {eih:,.0f} steps/s, overhead x{newton / eih:.2f}"
+        )
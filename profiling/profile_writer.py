@@ -0,0 +1,68 @@
+# SPDX-FileCopyrightText: © 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+#
+# SPDX-License-Identifier: AGPL-3.0-or-later
+
+"""Throughput of the native trajectory writer with and without I/O overlap"""
+
+import argparse
+import tempfile
+from pathlib import Path
+
+from project.simulation.cpp_force_kernel import rk4_simstate_cpp
+from project.utils import Dir
+from project.utils.data import BodyList
+from project.utils.simstate import pack_header
+
+TIME_STEP = 60.0
+
+
+def run(
+    bl: BodyList,
+    steps: int,
+    filename: Path,
+    buffer_steps: int,
+    direct_io: bool,
+    overlap: bool,
+) -> str:
+    stats = rk4_simstate_cpp(
+        bl.y_0,
+        TIME_STEP,
+        steps,
+        bl.mu,
+        str(filename),
+        pack_header(steps, bl.n, 6, TIME_STEP),
+        buffer_steps=buffer_steps,
+        direct_io=direct_io,
+        overlap=overlap,
+    )
+    filename.unlink()
+    return (
+        f"{stats['steps_per_second']:>12,.0f} steps/s  "
+        f"write {stats['write_seconds']:6.2f} s  "
+        f"stall {stats['stall_seconds']:6.2f} s"
+    )
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--system", default="solar_system_20260101")
+    parser.add_argument("--steps", type=int, default=1_000_000)
+    parser.add_argument("--buffer-steps", type=int, default=10_000)
+    parser.add_argument("--dir", type=Path, default=None, help="output directory")
+    args = parser.parse_args()
+
+    bl = BodyList.load(Dir.data / f"{args.system}.toml")
+    size = args.steps * bl.n * 6 * 8 / 2**20
+    print(f"{args.system} (n={bl.n}), {args.steps:,} steps, {size:,.0f} MiB")
+
+    with tempfile.TemporaryDirectory(dir=args.dir) as tmp:
+        filename = Path(tmp) / "profile.simstate"
+        for direct_io in [False, True]:
+            for overlap in [False, True]:
+                label = f"direct_io={direct_io!s:5} overlap={overlap!s:5}"
+                print(
+                    label,
+                    run(
+                        bl, args.steps, filename, args.buffer_steps, direct_io, overlap
+                    ),
+                )
@@ -0,0 +1,349 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include "integrators.hpp"
+#include "kernels.hpp"
+
+/* =========================
+   Vector-Jacobian product
+   ========================= */
+
+// Accumulate w^T df/dy into state_bar and w^T df/dmu into mu_bar, where f is
+// point_mass_force_kernel. Uses the same pair traversal: with d = r_i - r_j
+// and T = 3 d d^T / r^5 - I / r^3, each pair contributes
+// q = T (mu_j w_i - mu_i w_j) to r_bar_i (and -q to r_bar_j).
+inline void point_mass_vjp_kernel(
+    const double* __restrict__ state,  // size: 6*n
+    size_t n,
+    const double* __restrict__ mu,   // size: n
+    const double* __restrict__ w,    // size: 6*n, cotangent of f
+    double* __restrict__ state_bar,  // size: 6*n, accumulated
+    double* __restrict__ mu_bar      // size: n, accumulated
+) {
+    const size_t vel_offset = 3 * n;
+    const double* w_v = w + vel_offset;
+
+    // r' = v
+    for (size_t k = 0; k < vel_offset; ++k) {
+        state_bar[vel_offset + k] += w[k];
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        const double xi = state[3 * i];
+        const double yi = state[3 * i + 1];
+        const double zi = state[3 * i + 2];
+
+        const double mi = mu[i];
+        const double wix = w_v[3 * i];
+        const double wiy = w_v[3 * i + 1];
+        const double wiz = w_v[3 * i + 2];
+
+        for (size_t j = i + 1; j < n; ++j) {
+            const double dx = xi - state[3 * j];
+            const double dy = yi - state[3 * j + 1];
+            const double dz = zi - state[3 * j + 2];
+
+            const double r2 = dx * dx + dy * dy + dz * dz;
+            const double inv_r = 1.0 / std::sqrt(r2);
+            const double inv_r3 = inv_r * inv_r * inv_r;
+            const double inv_r5_3 = 3.0 * inv_r3 * inv_r * inv_r;
+
+            const double mj = mu[j];
+            const double wjx = w_v[3 * j];
+            const double wjy = w_v[3 * j + 1];
+            const double wjz = w_v[3 * j + 2];
+
+            // d(a)/d(mu): a_i -= mu_j g, a_j += mu_i g with g = d / r^3
+            mu_bar[j] -= (dx * wix + dy * wiy + dz * wiz) * inv_r3;
+            mu_bar[i] += (dx * wjx + dy * wjy + dz * wjz) * inv_r3;
+
+            const double ux = mj * wix - mi * wjx;
+            const double uy = mj * wiy - mi * wjy;
+            const double uz = mj * wiz - mi * wjz;
+            const double du = (dx * ux + dy * uy + dz * uz) * inv_r5_3;
+
+            const double qx = dx * du - ux * inv_r3;
+            const double qy = dy * du - uy * inv_r3;
+            const double qz = dz * du - uz * inv_r3;
+
+            state_bar[3 * i] += qx;
+            state_bar[3 * i + 1] += qy;
+            state_bar[3 * i + 2] += qz;
+
+            state_bar[3 * j] -= qx;
+            state_bar[3 * j + 1] -= qy;
+            state_bar[3 * j + 2] -= qz;
+        }
+    }
+}
+
+/* =========================
+   Discrete adjoint
+   ========================= */
+
+enum class AdjointScheme { rk4, leapfrog };
+
+// Gradients of a scalar loss on sampled states with respect to the initial
+// state and mu, by reverse-mode differentiation of the discrete integrator
+// (exact for the computed trajectory, not a continuous approximation).
+//
+// forward() keeps one state every `checkpoint_every` steps; backward()
+// recomputes one segment at a time from its checkpoint, so memory is
+// O(steps / checkpoint_every + checkpoint_every) states and the reverse pass
+// costs one extra forward sweep plus the VJPs.
+class PointMassAdjoint {
+   public:
+    PointMassAdjoint(std::vector<double> mu, AdjointScheme scheme, double h,
+                     size_t steps, size_t checkpoint_every)
+        : mu_(std::move(mu)),
+          n_(mu_.size()),
+          dim_(6 * n_),
+          scheme_(scheme),
+          h_(h),
+          steps_(steps),
+          every_(checkpoint_every),
+          force_{n_, mu_.data()},
+          rk4_(dim_),
+          leapfrog_(dim_) {
+        if (steps_ == 0) {
+            throw std::runtime_error("steps must be positive");
+        }
+        if (every_ == 0) {
+            every_ = std::max<size_t>(
+                1, static_cast<size_t>(std::sqrt(static_cast<double>(steps_))));
+        }
+    }
+
+    size_t n() const { return n_; }
+    size_t steps() const { return steps_; }
+    size_t checkpoint_every() const { return every_; }
+    size_t n_samples() const { return samples_.size(); }
+
+    // Propagate from y0 and write the state at each (sorted, unique) sample
+    // step index to sampled (n_samples x 6n)
+    void forward(const double* y0, const size_t* samples, size_t n_samples,
+                 double* sampled) {
+        samples_.assign(samples, samples + n_samples);
+        for (size_t k = 0; k < n_samples; ++k) {
+            if (samples_[k] >= steps_ ||
+                (k > 0 && samples_[k] <= samples_[k - 1])) {
+                throw std::runtime_error(
+                    "samples must be sorted, unique and < steps");
+            }
+        }
+
+        checkpoints_.assign(((steps_ - 1) / every_ + 1) * dim_, 0.0);
+        std::vector<double> y(y0, y0 + dim_);
+        std::vector<double> y_next(dim_);
+
+        size_t s = 0;
+        for (size_t i = 0; i < steps_; ++i) {
+            if (i % every_ == 0) {
+                std::copy(y.begin(), y.end(),
+                          checkpoints_.begin() + (i / every_) * dim_);
+            }
+            if (s < n_samples && samples_[s] == i) {
+                std::copy(y.begin(), y.end(), sampled + s * dim_);
+                ++s;
+            }
+            if (i + 1 < steps_) {
+                step(i, y.data(), y_next.data());
+                std::swap(y, y_next);
+            }
+        }
+        ready_ = true;
+    }
+
+    // Given dL/d(sampled) (n_samples x 6n), write dL/dy0 (6n) and dL/dmu (n)
+    void backward(const double* cotangents, double* grad_y0,
+                  double* grad_mu) {
+        if (!ready_) {
+            throw std::runtime_error("forward() must be called first");
+        }
+
+        std::vector<double> lambda(dim_, 0.0);
+        std::vector<double> lambda_prev(dim_);
+        std::fill(grad_mu, grad_mu + n_, 0.0);
+
+        std::vector<double> segment((every_ + 1) * dim_);
+        size_t s = samples_.size();
+
+        const size_t n_segments = (steps_ - 1) / every_ + 1;
+        for (size_t seg = n_segments; seg-- > 0;) {
+            const size_t first = seg * every_;
+            const size_t last = std::min(first + every_, steps_ - 1);
+
+            // Recompute the segment's states from its checkpoint
+            std::copy(checkpoints_.begin() + seg * dim_,
+                      checkpoints_.begin() + (seg + 1) * dim_, segment.begin());
+            for (size_t i = first; i < last; ++i) {
+                step(i, segment.data() + (i - first) * dim_,
+                     segment.data() + (i - first + 1) * dim_);
+            }
+
+            // Walk back through the segment. Its last state is the next
+            // segment's first one, whose cotangent was injected there.
+            for (size_t i = last + 1; i-- > first;) {
+                const bool owned = i != last || seg + 1 == n_segments;
+                if (owned && s > 0 && samples_[s - 1] == i) {
+                    --s;
+                    const double* c = cotangents + s * dim_;
+                    for (size_t k = 0; k < dim_; ++k) {
+                        lambda[k] += c[k];
+                    }
+                }
+                if (i > first) {
+                    std::fill(lambda_prev.begin(), lambda_prev.end(), 0.0);
+                    step_adjoint(segment.data() + (i - 1 - first) * dim_,
+                                 lambda.data(), lambda_prev.data(), grad_mu);
+                    std::swap(lambda, lambda_prev);
+                }
+            }
+        }
+
+        std::copy(lambda.begin(), lambda.end(), grad_y0);
+    }
+
+   private:
+    void step(size_t i, const double* y, double* y_next) {
+        const double t = static_cast<double>(i) * h_;
+        if (scheme_ == AdjointScheme::rk4) {
+            rk4_.step(force_, t, h_, y, y_next);
+        } else {
+            leapfrog_.step(force_, t, h_, y, y_next);
+        }
+    }
+
+    // lambda_prev += (dy_next/dy)^T lambda, mu_bar += (dy_next/dmu)^T lambda
+    void step_adjoint(const double* y, const double* lambda,
+                      double* lambda_prev, double* mu_bar) {
+        if (scheme_ == AdjointScheme::rk4) {
+            rk4_adjoint(y, lambda, lambda_prev, mu_bar);
+        } else {
+            leapfrog_adjoint(y, lambda, lambda_prev, mu_bar);
+        }
+    }
+
+    void rk4_adjoint(const double* y, const double* lambda,
+                     double* lambda_prev, double* mu_bar) {
+        const double h = h_;
+        buffers(9);
+        double* k1 = buf_[0].data();
+        double* k2 = buf_[1].data();
+        double* k3 = buf_[2].data();
+        double* y2 = buf_[3].data();
+        double* y3 = buf_[4].data();
+        double* y4 = buf_[5].data();
+        double* kb = buf_[6].data();
+        double* u = buf_[7].data();
+        double* kb_next = buf_[8].data();
+
+        // Recompute the stage points
+        point_mass_force_kernel(y, n_, mu_.data(), k1);
+        for (size_t k = 0; k < dim_; ++k) y2[k] = y[k] + 0.5 * h * k1[k];
+        point_mass_force_kernel(y2, n_, mu_.data(), k2);
+        for (size_t k = 0; k < dim_; ++k) y3[k] = y[k] + 0.5 * h * k2[k];
+        point_mass_force_kernel(y3, n_, mu_.data(), k3);
+        for (size_t k = 0; k < dim_; ++k) y4[k] = y[k] + h * k3[k];
+
+        for (size_t k = 0; k < dim_; ++k) lambda_prev[k] += lambda[k];
+
+        // Stage 4: k4 = f(y + h k3)
+        for (size_t k = 0; k < dim_; ++k) kb[k] = h / 6.0 * lambda[k];
+        stage_vjp(y4, kb, u, lambda_prev, mu_bar);
+        for (size_t k = 0; k < dim_; ++k) {
+            kb_next[k] = h / 3.0 * lambda[k] + h * u[k];
+        }
+
+        // Stage 3: k3 = f(y + h/2 k2)
+        stage_vjp(y3, kb_next, u, lambda_prev, mu_bar);
+        for (size_t k = 0; k < dim_; ++k) {
+            kb[k] = h / 3.0 * lambda[k] + 0.5 * h * u[k];
+        }
+
+        // Stage 2: k2 = f(y + h/2 k1)
+        stage_vjp(y2, kb, u, lambda_prev, mu_bar);
+        for (size_t k = 0; k < dim_; ++k) {
+            kb_next[k] = h / 6.0 * lambda[k] + 0.5 * h * u[k];
+        }
+
+        // Stage 1: k1 = f(y)
+        stage_vjp(y, kb_next, u, lambda_prev, mu_bar);
+    }
+
+    void leapfrog_adjoint(const double* y, const double* lambda,
+                          double* lambda_prev, double* mu_bar) {
+        const double h = h_;
+        const size_t half = 3 * n_;
+        buffers(3);
+        double* mid = buf_[0].data();
+        double* w = buf_[1].data();
+        double* u = buf_[2].data();
+
+        // Forward: r_m = r + h/2 v, v' = v + h a(r_m), r' = r_m + h/2 v'
+        for (size_t k = 0; k < half; ++k) {
+            mid[k] = y[k] + 0.5 * h * y[half + k];
+            mid[half + k] = y[half + k];
+        }
+
+        // r' = r_m + h/2 v'
+        const double* r_bar = lambda;
+        for (size_t k = 0; k < half; ++k) {
+            w[k] = 0.0;
+            w[half + k] = h * (lambda[half + k] + 0.5 * h * r_bar[k]);
+        }
+
+        // v' = v + h a(r_m)
+        std::fill(u, u + dim_, 0.0);
+        point_mass_vjp_kernel(mid, n_, mu_.data(), w, u, mu_bar);
+        for (size_t k = 0; k < half; ++k) {
+            const double rm_bar = r_bar[k] + u[k];
+            const double v_bar = lambda[half + k] + 0.5 * h * r_bar[k];
+            lambda_prev[k] += rm_bar;
+            lambda_prev[half + k] += v_bar + 0.5 * h * rm_bar;
+        }
+    }
+
+    // u = (df/dy)^T w at y; lambda_prev += u; mu_bar += (df/dmu)^T w
+    void stage_vjp(const double* y, const double* w, double* u,
+                   double* lambda_prev, double* mu_bar) {
+        std::fill(u, u + dim_, 0.0);
+        point_mass_vjp_kernel(y, n_, mu_.data(), w, u, mu_bar);
+        for (size_t k = 0; k < dim_; ++k) {
+            lambda_prev[k] += u[k];
+        }
+    }
+
+    void buffers(size_t count) {
+        while (buf_.size() < count) {
+            buf_.emplace_back(dim_);
+        }
+    }
+
+    std::vector<double> mu_;
+    size_t n_;
+    size_t dim_;
+    AdjointScheme scheme_;
+    double h_;
+    size_t steps_;
+    size_t every_;
+    PointMassForce<double> force_;
+    RK4Stepper<double> rk4_;
+    LeapfrogStepper<double> leapfrog_;
+
+    std::vector<size_t> samples_;
+    std::vector<double> checkpoints_;
+    std::vector<std::vector<double>> buf_;
+    bool ready_ = false;
+};
@@ -0,0 +1,38 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+// Compiled without -ffast-math and FMA contraction (see CMakeLists.txt)
+
+#include "double_double.hpp"
+
+#include "integrators.hpp"
+#include "kernels.hpp"
+
+void point_mass_force_kernel_dd(const DoubleDouble* state, size_t n,
+                                const DoubleDouble* mu, DoubleDouble* out) {
+    point_mass_force_kernel<DoubleDouble>(state, n, mu, out);
+}
+
+void euler_propagate_dd(const DoubleDouble* state, size_t n,
+                        const DoubleDouble* mu, double h, size_t steps,
+                        DoubleDouble* out) {
+    euler_propagate(PointMassForce<DoubleDouble>{n, mu}, state, 6 * n, h,
+                    steps, out);
+}
+
+void rk4_propagate_dd(const DoubleDouble* state, size_t n,
+                      const DoubleDouble* mu, double h, size_t steps,
+                      DoubleDouble* out) {
+    rk4_propagate(PointMassForce<DoubleDouble>{n, mu}, state, 6 * n, h, steps,
+                  out);
+}
+
+void leapfrog_propagate_dd(const DoubleDouble* state, size_t n,
+                           const DoubleDouble* mu, double h, size_t steps,
+                           DoubleDouble* out) {
+    leapfrog_propagate(PointMassForce<DoubleDouble>{n, mu}, state, 6 * n, h,
+                       steps, out);
+}
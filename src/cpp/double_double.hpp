@@ -0,0 +1,33 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include "scalar.hpp"
+
+/* =========================
+   Double-double entry points
+   ========================= */
+
+// Defined out of line in double_double.cpp, which is built with strict IEEE
+// floating point so the error-free transformations survive optimisation.
+
+void point_mass_force_kernel_dd(const DoubleDouble* state, size_t n,
+                                const DoubleDouble* mu, DoubleDouble* out);
+
+void euler_propagate_dd(const DoubleDouble* state, size_t n,
+                        const DoubleDouble* mu, double h, size_t steps,
+                        DoubleDouble* out);
+
+void rk4_propagate_dd(const DoubleDouble* state, size_t n,
+                      const DoubleDouble* mu, double h, size_t steps,
+                      DoubleDouble* out);
+
+void leapfrog_propagate_dd(const DoubleDouble* state, size_t n,
+                           const DoubleDouble* mu, double h, size_t steps,
+                           DoubleDouble* out);
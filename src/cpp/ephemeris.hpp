@@ -0,0 +1,272 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "parallel.hpp"
+
+/* =========================
+   Batch queries
+   ========================= */
+
+// Queries are evaluated in blocks of QUERY_LANES: a scalar pass locates
+// each query, then the interpolation runs lane-wise over the block in loops
+// the compiler vectorizes. Blocks are spread over threads.
+constexpr size_t QUERY_LANES = 8;
+constexpr size_t QUERY_GRAIN = 16384;  // queries per thread, at least
+
+// out[i] = eval(bodies[i], times[i]) for i < k, out of shape (k, 6), with
+// eval.block(bodies, times, count, out) handling up to QUERY_LANES queries
+template <typename Evaluator>
+void evaluate_batch(const Evaluator& eval, const size_t* bodies,
+                    const double* times, size_t k, double* __restrict__ out,
+                    size_t threads) {
+    parallel_for(k, threads, QUERY_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i += QUERY_LANES) {
+            eval.block(bodies + i, times + i,
+                       std::min(QUERY_LANES, end - i), out + 6 * i);
+        }
+    });
+}
+
+/* =========================
+   Chebyshev segment ephemeris
+   ========================= */
+
+// Piecewise Chebyshev ephemeris in the style of SPK types 2/3: each body has
+// consecutive segments [t0, t1], each holding the position coefficients of
+// x, y, z on tau = (2t - t0 - t1) / (t1 - t0) in [-1, 1]. Velocity is the
+// analytic derivative, so the pair stays consistent. Segments of body b are
+// first_segment[b] .. first_segment[b + 1] - 1, sorted by t0.
+class ChebyshevEphemeris {
+   public:
+    ChebyshevEphemeris(size_t bodies, size_t degree,
+                       std::vector<size_t> first_segment,
+                       std::vector<double> bounds,  // (segments, 2)
+                       std::vector<double> coeffs   // (segments, 3, degree+1)
+                       )
+        : bodies_(bodies),
+          degree_(degree),
+          first_(std::move(first_segment)),
+          start_(first_.back()),
+          stop_(first_.back()),
+          coeffs_(std::move(coeffs)) {
+        const size_t segments = first_.back();
+        if (first_.size() != bodies + 1 || bounds.size() != 2 * segments ||
+            coeffs_.size() != segments * 3 * (degree + 1)) {
+            throw std::runtime_error("inconsistent ephemeris table sizes");
+        }
+        for (size_t s = 0; s < segments; ++s) {
+            start_[s] = bounds[2 * s];
+            stop_[s] = bounds[2 * s + 1];
+        }
+    }
+
+    size_t bodies() const { return bodies_; }
+    size_t degree() const { return degree_; }
+    size_t segments() const { return first_.back(); }
+
+    // Position and velocity of `body` at `t` into out[0..5]
+    void state(size_t body, double t, double* __restrict__ out) const {
+        block(&body, &t, 1, out);
+    }
+
+    // Segment of `body` containing `t`
+    size_t locate(size_t body, double t) const {
+        if (body >= bodies_) {
+            throw std::runtime_error("body index out of range");
+        }
+        const double* first = start_.data() + first_[body];
+        const double* last = start_.data() + first_[body + 1];
+        const double* it = std::upper_bound(first, last, t);
+        if (it == first || !(t <= stop_[(it - start_.data()) - 1])) {
+            throw std::runtime_error("time " + std::to_string(t) +
+                                     " outside the ephemeris of body " +
+                                     std::to_string(body));
+        }
+        return static_cast<size_t>(it - start_.data()) - 1;
+    }
+
+    // Up to QUERY_LANES queries with the T_k and T_k' recurrences
+    //   T_{k+1} = 2 tau T_k - T_{k-1},  T'_{k+1} = 2 T_k + 2 tau T'_k - T'_{k-1}
+    void block(const size_t* bodies, const double* times, size_t count,
+               double* __restrict__ out) const {
+        constexpr size_t L = QUERY_LANES;
+        const size_t m = degree_ + 1;
+        const double* c[L];
+        double tau[L], scale[L];
+        for (size_t l = 0; l < count; ++l) {
+            const size_t s = locate(bodies[l], times[l]);
+            const double t0 = start_[s];
+            const double t1 = stop_[s];
+            c[l] = coeffs_.data() + s * 3 * m;
+            scale[l] = 2.0 / (t1 - t0);
+            tau[l] = (2.0 * times[l] - t0 - t1) / (t1 - t0);
+        }
+
+        double p[3][L], dp[3][L];
+        double t_prev[L], t_cur[L], d_prev[L], d_cur[L];
+        for (size_t l = 0; l < count; ++l) {
+            t_prev[l] = 1.0;
+            t_cur[l] = tau[l];
+            d_prev[l] = 0.0;
+            d_cur[l] = 1.0;
+        }
+        for (size_t k = 0; k < 3; ++k) {
+            for (size_t l = 0; l < count; ++l) {
+                p[k][l] = c[l][k * m];
+                dp[k][l] = 0.0;
+                if (m > 1) {
+                    p[k][l] += c[l][k * m + 1] * tau[l];
+                    dp[k][l] += c[l][k * m + 1];
+                }
+            }
+        }
+        for (size_t j = 2; j < m; ++j) {
+            for (size_t l = 0; l < count; ++l) {
+                const double t_next = 2.0 * tau[l] * t_cur[l] - t_prev[l];
+                const double d_next =
+                    2.0 * t_cur[l] + 2.0 * tau[l] * d_cur[l] - d_prev[l];
+                for (size_t k = 0; k < 3; ++k) {
+                    p[k][l] += c[l][k * m + j] * t_next;
+                    dp[k][l] += c[l][k * m + j] * d_next;
+                }
+                t_prev[l] = t_cur[l];
+                t_cur[l] = t_next;
+                d_prev[l] = d_cur[l];
+                d_cur[l] = d_next;
+            }
+        }
+        for (size_t l = 0; l < count; ++l) {
+            for (size_t k = 0; k < 3; ++k) {
+                out[6 * l + k] = p[k][l];
+                out[6 * l + 3 + k] = dp[k][l] * scale[l];
+            }
+        }
+    }
+
+    // out[i] = state(bodies[i], times[i]), out of shape (k, 6)
+    void evaluate(const size_t* bodies, const double* times, size_t k,
+                  double* __restrict__ out, size_t threads = 0) const {
+        evaluate_batch(*this, bodies, times, k, out, threads);
+    }
+
+   private:
+    size_t bodies_;
+    size_t degree_;
+    std::vector<size_t> first_;
+    std::vector<double> start_, stop_;
+    std::vector<double> coeffs_;
+};
+
+/* =========================
+   Hermite trajectory
+   ========================= */
+
+// Cubic Hermite interpolation of a stored trajectory (steps, bodies, 6)
+// with rows [r, v] per body: between two steps the position is the cubic
+// matching both positions and velocities, and the velocity its derivative.
+// Step i is at i * dt, or at times[i] (ascending) when a time column is
+// given. The data is borrowed, typically from a memory-mapped file.
+class HermiteTrajectory {
+   public:
+    HermiteTrajectory(const double* data, size_t steps, size_t bodies,
+                      double dt, const double* times)
+        : data_(data), steps_(steps), bodies_(bodies), dt_(dt), times_(times) {
+        if (steps < 2) {
+            throw std::runtime_error("interpolation needs at least 2 steps");
+        }
+        if (times == nullptr && !(dt > 0.0)) {
+            throw std::runtime_error("uniform steps need dt > 0");
+        }
+    }
+
+    size_t steps() const { return steps_; }
+    size_t bodies() const { return bodies_; }
+
+    void state(size_t body, double t, double* __restrict__ out) const {
+        block(&body, &t, 1, out);
+    }
+
+    void block(const size_t* bodies, const double* times, size_t count,
+               double* __restrict__ out) const {
+        constexpr size_t L = QUERY_LANES;
+        const double* a[L];  // row of the step before, then the step after
+        const double* b[L];
+        double s[L], h[L];
+        for (size_t l = 0; l < count; ++l) {
+            if (bodies[l] >= bodies_) {
+                throw std::runtime_error("body index out of range");
+            }
+            const size_t i = locate(times[l], s[l], h[l]);
+            a[l] = data_ + (i * bodies_ + bodies[l]) * 6;
+            b[l] = a[l] + bodies_ * 6;
+        }
+
+        for (size_t l = 0; l < count; ++l) {
+            const double u = s[l];
+            const double u2 = u * u;
+            const double u3 = u2 * u;
+            const double h00 = 2.0 * u3 - 3.0 * u2 + 1.0;
+            const double h10 = (u3 - 2.0 * u2 + u) * h[l];
+            const double h01 = 3.0 * u2 - 2.0 * u3;
+            const double h11 = (u3 - u2) * h[l];
+            const double g00 = (6.0 * u2 - 6.0 * u) / h[l];
+            const double g10 = 3.0 * u2 - 4.0 * u + 1.0;
+            const double g11 = 3.0 * u2 - 2.0 * u;
+            for (size_t k = 0; k < 3; ++k) {
+                const double r0 = a[l][k], v0 = a[l][3 + k];
+                const double r1 = b[l][k], v1 = b[l][3 + k];
+                out[6 * l + k] = h00 * r0 + h10 * v0 + h01 * r1 + h11 * v1;
+                out[6 * l + 3 + k] = g00 * (r0 - r1) + g10 * v0 + g11 * v1;
+            }
+        }
+    }
+
+    void evaluate(const size_t* bodies, const double* times, size_t k,
+                  double* __restrict__ out, size_t threads = 0) const {
+        evaluate_batch(*this, bodies, times, k, out, threads);
+    }
+
+   private:
+    // Interval [i, i + 1] containing t, its fraction s and length h
+    size_t locate(double t, double& s, double& h) const {
+        const double last = times_ != nullptr
+                                ? times_[steps_ - 1]
+                                : static_cast<double>(steps_ - 1) * dt_;
+        const double first = times_ != nullptr ? times_[0] : 0.0;
+        if (!(t >= first && t <= last)) {
+            throw std::runtime_error("time " + std::to_string(t) +
+                                     " outside the trajectory");
+        }
+        size_t i;
+        if (times_ == nullptr) {
+            i = std::min(static_cast<size_t>(t / dt_), steps_ - 2);
+            h = dt_;
+            s = t / dt_ - static_cast<double>(i);
+        } else {
+            i = std::min(static_cast<size_t>(
+                             std::upper_bound(times_, times_ + steps_, t) -
+                             times_) - 1,
+                         steps_ - 2);
+            h = times_[i + 1] - times_[i];
+            s = (t - times_[i]) / h;
+        }
+        return i;
+    }
+
+    const double* data_;
+    size_t steps_;
+    size_t bodies_;
+    double dt_;
+    const double* times_;
+};
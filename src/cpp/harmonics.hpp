@@ -0,0 +1,352 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/* =========================
+   Spherical-harmonic field
+   ========================= */
+
+constexpr size_t NO_FIELD = std::numeric_limits<size_t>::max();
+
+// Gravity field of an extended primary, expanded in fully normalized
+// coefficients C_nm, S_nm for 2 <= n <= degree, m <= min(n, order). The
+// central term is left to the point-mass pair loop, so only the
+// non-spherical part is evaluated here.
+//
+// Evaluation uses the normalized Cunningham V/W recursion (Montenbruck &
+// Gill, 3.2, with normalized factors), which is singularity-free at the
+// poles and stable to high degree. All recursion and acceleration factors
+// are tabulated at construction.
+class HarmonicField {
+   public:
+    // c, s: (degree + 1) x (order + 1), row-major, indexed [n][m].
+    // The body-fixed frame has its pole at (pole_ra, pole_dec) and prime
+    // meridian angle w_0 + w_dot * t [rad, rad/s]. Bodies farther than
+    // cutoff only feel the point mass.
+    HarmonicField(size_t body, size_t degree, size_t order, double radius,
+                  const double* c, const double* s, double pole_ra,
+                  double pole_dec, double w_0, double w_dot, double cutoff)
+        : body_(body),
+          degree_(degree),
+          order_(order),
+          radius_(radius),
+          cutoff2_(cutoff * cutoff),
+          w_0_(w_0),
+          w_dot_(w_dot) {
+        if (degree_ < 2 || order_ > degree_) {
+            throw std::runtime_error("field needs degree >= 2, order <= degree");
+        }
+        if (!(radius_ > 0.0)) {
+            throw std::runtime_error("field radius must be positive");
+        }
+
+        const size_t top = degree_ + 1;
+        const size_t terms = tri(top, top) + 1;
+        v_.resize(terms);
+        w_.resize(terms);
+        rec_a_.assign(terms, 0.0);
+        rec_b_.assign(terms, 0.0);
+        sect_.assign(top + 1, 0.0);
+
+        for (size_t m = 1; m <= top; ++m) {
+            const double dm = static_cast<double>(m);
+            sect_[m] = m == 1 ? std::sqrt(3.0)
+                              : std::sqrt((2.0 * dm + 1.0) / (2.0 * dm));
+        }
+        for (size_t n = 1; n <= top; ++n) {
+            const double dn = static_cast<double>(n);
+            for (size_t m = 0; m < n; ++m) {
+                const double dm = static_cast<double>(m);
+                rec_a_[tri(n, m)] = std::sqrt((2.0 * dn - 1.0) * (2.0 * dn + 1.0) /
+                                              ((dn - dm) * (dn + dm)));
+                if (n >= m + 2) {
+                    rec_b_[tri(n, m)] = std::sqrt(
+                        (2.0 * dn + 1.0) * (dn + dm - 1.0) * (dn - dm - 1.0) /
+                        ((2.0 * dn - 3.0) * (dn + dm) * (dn - dm)));
+                }
+            }
+        }
+
+        // Coefficients premultiplied by the normalization ratios between
+        // degree n and the degree n + 1 terms they pair with
+        for (size_t n = 2; n <= degree_; ++n) {
+            const double dn = static_cast<double>(n);
+            const double q = (2.0 * dn + 1.0) / (2.0 * dn + 3.0);
+            for (size_t m = 0; m <= std::min(n, order_); ++m) {
+                const double dm = static_cast<double>(m);
+                Term t;
+                t.n = n;
+                t.m = m;
+                t.c = c[n * (order_ + 1) + m];
+                t.s = s[n * (order_ + 1) + m];
+                if (m == 0) {
+                    t.f_up = std::sqrt(0.5 * q * (dn + 1.0) * (dn + 2.0));
+                    t.f_down = 0.0;
+                } else {
+                    t.f_up =
+                        0.5 * std::sqrt(q * (dn + dm + 1.0) * (dn + dm + 2.0));
+                    t.f_down = 0.5 * std::sqrt((m == 1 ? 2.0 : 1.0) * q *
+                                               (dn - dm + 2.0) *
+                                               (dn - dm + 1.0));
+                }
+                t.f_z = std::sqrt(q * (dn + dm + 1.0) * (dn - dm + 1.0));
+                if (t.c != 0.0 || t.s != 0.0) {
+                    terms_.push_back(t);
+                }
+            }
+        }
+
+        // Inertial -> body-fixed: R = Rz(W) Rx(pi/2 - dec) Rz(pi/2 + ra)
+        const double sa = std::sin(pole_ra), ca = std::cos(pole_ra);
+        const double sd = std::sin(pole_dec), cd = std::cos(pole_dec);
+        const double e[3][3] = {{-sa, ca, 0.0},
+                                {-sd * ca, -sd * sa, cd},
+                                {cd * ca, cd * sa, sd}};
+        for (size_t r = 0; r < 3; ++r) {
+            for (size_t k = 0; k < 3; ++k) {
+                pole_frame_[3 * r + k] = e[r][k];
+            }
+        }
+        orient(0.0);
+    }
+
+    size_t body() const { return body_; }
+    size_t degree() const { return degree_; }
+    size_t order() const { return order_; }
+
+    // Rotate the body-fixed frame to time t. Zonal fields are axisymmetric,
+    // so only tesseral fields pay for this.
+    void orient(double t) {
+        if (order_ == 0 && oriented_) {
+            return;
+        }
+        const double w = w_0_ + w_dot_ * t;
+        const double sw = std::sin(w), cw = std::cos(w);
+        for (size_t k = 0; k < 3; ++k) {
+            rot_[k] = cw * pole_frame_[k] + sw * pole_frame_[3 + k];
+            rot_[3 + k] = -sw * pole_frame_[k] + cw * pole_frame_[3 + k];
+            rot_[6 + k] = pole_frame_[6 + k];
+        }
+        oriented_ = true;
+    }
+
+    // Non-spherical acceleration per unit GM at inertial offset d from the
+    // primary (r2 = |d|^2, as already computed by the pair loop). Returns
+    // false beyond the cutoff without touching g.
+    bool acceleration(double dx, double dy, double dz, double r2, double* g) {
+        if (r2 > cutoff2_) {
+            return false;
+        }
+
+        // Body-fixed coordinates
+        const double x = rot_[0] * dx + rot_[1] * dy + rot_[2] * dz;
+        const double y = rot_[3] * dx + rot_[4] * dy + rot_[5] * dz;
+        const double z = rot_[6] * dx + rot_[7] * dy + rot_[8] * dz;
+
+        const double inv_r2 = 1.0 / r2;
+        const double rho = radius_ * radius_ * inv_r2;
+        const double x0 = radius_ * x * inv_r2;
+        const double y0 = radius_ * y * inv_r2;
+        const double z0 = radius_ * z * inv_r2;
+
+        const size_t top = degree_ + 1;
+        const size_t m_top = order_ + 1;
+
+        v_[0] = radius_ * std::sqrt(inv_r2);
+        w_[0] = 0.0;
+        for (size_t m = 0; m <= m_top; ++m) {
+            const size_t mm = tri(m, m);
+            if (m > 0) {
+                const size_t prev = tri(m - 1, m - 1);
+                v_[mm] = sect_[m] * (x0 * v_[prev] - y0 * w_[prev]);
+                w_[mm] = sect_[m] * (x0 * w_[prev] + y0 * v_[prev]);
+            }
+            if (m + 1 > top) {
+                continue;
+            }
+            const size_t up = tri(m + 1, m);
+            v_[up] = rec_a_[up] * z0 * v_[mm];
+            w_[up] = rec_a_[up] * z0 * w_[mm];
+            for (size_t n = m + 2; n <= top; ++n) {
+                const size_t k = tri(n, m);
+                const size_t k1 = tri(n - 1, m);
+                const size_t k2 = tri(n - 2, m);
+                v_[k] = rec_a_[k] * z0 * v_[k1] - rec_b_[k] * rho * v_[k2];
+                w_[k] = rec_a_[k] * z0 * w_[k1] - rec_b_[k] * rho * w_[k2];
+            }
+        }
+
+        double ax = 0.0, ay = 0.0, az = 0.0;
+        for (const Term& t : terms_) {
+            const size_t n1 = t.n + 1;
+            const size_t same = tri(n1, t.m);
+            const size_t right = tri(n1, t.m + 1);
+
+            if (t.m == 0) {
+                ax -= t.f_up * t.c * v_[right];
+                ay -= t.f_up * t.c * w_[right];
+            } else {
+                const size_t left = tri(n1, t.m - 1);
+                ax += t.f_up * (-t.c * v_[right] - t.s * w_[right]) +
+                      t.f_down * (t.c * v_[left] + t.s * w_[left]);
+                ay += t.f_up * (-t.c * w_[right] + t.s * v_[right]) +
+                      t.f_down * (-t.c * w_[left] + t.s * v_[left]);
+            }
+            az += t.f_z * (-t.c * v_[same] - t.s * w_[same]);
+        }
+
+        // Back to inertial, scaled to unit GM
+        const double scale = 1.0 / (radius_ * radius_);
+        ax *= scale;
+        ay *= scale;
+        az *= scale;
+        g[0] = rot_[0] * ax + rot_[3] * ay + rot_[6] * az;
+        g[1] = rot_[1] * ax + rot_[4] * ay + rot_[7] * az;
+        g[2] = rot_[2] * ax + rot_[5] * ay + rot_[8] * az;
+        return true;
+    }
+
+   private:
+    struct Term {
+        size_t n, m;
+        double c, s;
+        double f_up, f_down, f_z;
+    };
+
+    static size_t tri(size_t n, size_t m) { return n * (n + 1) / 2 + m; }
+
+    size_t body_;
+    size_t degree_;
+    size_t order_;
+    double radius_;
+    double cutoff2_;
+    double w_0_;
+    double w_dot_;
+    double pole_frame_[9];
+    double rot_[9];
+    bool oriented_ = false;
+
+    std::vector<Term> terms_;
+    std::vector<double> rec_a_, rec_b_, sect_;
+    std::vector<double> v_, w_;
+};
+
+/* =========================
+   Fused pair-loop kernel
+   ========================= */
+
+// point_mass_force_kernel plus the fields of extended primaries, evaluated
+// in the same pair traversal from the separation it already computed.
+// field_of[i] is the index of body i's field in `fields`, or NO_FIELD. A
+// field perturbs the other body by mu_p g and reacts on the primary with
+// -mu_j g, so total momentum is conserved.
+inline void harmonic_force_kernel(
+    const double* __restrict__ state,  // size: 6*n
+    size_t n,
+    const double* __restrict__ mu,        // size: n
+    HarmonicField* fields,
+    const size_t* __restrict__ field_of,  // size: n
+    double* __restrict__ out              // size: 6*n
+) {
+    const size_t vel_offset = 3 * n;
+
+    for (size_t k = 0; k < vel_offset; ++k) {
+        out[k] = state[k + vel_offset];
+        out[k + vel_offset] = 0.0;
+    }
+
+    double g[3];
+    for (size_t i = 0; i < n; ++i) {
+        const double xi = state[3 * i];
+        const double yi = state[3 * i + 1];
+        const double zi = state[3 * i + 2];
+
+        const double mi = mu[i];
+        const size_t fi = field_of[i];
+
+        double* ai = out + vel_offset + 3 * i;
+
+        for (size_t j = i + 1; j < n; ++j) {
+            const double dx = xi - state[3 * j];
+            const double dy = yi - state[3 * j + 1];
+            const double dz = zi - state[3 * j + 2];
+
+            const double r2 = dx * dx + dy * dy + dz * dz;
+            const double inv_r = 1.0 / std::sqrt(r2);
+            const double inv_r3 = inv_r * inv_r * inv_r;
+
+            double fx = dx * inv_r3;
+            double fy = dy * inv_r3;
+            double fz = dz * inv_r3;
+
+            const double mj = mu[j];
+            double* aj = out + vel_offset + 3 * j;
+
+            ai[0] -= mj * fx;
+            ai[1] -= mj * fy;
+            ai[2] -= mj * fz;
+
+            aj[0] += mi * fx;
+            aj[1] += mi * fy;
+            aj[2] += mi * fz;
+
+            // j seen from primary i is at -d, i seen from primary j at d
+            if (fi != NO_FIELD && fields[fi].acceleration(-dx, -dy, -dz, r2, g)) {
+                for (size_t c = 0; c < 3; ++c) {
+                    aj[c] += mi * g[c];
+                    ai[c] -= mj * g[c];
+                }
+            }
+            const size_t fj = field_of[j];
+            if (fj != NO_FIELD && fields[fj].acceleration(dx, dy, dz, r2, g)) {
+                for (size_t c = 0; c < 3; ++c) {
+                    ai[c] += mj * g[c];
+                    aj[c] -= mi * g[c];
+                }
+            }
+        }
+    }
+}
+
+// Owns per-call field state so it fits the integrators' f(t, y, dy)
+// signature. Copies of the fields keep recursion scratch per instance.
+struct HarmonicForce {
+    size_t n;
+    const double* mu;
+    mutable std::vector<HarmonicField> fields;
+    std::vector<size_t> field_of;
+
+    HarmonicForce(size_t n_, const double* mu_,
+                  std::vector<HarmonicField> fields_)
+        : n(n_), mu(mu_), fields(std::move(fields_)), field_of(n_, NO_FIELD) {
+        for (size_t k = 0; k < fields.size(); ++k) {
+            const size_t b = fields[k].body();
+            if (b >= n) {
+                throw std::runtime_error("field body index out of range");
+            }
+            if (field_of[b] != NO_FIELD) {
+                throw std::runtime_error("duplicate field for one body");
+            }
+            field_of[b] = k;
+        }
+    }
+
+    void operator()(double t, const double* y, double* dy) const {
+        for (HarmonicField& field : fields) {
+            field.orient(t);
+        }
+        harmonic_force_kernel(y, n, mu, fields.data(), field_of.data(), dy);
+    }
+};
@@ -0,0 +1,218 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "kernels.hpp"
+#include "parallel.hpp"
+#include "writer.hpp"
+
+/* =========================
+   Integrals of motion
+   ========================= */
+
+constexpr double GRAVITATIONAL_CONSTANT = 6.67430e-11;  // [m^3 kg^-1 s^-2]
+
+// Per state: energy, angular momentum x, y, z, linear momentum x, y, z,
+// center of mass x, y, z
+constexpr size_t INTEGRAL_DIM = 10;
+constexpr size_t INTEGRAL_GRAIN = 256;  // steps per thread, at least
+
+// Adds body terms to acc = [2 * kinetic energy, angular momentum, linear
+// momentum, mass moment]
+inline void accumulate_moments(const double* r, const double* v, double m,
+                               double* __restrict__ acc) {
+    acc[0] += m * (v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    acc[1] += m * (r[1] * v[2] - r[2] * v[1]);
+    acc[2] += m * (r[2] * v[0] - r[0] * v[2]);
+    acc[3] += m * (r[0] * v[1] - r[1] * v[0]);
+    acc[4] += m * v[0];
+    acc[5] += m * v[1];
+    acc[6] += m * v[2];
+    acc[7] += m * r[0];
+    acc[8] += m * r[1];
+    acc[9] += m * r[2];
+}
+
+// Integrals from accumulated moments, the pair potential and the total mass
+inline void finish_moments(const double* acc, double potential,
+                           double total_mass, double* __restrict__ out) {
+    out[0] = 0.5 * acc[0] + potential;
+    for (size_t k = 1; k < 7; ++k) {
+        out[k] = acc[k];
+    }
+    for (size_t k = 7; k < INTEGRAL_DIM; ++k) {
+        out[k] = acc[k] / total_mass;
+    }
+}
+
+// Per-thread positions as structure of arrays, so that the pair loop reads
+// contiguous lanes and vectorizes
+struct IntegralScratch {
+    std::vector<double> x, y, z;
+
+    explicit IntegralScratch(size_t n) : x(n), y(n), z(n) {}
+};
+
+// Integrals of one stored step, `row` holding (n, dim) states [r, v, ...].
+// The potential -G m_i m_j / r_ij is summed as -m_i mu_j / r_ij over pairs
+// i < j.
+inline void row_integrals(const double* __restrict__ row, size_t n,
+                          size_t dim, const double* __restrict__ mu,
+                          const double* __restrict__ mass, double total_mass,
+                          IntegralScratch& scratch, double* __restrict__ out) {
+    double* __restrict__ x = scratch.x.data();
+    double* __restrict__ y = scratch.y.data();
+    double* __restrict__ z = scratch.z.data();
+
+    double acc[INTEGRAL_DIM] = {};
+    for (size_t i = 0; i < n; ++i) {
+        const double* s = row + i * dim;
+        x[i] = s[0];
+        y[i] = s[1];
+        z[i] = s[2];
+        accumulate_moments(s, s + 3, mass[i], acc);
+    }
+
+    double potential = 0.0;
+    for (size_t i = 0; i + 1 < n; ++i) {
+        const double xi = x[i], yi = y[i], zi = z[i];
+        double sum = 0.0;
+        for (size_t j = i + 1; j < n; ++j) {
+            const double dx = xi - x[j];
+            const double dy = yi - y[j];
+            const double dz = zi - z[j];
+            sum += mu[j] / std::sqrt(dx * dx + dy * dy + dz * dz);
+        }
+        potential -= mass[i] * sum;
+    }
+
+    finish_moments(acc, potential, total_mass, out);
+}
+
+// out[t] = integrals of step t of a (steps, n, dim) trajectory, out of shape
+// (steps, INTEGRAL_DIM), with steps split over threads
+inline void trajectory_integrals(const double* data, size_t steps, size_t n,
+                                 size_t dim, const double* mu, double G,
+                                 double* out, size_t threads) {
+    std::vector<double> mass(n);
+    double total_mass = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        mass[i] = mu[i] / G;
+        total_mass += mass[i];
+    }
+
+    parallel_for(steps, threads, INTEGRAL_GRAIN, [&](size_t begin, size_t end) {
+        IntegralScratch scratch(n);
+        for (size_t t = begin; t < end; ++t) {
+            row_integrals(data + t * n * dim, n, dim, mu, mass.data(),
+                          total_mass, scratch, out + t * INTEGRAL_DIM);
+        }
+    });
+}
+
+/* =========================
+   Conservation monitor
+   ========================= */
+
+// Point-mass force that, once armed, also sums the pair potential of the
+// next state it is evaluated at (see point_mass_force_pairs)
+struct MonitoredPointMassForce {
+    size_t n;
+    const double* mu;
+    mutable bool armed = false;
+    mutable double pair_potential = 0.0;  // sum mu_i mu_j / r_ij
+
+    void operator()(double /*t*/, const double* y, double* dy) const {
+        if (armed) {
+            point_mass_force_pairs<double, true>(y, n, mu, dy,
+                                                 &pair_potential);
+            armed = false;
+        } else {
+            point_mass_force_kernel(y, n, mu, dy);
+        }
+    }
+};
+
+// Integrals of every `every`-th propagated state, streamed to a .siminteg
+// file after `header`. The potential of a sampled state comes from the
+// first force evaluation of the step leaving it (RK4's k1 is taken at the
+// state itself), so a sample costs O(n) on top of the force pass; only the
+// final state, which no step leaves, needs an extra evaluation.
+class IntegralMonitor {
+   public:
+    IntegralMonitor(const MonitoredPointMassForce& f, double G, size_t every,
+                    const std::string& path, const char* header,
+                    size_t header_bytes, size_t buffer_rows)
+        : f_(f),
+          G_(G),
+          every_(every),
+          mass_(f.n),
+          dy_(6 * f.n),
+          writer_(path, buffer_rows * INTEGRAL_DIM * sizeof(double), false,
+                  false) {
+        if (every == 0) {
+            throw std::runtime_error("integrals cadence must be positive");
+        }
+        for (size_t i = 0; i < f.n; ++i) {
+            mass_[i] = f.mu[i] / G;
+            total_mass_ += mass_[i];
+        }
+        writer_.append(header, header_bytes);
+    }
+
+    void row(size_t i, const double* y) {
+        complete();
+        if (i % every_ != 0) {
+            return;
+        }
+        const size_t n = f_.n;
+        for (double& value : moments_) {
+            value = 0.0;
+        }
+        for (size_t b = 0; b < n; ++b) {
+            accumulate_moments(y + 3 * b, y + 3 * (n + b), mass_[b], moments_);
+        }
+        f_.armed = true;
+        pending_ = true;
+    }
+
+    void finish(const double* y) {
+        if (pending_ && f_.armed) {
+            f_(0.0, y, dy_.data());
+        }
+        complete();
+        writer_.finish();
+    }
+
+   private:
+    // Emit the pending sample once its pair potential has been summed
+    void complete() {
+        if (!pending_) {
+            return;
+        }
+        double values[INTEGRAL_DIM];
+        finish_moments(moments_, -f_.pair_potential / G_, total_mass_, values);
+        writer_.append(values, sizeof(values));
+        pending_ = false;
+    }
+
+    const MonitoredPointMassForce& f_;
+    double G_;
+    size_t every_;
+    std::vector<double> mass_;
+    double total_mass_ = 0.0;
+    std::vector<double> dy_;
+    AsyncWriter writer_;
+    double moments_[INTEGRAL_DIM] = {};
+    bool pending_ = false;
+};
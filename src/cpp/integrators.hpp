@@ -0,0 +1,147 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/* =========================
+   Fixed-step steppers
+   ========================= */
+
+// Steppers advance y(t) -> y(t + h) for any force functor with signature
+// f(double t, const T* y, T* dy). They own their stage buffers, so one
+// instance is reused for the whole propagation.
+
+template <typename T>
+class EulerStepper {
+   public:
+    explicit EulerStepper(size_t dim) : dim_(dim), k_(dim) {}
+
+    template <typename Force>
+    void step(const Force& f, double t, double h, const T* y, T* y_next) {
+        const T dt = T(h);
+        f(t, y, k_.data());
+        for (size_t k = 0; k < dim_; ++k) {
+            y_next[k] = y[k] + dt * k_[k];
+        }
+    }
+
+   private:
+    size_t dim_;
+    std::vector<T> k_;
+};
+
+template <typename T>
+class RK4Stepper {
+   public:
+    explicit RK4Stepper(size_t dim)
+        : dim_(dim), k1_(dim), k2_(dim), k3_(dim), k4_(dim), tmp_(dim) {}
+
+    template <typename Force>
+    void step(const Force& f, double t, double h, const T* y, T* y_next) {
+        const T dt = T(h);
+        const T half = T(0.5) * dt;
+        const T sixth = dt / T(6);
+
+        f(t, y, k1_.data());
+        for (size_t k = 0; k < dim_; ++k) {
+            tmp_[k] = y[k] + half * k1_[k];
+        }
+        f(t + 0.5 * h, tmp_.data(), k2_.data());
+        for (size_t k = 0; k < dim_; ++k) {
+            tmp_[k] = y[k] + half * k2_[k];
+        }
+        f(t + 0.5 * h, tmp_.data(), k3_.data());
+        for (size_t k = 0; k < dim_; ++k) {
+            tmp_[k] = y[k] + dt * k3_[k];
+        }
+        f(t + h, tmp_.data(), k4_.data());
+
+        for (size_t k = 0; k < dim_; ++k) {
+            y_next[k] = y[k] + sixth * (k1_[k] + T(2) * k2_[k] +
+                                        T(2) * k3_[k] + k4_[k]);
+        }
+    }
+
+   private:
+    size_t dim_;
+    std::vector<T> k1_, k2_, k3_, k4_, tmp_;
+};
+
+// Drift-kick-drift Stormer-Verlet for states laid out as [r, v] with
+// r' = v. Symplectic and time-reversible, one force evaluation per step;
+// only the acceleration half of f's output is used.
+template <typename T>
+class LeapfrogStepper {
+   public:
+    explicit LeapfrogStepper(size_t dim)
+        : half_(dim / 2), k_(dim), mid_(dim) {}
+
+    template <typename Force>
+    void step(const Force& f, double t, double h, const T* y, T* y_next) {
+        const T dt = T(h);
+        const T half = T(0.5) * dt;
+
+        for (size_t k = 0; k < half_; ++k) {
+            mid_[k] = y[k] + half * y[half_ + k];
+            mid_[half_ + k] = y[half_ + k];
+        }
+        f(t + 0.5 * h, mid_.data(), k_.data());
+        for (size_t k = 0; k < half_; ++k) {
+            const T v = y[half_ + k] + dt * k_[half_ + k];
+            y_next[half_ + k] = v;
+            y_next[k] = mid_[k] + half * v;
+        }
+    }
+
+   private:
+    size_t half_;
+    std::vector<T> k_, mid_;
+};
+
+/* =========================
+   Trajectory drivers
+   ========================= */
+
+// Fill `out` (steps rows of dim values) starting from `state` at t0.
+// Row 0 is a copy of the initial state, matching the Python integrators.
+template <typename Stepper, typename T, typename Force>
+void propagate(Stepper& stepper, const Force& f, const T* state, size_t dim,
+               double h, size_t steps, T* out, double t0 = 0.0) {
+    if (steps == 0) {
+        return;
+    }
+    for (size_t k = 0; k < dim; ++k) {
+        out[k] = state[k];
+    }
+    for (size_t i = 0; i + 1 < steps; ++i) {
+        stepper.step(f, t0 + static_cast<double>(i) * h, h, out + i * dim,
+                     out + (i + 1) * dim);
+    }
+}
+
+template <typename T, typename Force>
+void euler_propagate(const Force& f, const T* state, size_t dim, double h,
+                     size_t steps, T* out, double t0 = 0.0) {
+    EulerStepper<T> stepper(dim);
+    propagate(stepper, f, state, dim, h, steps, out, t0);
+}
+
+template <typename T, typename Force>
+void rk4_propagate(const Force& f, const T* state, size_t dim, double h,
+                   size_t steps, T* out, double t0 = 0.0) {
+    RK4Stepper<T> stepper(dim);
+    propagate(stepper, f, state, dim, h, steps, out, t0);
+}
+
+template <typename T, typename Force>
+void leapfrog_propagate(const Force& f, const T* state, size_t dim, double h,
+                        size_t steps, T* out, double t0 = 0.0) {
+    LeapfrogStepper<T> stepper(dim);
+    propagate(stepper, f, state, dim, h, steps, out, t0);
+}
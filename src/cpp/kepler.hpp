@@ -0,0 +1,168 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <numbers>
+#include <stdexcept>
+#include <string>
+
+#include "parallel.hpp"
+
+/* =========================
+   Keplerian elements
+   ========================= */
+
+// Elements are converted in blocks of ELEMENT_LANES: every lane runs the
+// same KEPLER_NEWTON steps from Danby's starter, in loops the compiler
+// vectorizes, and only the lanes not yet converged (e close to 1) continue
+// one at a time. Sines and cosines are taken in loops of their own: fused
+// into sincos they would not vectorize. Blocks are spread over threads.
+constexpr size_t ELEMENT_LANES = 8;
+constexpr size_t ELEMENT_GRAIN = 16384;  // objects per thread, at least
+constexpr size_t ELEMENT_DIM = 6;        // a, e, i, node, periapsis, M
+constexpr int KEPLER_NEWTON = 6;
+constexpr int KEPLER_MAX_ITERATIONS = 64;
+constexpr double KEPLER_TOLERANCE = 4e-15;  // [rad], on E - e sin E - M
+
+// Eccentric anomaly of mean anomaly `m` in [-pi, pi] by Newton steps on
+// E - e sin E = M, for the lanes left unconverged by the vector pass
+inline double solve_kepler(double m, double e, double E) {
+    for (int k = 0; k < KEPLER_MAX_ITERATIONS; ++k) {
+        const double f = E - e * std::sin(E) - m;
+        if (std::abs(f) <= KEPLER_TOLERANCE) {
+            return E;
+        }
+        E -= f / (1.0 - e * std::cos(E));
+    }
+    throw std::runtime_error("Kepler's equation did not converge for e = " +
+                             std::to_string(e));
+}
+
+// Up to ELEMENT_LANES elliptic orbits: `elements` (count, 6) holds a [m],
+// e, i, node, argument of periapsis and mean anomaly [rad] in the reference
+// plane of the catalogue, mu [m^3/s^2] and dt [s] (time from the element
+// epoch) are read with strides of 0 or 1. States are rotated by `rotation`
+// (3x3, row-major) and offset by the `center` state, into r and v (count, 3).
+inline void elements_block(const double* __restrict__ elements,
+                           const double* mu, size_t mu_stride,
+                           const double* dt, size_t dt_stride,
+                           const double* __restrict__ center,
+                           const double* __restrict__ rotation, size_t count,
+                           double* __restrict__ r, double* __restrict__ v) {
+    constexpr size_t L = ELEMENT_LANES;
+    constexpr double TWO_PI = 2.0 * std::numbers::pi;
+    double el[ELEMENT_DIM][L], gm[L], t[L], m[L], E[L];
+    for (size_t l = 0; l < count; ++l) {
+        const double* row = elements + l * ELEMENT_DIM;
+        if (!(row[0] > 0.0) || !(row[1] >= 0.0 && row[1] < 1.0)) {
+            throw std::runtime_error(
+                "elements need a > 0 and 0 <= e < 1, got a = " +
+                std::to_string(row[0]) + ", e = " + std::to_string(row[1]));
+        }
+        for (size_t k = 0; k < ELEMENT_DIM; ++k) {
+            el[k][l] = row[k];
+        }
+        gm[l] = mu[l * mu_stride];
+        t[l] = dt[l * dt_stride];
+    }
+    const double* a = el[0];
+    const double* e = el[1];
+
+    // Mean anomaly at the epoch wrapped to [-pi, pi], Danby's starter
+    for (size_t l = 0; l < count; ++l) {
+        const double n = std::sqrt(gm[l] / (a[l] * a[l] * a[l]));
+        const double M = el[5][l] + n * t[l];
+        m[l] = M - TWO_PI * std::nearbyint(M / TWO_PI);
+        E[l] = m[l] + std::copysign(0.85 * e[l], m[l]);
+    }
+    double s[L], c[L];
+    for (int k = 0; k < KEPLER_NEWTON; ++k) {
+        for (size_t l = 0; l < count; ++l) {
+            s[l] = std::sin(E[l]);
+        }
+        for (size_t l = 0; l < count; ++l) {
+            c[l] = std::cos(E[l]);
+        }
+        for (size_t l = 0; l < count; ++l) {
+            E[l] -= (E[l] - e[l] * s[l] - m[l]) / (1.0 - e[l] * c[l]);
+        }
+    }
+    for (size_t l = 0; l < count; ++l) {
+        if (std::abs(E[l] - e[l] * std::sin(E[l]) - m[l]) > KEPLER_TOLERANCE) {
+            E[l] = solve_kepler(m[l], e[l], E[l]);
+        }
+    }
+    for (size_t l = 0; l < count; ++l) {
+        s[l] = std::sin(E[l]);
+    }
+    for (size_t l = 0; l < count; ++l) {
+        c[l] = std::cos(E[l]);
+    }
+
+    // Sines and cosines of i, node and argument of periapsis
+    double sa[3][L], ca[3][L];
+    for (size_t k = 0; k < 3; ++k) {
+        for (size_t l = 0; l < count; ++l) {
+            sa[k][l] = std::sin(el[2 + k][l]);
+        }
+        for (size_t l = 0; l < count; ++l) {
+            ca[k][l] = std::cos(el[2 + k][l]);
+        }
+    }
+
+    // Perifocal position and velocity along P and Q, the periapsis and 90
+    // degrees ahead of it in the orbital plane
+    double pr[3][L], pv[3][L];
+    for (size_t l = 0; l < count; ++l) {
+        const double b = std::sqrt(1.0 - e[l] * e[l]);
+        const double x = a[l] * (c[l] - e[l]);
+        const double y = a[l] * b * s[l];
+        const double w = std::sqrt(gm[l] * a[l]) / (a[l] * (1.0 - e[l] * c[l]));
+        const double vx = -w * s[l];
+        const double vy = w * b * c[l];
+
+        const double ci = ca[0][l], si = sa[0][l];
+        const double cn = ca[1][l], sn = sa[1][l];
+        const double cw = ca[2][l], sw = sa[2][l];
+        const double P[3] = {cw * cn - sw * sn * ci, cw * sn + sw * cn * ci,
+                             sw * si};
+        const double Q[3] = {-sw * cn - cw * sn * ci, -sw * sn + cw * cn * ci,
+                             cw * si};
+        for (size_t k = 0; k < 3; ++k) {
+            pr[k][l] = x * P[k] + y * Q[k];
+            pv[k][l] = vx * P[k] + vy * Q[k];
+        }
+    }
+    for (size_t l = 0; l < count; ++l) {
+        for (size_t j = 0; j < 3; ++j) {
+            const double* R = rotation + 3 * j;
+            r[3 * l + j] = center[j] + R[0] * pr[0][l] + R[1] * pr[1][l] +
+                           R[2] * pr[2][l];
+            v[3 * l + j] = center[3 + j] + R[0] * pv[0][l] +
+                           R[1] * pv[1][l] + R[2] * pv[2][l];
+        }
+    }
+}
+
+// Cartesian states of k objects from their elements, see elements_block
+inline void elements_to_states(const double* elements, const double* mu,
+                               size_t mu_stride, const double* dt,
+                               size_t dt_stride, const double* center,
+                               const double* rotation, size_t k, double* r,
+                               double* v, size_t threads) {
+    parallel_for(k, threads, ELEMENT_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i += ELEMENT_LANES) {
+            elements_block(elements + ELEMENT_DIM * i, mu + i * mu_stride,
+                           mu_stride, dt + i * dt_stride, dt_stride, center,
+                           rotation, std::min(ELEMENT_LANES, end - i),
+                           r + 3 * i, v + 3 * i);
+        }
+    });
+}
@@ -0,0 +1,103 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+#include "scalar.hpp"
+
+/* =========================
+   Fast symmetric force kernel
+   ========================= */
+
+// With `Potential`, the pair loop also accumulates sum_{i<j} mu_i mu_j / r_ij
+// into *pair_potential from the inverse distances it computes anyway
+template <typename T, bool Potential>
+inline void point_mass_force_pairs(
+    const T* __restrict__ state,  // size: 6*n
+    size_t n,
+    const T* __restrict__ mu,  // size: n
+    T* __restrict__ out,       // size: 6*n
+    T* pair_potential) {
+    using std::sqrt;
+
+    const size_t vel_offset = 3 * n;
+
+    // r' = v
+    for (size_t k = 0; k < vel_offset; ++k) {
+        out[k] = state[k + vel_offset];
+    }
+
+    // zero accelerations
+    for (size_t k = 0; k < vel_offset; ++k) {
+        out[k + vel_offset] = T(0);
+    }
+
+    // symmetric gravity
+    [[maybe_unused]] T pair = T(0);
+    for (size_t i = 0; i < n; ++i) {
+        const T xi = state[3 * i];
+        const T yi = state[3 * i + 1];
+        const T zi = state[3 * i + 2];
+
+        const T mi = mu[i];
+
+        for (size_t j = i + 1; j < n; ++j) {
+            const T dx = xi - state[3 * j];
+            const T dy = yi - state[3 * j + 1];
+            const T dz = zi - state[3 * j + 2];
+
+            const T r2 = dx * dx + dy * dy + dz * dz;
+            const T inv_r = T(1) / sqrt(r2);
+            const T inv_r3 = inv_r * inv_r * inv_r;
+
+            const T fx = dx * inv_r3;
+            const T fy = dy * inv_r3;
+            const T fz = dz * inv_r3;
+
+            const T mj = mu[j];
+
+            out[vel_offset + 3 * i] -= mj * fx;
+            out[vel_offset + 3 * i + 1] -= mj * fy;
+            out[vel_offset + 3 * i + 2] -= mj * fz;
+
+            out[vel_offset + 3 * j] += mi * fx;
+            out[vel_offset + 3 * j + 1] += mi * fy;
+            out[vel_offset + 3 * j + 2] += mi * fz;
+
+            if constexpr (Potential) {
+                pair += mi * mj * inv_r;
+            }
+        }
+    }
+
+    if constexpr (Potential) {
+        *pair_potential = pair;
+    }
+}
+
+template <typename T>
+inline void point_mass_force_kernel(
+    const T* __restrict__ state,  // size: 6*n
+    size_t n,
+    const T* __restrict__ mu,  // size: n
+    T* __restrict__ out        // size: 6*n
+) {
+    point_mass_force_pairs<T, false>(state, n, mu, out, nullptr);
+}
+
+// Binds mu so the kernel fits the integrators' f(t, y, dy) signature
+template <typename T>
+struct PointMassForce {
+    size_t n;
+    const T* mu;
+
+    void operator()(double /*t*/, const T* y, T* dy) const {
+        point_mass_force_kernel(y, n, mu, dy);
+    }
+};
@@ -0,0 +1,45 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+#include "parallel.hpp"
+
+/* =========================
+   Trajectory layouts
+   ========================= */
+
+constexpr size_t TRANSPOSE_BLOCK = 32;  // 32x32 doubles: two 8 KiB tiles
+
+// Step-major rows to body-major series: dst[c * dst_stride + r] =
+// src[r * cols + c] for r < rows, c < cols. Square blocks keep both the
+// rows read and the series written in cache; column blocks are spread over
+// threads. Used to turn (steps, bodies, state_dim) output into tiles of
+// (bodies, state_dim, tile_steps).
+inline void transpose_rows(const double* __restrict__ src, size_t rows,
+                           size_t cols, double* __restrict__ dst,
+                           size_t dst_stride, size_t threads = 0) {
+    const size_t col_blocks = (cols + TRANSPOSE_BLOCK - 1) / TRANSPOSE_BLOCK;
+    const size_t grain = std::max<size_t>(1, (1 << 16) / (rows + 1));
+    parallel_for(col_blocks, threads, grain, [&](size_t begin, size_t end) {
+        for (size_t cb = begin; cb < end; ++cb) {
+            const size_t c0 = cb * TRANSPOSE_BLOCK;
+            const size_t c1 = std::min(cols, c0 + TRANSPOSE_BLOCK);
+            for (size_t r0 = 0; r0 < rows; r0 += TRANSPOSE_BLOCK) {
+                const size_t r1 = std::min(rows, r0 + TRANSPOSE_BLOCK);
+                for (size_t c = c0; c < c1; ++c) {
+                    double* out = dst + c * dst_stride;
+                    for (size_t r = r0; r < r1; ++r) {
+                        out[r] = src[r * cols + c];
+                    }
+                }
+            }
+        }
+    });
+}
@@ -8,103 +8,1008 @@
 
 #include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
 
 #include <cmath>
 #include <cstddef>
+#include <limits>
+#include <numbers>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "adjoint.hpp"
+#include "double_double.hpp"
+#include "ephemeris.hpp"
+#include "harmonics.hpp"
+#include "integrals.hpp"
+#include "integrators.hpp"
+#include "kepler.hpp"
+#include "kernels.hpp"
+#include "layout.hpp"
+#include "reader.hpp"
+#include "relativity.hpp"
+#include "scalar.hpp"
+#include "variational.hpp"
+#include "writer.hpp"
 
 namespace py = pybind11;
 
 /* =========================
-   Fast symmetric force kernel
+   Scalar dispatch
    ========================= */
 
-inline void point_mass_force_kernel(
-    const double* __restrict__ state,  // size: 6*n
-    size_t n,
-    const double* __restrict__ mu,  // size: n
-    double* __restrict__ out        // size: 6*n
-) {
-    const size_t vel_offset = 3 * n;
+template <typename T>
+struct PointMassBackend {
+    static void force(const T* state, size_t n, const T* mu, T* out) {
+        point_mass_force_kernel(state, n, mu, out);
+    }
 
-    // r' = v
-    for (size_t k = 0; k < vel_offset; ++k) {
-        out[k] = state[k + vel_offset];
+    static void euler(const T* state, size_t n, const T* mu, double h,
+                      size_t steps, T* out) {
+        euler_propagate(PointMassForce<T>{n, mu}, state, 6 * n, h, steps, out);
     }
 
-    // zero accelerations
-    for (size_t k = 0; k < vel_offset; ++k) {
-        out[k + vel_offset] = 0.0;
+    static void rk4(const T* state, size_t n, const T* mu, double h,
+                    size_t steps, T* out) {
+        rk4_propagate(PointMassForce<T>{n, mu}, state, 6 * n, h, steps, out);
     }
 
-    // symmetric gravity
-    for (size_t i = 0; i < n; ++i) {
-        const double xi = state[3 * i];
-        const double yi = state[3 * i + 1];
-        const double zi = state[3 * i + 2];
+    static void leapfrog(const T* state, size_t n, const T* mu, double h,
+                         size_t steps, T* out) {
+        leapfrog_propagate(PointMassForce<T>{n, mu}, state, 6 * n, h, steps,
+                           out);
+    }
+};
 
-        const double mi = mu[i];
+template <>
+struct PointMassBackend<DoubleDouble> {
+    static void force(const DoubleDouble* state, size_t n,
+                      const DoubleDouble* mu, DoubleDouble* out) {
+        point_mass_force_kernel_dd(state, n, mu, out);
+    }
 
-        for (size_t j = i + 1; j < n; ++j) {
-            const double dx = xi - state[3 * j];
-            const double dy = yi - state[3 * j + 1];
-            const double dz = zi - state[3 * j + 2];
+    static void euler(const DoubleDouble* state, size_t n,
+                      const DoubleDouble* mu, double h, size_t steps,
+                      DoubleDouble* out) {
+        euler_propagate_dd(state, n, mu, h, steps, out);
+    }
 
-            const double r2 = dx * dx + dy * dy + dz * dz;
-            const double inv_r = 1.0 / std::sqrt(r2);
-            const double inv_r3 = inv_r * inv_r * inv_r;
+    static void rk4(const DoubleDouble* state, size_t n, const DoubleDouble* mu,
+                    double h, size_t steps, DoubleDouble* out) {
+        rk4_propagate_dd(state, n, mu, h, steps, out);
+    }
 
-            const double fx = dx * inv_r3;
-            const double fy = dy * inv_r3;
-            const double fz = dz * inv_r3;
+    static void leapfrog(const DoubleDouble* state, size_t n,
+                         const DoubleDouble* mu, double h, size_t steps,
+                         DoubleDouble* out) {
+        leapfrog_propagate_dd(state, n, mu, h, steps, out);
+    }
+};
 
-            const double mj = mu[j];
+/* =========================
+   Buffer helpers
+   ========================= */
 
-            out[vel_offset + 3 * i] -= mj * fx;
-            out[vel_offset + 3 * i + 1] -= mj * fy;
-            out[vel_offset + 3 * i + 2] -= mj * fz;
+template <typename T>
+using scalar_array =
+    py::array_t<typename ScalarTraits<T>::storage,
+                py::array::c_style | py::array::forcecast>;
 
-            out[vel_offset + 3 * j] += mi * fx;
-            out[vel_offset + 3 * j + 1] += mi * fy;
-            out[vel_offset + 3 * j + 2] += mi * fz;
+// Number of T scalars held by a 1D array. Two-lane types (double-double,
+// dual) are passed as (size, 2) arrays of their storage type.
+template <typename T>
+size_t scalar_size(const py::buffer_info& buf) {
+    constexpr size_t lanes = ScalarTraits<T>::lanes;
+    if (lanes == 1) {
+        if (buf.ndim != 1) {
+            throw std::runtime_error("All arrays must be 1D");
         }
+    } else if (buf.ndim != 2 || static_cast<size_t>(buf.shape[1]) != lanes) {
+        throw std::runtime_error("All arrays must have shape (size, " +
+                                 std::to_string(lanes) + ")");
+    }
+    return static_cast<size_t>(buf.shape[0]);
+}
+
+template <typename T>
+T* scalar_ptr(const py::buffer_info& buf) {
+    return reinterpret_cast<T*>(buf.ptr);
+}
+
+template <typename T>
+scalar_array<T> empty_trajectory(size_t steps, size_t dim) {
+    std::vector<py::ssize_t> shape{static_cast<py::ssize_t>(steps),
+                                   static_cast<py::ssize_t>(dim)};
+    if (ScalarTraits<T>::lanes > 1) {
+        shape.push_back(static_cast<py::ssize_t>(ScalarTraits<T>::lanes));
     }
+    return scalar_array<T>(shape);
 }
 
 /* =========================
-   Python-facing wrapper
+   Python-facing wrappers
    ========================= */
 
-void point_mass_cpp(
-    py::array_t<double, py::array::c_style | py::array::forcecast> state,
-    py::array_t<double, py::array::c_style | py::array::forcecast> mu,
-    py::array_t<double, py::array::c_style | py::array::forcecast> out) {
+template <typename T>
+void point_mass_cpp(scalar_array<T> state, scalar_array<T> mu,
+                    scalar_array<T> out) {
     auto state_buf = state.request();
     auto mu_buf = mu.request();
     auto out_buf = out.request();
 
-    if (state_buf.ndim != 1 || mu_buf.ndim != 1 || out_buf.ndim != 1) {
-        throw std::runtime_error("All arrays must be 1D");
+    const size_t n = scalar_size<T>(mu_buf);
+    if (scalar_size<T>(state_buf) != 6 * n ||
+        scalar_size<T>(out_buf) != 6 * n) {
+        throw std::runtime_error("state and out must have size 6*n");
+    }
+
+    PointMassBackend<T>::force(scalar_ptr<const T>(state_buf), n,
+                               scalar_ptr<const T>(mu_buf),
+                               scalar_ptr<T>(out_buf));
+}
+
+template <typename T, typename Driver>
+scalar_array<T> integrate_cpp(scalar_array<T> state, double time_step,
+                              size_t steps, scalar_array<T> mu,
+                              Driver driver) {
+    auto state_buf = state.request();
+    auto mu_buf = mu.request();
+
+    const size_t n = scalar_size<T>(mu_buf);
+    if (scalar_size<T>(state_buf) != 6 * n) {
+        throw std::runtime_error("state must have size 6*n");
+    }
+
+    scalar_array<T> y = empty_trajectory<T>(steps, 6 * n);
+    auto y_buf = y.request();
+
+    {
+        py::gil_scoped_release release;
+        driver(scalar_ptr<const T>(state_buf), n, scalar_ptr<const T>(mu_buf),
+               time_step, steps, scalar_ptr<T>(y_buf));
+    }
+
+    return y;
+}
+
+template <typename T>
+scalar_array<T> euler_cpp(scalar_array<T> state, double time_step,
+                          size_t steps, scalar_array<T> mu) {
+    return integrate_cpp<T>(state, time_step, steps, mu,
+                            &PointMassBackend<T>::euler);
+}
+
+template <typename T>
+scalar_array<T> rk4_cpp(scalar_array<T> state, double time_step, size_t steps,
+                        scalar_array<T> mu) {
+    return integrate_cpp<T>(state, time_step, steps, mu,
+                            &PointMassBackend<T>::rk4);
+}
+
+template <typename T>
+scalar_array<T> leapfrog_cpp(scalar_array<T> state, double time_step,
+                             size_t steps, scalar_array<T> mu) {
+    return integrate_cpp<T>(state, time_step, steps, mu,
+                            &PointMassBackend<T>::leapfrog);
+}
+
+/* =========================
+   Variational equations
+   ========================= */
+
+using index_array =
+    py::array_t<py::ssize_t, py::array::c_style | py::array::forcecast>;
+using double_array =
+    py::array_t<double, py::array::c_style | py::array::forcecast>;
+// Written in place: bound with noconvert, so a copy is never filled instead
+using out_array = py::array_t<double, py::array::c_style>;
+
+// Map body index -> position in the differentiated subset
+std::vector<size_t> subset_index(const index_array& bodies, size_t n) {
+    auto bodies_buf = bodies.request();
+    if (bodies_buf.ndim != 1) {
+        throw std::runtime_error("bodies must be 1D");
+    }
+
+    std::vector<size_t> subset(n, NOT_IN_SUBSET);
+    const py::ssize_t* b = static_cast<const py::ssize_t*>(bodies_buf.ptr);
+    for (py::ssize_t k = 0; k < bodies_buf.shape[0]; ++k) {
+        if (b[k] < 0 || static_cast<size_t>(b[k]) >= n) {
+            throw std::runtime_error("body index out of range");
+        }
+        if (subset[b[k]] != NOT_IN_SUBSET) {
+            throw std::runtime_error("duplicate body index");
+        }
+        subset[b[k]] = static_cast<size_t>(k);
     }
+    return subset;
+}
+
+void point_mass_gradient_cpp(double_array state, double_array mu,
+                             index_array bodies, double_array out,
+                             double_array grad) {
+    auto state_buf = state.request();
+    auto mu_buf = mu.request();
+    auto out_buf = out.request();
+    auto grad_buf = grad.request();
 
-    const size_t n = mu_buf.size;
-    if (state_buf.size != 6 * n || out_buf.size != 6 * n) {
+    const size_t n = scalar_size<double>(mu_buf);
+    if (scalar_size<double>(state_buf) != 6 * n ||
+        scalar_size<double>(out_buf) != 6 * n) {
         throw std::runtime_error("state and out must have size 6*n");
     }
 
-    const double* s = static_cast<const double*>(state_buf.ptr);
+    const size_t m = static_cast<size_t>(bodies.size());
+    if (grad_buf.ndim != 2 || static_cast<size_t>(grad_buf.shape[0]) != 3 * m ||
+        static_cast<size_t>(grad_buf.shape[1]) != 3 * m) {
+        throw std::runtime_error("grad must have shape (3*m, 3*m)");
+    }
+
+    const std::vector<size_t> subset = subset_index(bodies, n);
+    point_mass_gradient_kernel(static_cast<const double*>(state_buf.ptr), n,
+                               static_cast<const double*>(mu_buf.ptr),
+                               subset.data(), m,
+                               static_cast<double*>(out_buf.ptr),
+                               static_cast<double*>(grad_buf.ptr));
+}
+
+py::tuple stm_rk4_cpp(double_array state, double time_step, size_t steps,
+                      double_array mu, index_array bodies, size_t stride) {
+    auto state_buf = state.request();
+    auto mu_buf = mu.request();
+
+    const size_t n = scalar_size<double>(mu_buf);
+    if (scalar_size<double>(state_buf) != 6 * n) {
+        throw std::runtime_error("state must have size 6*n");
+    }
+    if (stride == 0) {
+        throw std::runtime_error("stride must be positive");
+    }
+
+    const size_t m = static_cast<size_t>(bodies.size());
+    const std::vector<size_t> subset = subset_index(bodies, n);
+    const size_t samples = steps == 0 ? 0 : (steps - 1) / stride + 1;
+
+    double_array y = empty_trajectory<double>(steps, 6 * n);
+    double_array phi({static_cast<py::ssize_t>(samples),
+                      static_cast<py::ssize_t>(6 * m),
+                      static_cast<py::ssize_t>(6 * m)});
+    auto y_buf = y.request();
+    auto phi_buf = phi.request();
+
+    if (steps > 0) {
+        py::gil_scoped_release release;
+        stm_rk4_propagate(static_cast<const double*>(state_buf.ptr), n,
+                          static_cast<const double*>(mu_buf.ptr),
+                          subset.data(), m, time_step, steps, stride,
+                          static_cast<double*>(y_buf.ptr),
+                          static_cast<double*>(phi_buf.ptr));
+    }
+
+    return py::make_tuple(y, phi);
+}
+
+/* =========================
+   Adjoint sensitivities
+   ========================= */
+
+AdjointScheme adjoint_scheme(const std::string& scheme) {
+    if (scheme == "rk4") {
+        return AdjointScheme::rk4;
+    }
+    if (scheme == "leapfrog") {
+        return AdjointScheme::leapfrog;
+    }
+    throw std::runtime_error("scheme must be 'rk4' or 'leapfrog'");
+}
+
+PointMassAdjoint make_adjoint(double_array mu, double time_step, size_t steps,
+                              const std::string& scheme,
+                              size_t checkpoint_every) {
+    auto mu_buf = mu.request();
+    const size_t n = scalar_size<double>(mu_buf);
     const double* m = static_cast<const double*>(mu_buf.ptr);
-    double* o = static_cast<double*>(out_buf.ptr);
+    return PointMassAdjoint(std::vector<double>(m, m + n),
+                            adjoint_scheme(scheme), time_step, steps,
+                            checkpoint_every);
+}
+
+double_array adjoint_forward(PointMassAdjoint& self, double_array state,
+                             index_array samples) {
+    auto state_buf = state.request();
+    auto samples_buf = samples.request();
+    if (scalar_size<double>(state_buf) != 6 * self.n()) {
+        throw std::runtime_error("state must have size 6*n");
+    }
+    if (samples_buf.ndim != 1) {
+        throw std::runtime_error("samples must be 1D");
+    }
+
+    const size_t k = static_cast<size_t>(samples_buf.shape[0]);
+    const py::ssize_t* s = static_cast<const py::ssize_t*>(samples_buf.ptr);
+    std::vector<size_t> sample_steps(k);
+    for (size_t i = 0; i < k; ++i) {
+        if (s[i] < 0) {
+            throw std::runtime_error("samples must be non-negative");
+        }
+        sample_steps[i] = static_cast<size_t>(s[i]);
+    }
+
+    double_array sampled = empty_trajectory<double>(k, 6 * self.n());
+    auto sampled_buf = sampled.request();
+    {
+        py::gil_scoped_release release;
+        self.forward(static_cast<const double*>(state_buf.ptr),
+                     sample_steps.data(), k,
+                     static_cast<double*>(sampled_buf.ptr));
+    }
+    return sampled;
+}
+
+py::tuple adjoint_backward(PointMassAdjoint& self, double_array cotangents) {
+    auto cot_buf = cotangents.request();
+    if (cot_buf.ndim != 2 ||
+        static_cast<size_t>(cot_buf.shape[0]) != self.n_samples() ||
+        static_cast<size_t>(cot_buf.shape[1]) != 6 * self.n()) {
+        throw std::runtime_error("cotangents must have shape (samples, 6*n)");
+    }
+
+    double_array grad_state(static_cast<py::ssize_t>(6 * self.n()));
+    double_array grad_mu(static_cast<py::ssize_t>(self.n()));
+    auto gs_buf = grad_state.request();
+    auto gm_buf = grad_mu.request();
+    {
+        py::gil_scoped_release release;
+        self.backward(static_cast<const double*>(cot_buf.ptr),
+                      static_cast<double*>(gs_buf.ptr),
+                      static_cast<double*>(gm_buf.ptr));
+    }
+    return py::make_tuple(grad_state, grad_mu);
+}
+
+/* =========================
+   Spherical-harmonic fields
+   ========================= */
+
+HarmonicField make_field(size_t body, double radius, double_array c,
+                         double_array s, double pole_ra, double pole_dec,
+                         double w_0, double w_dot, double cutoff) {
+    auto c_buf = c.request();
+    auto s_buf = s.request();
+    if (c_buf.ndim != 2 || s_buf.ndim != 2 || c_buf.shape != s_buf.shape) {
+        throw std::runtime_error("c and s must be 2D arrays of equal shape");
+    }
+    const size_t degree = static_cast<size_t>(c_buf.shape[0]) - 1;
+    const size_t order = static_cast<size_t>(c_buf.shape[1]) - 1;
+    return HarmonicField(body, degree, order, radius,
+                         static_cast<const double*>(c_buf.ptr),
+                         static_cast<const double*>(s_buf.ptr), pole_ra,
+                         pole_dec, w_0, w_dot, cutoff);
+}
+
+void harmonic_cpp(double_array state, double_array mu,
+                  std::vector<HarmonicField> fields, double t,
+                  double_array out) {
+    auto state_buf = state.request();
+    auto mu_buf = mu.request();
+    auto out_buf = out.request();
+
+    const size_t n = scalar_size<double>(mu_buf);
+    if (scalar_size<double>(state_buf) != 6 * n ||
+        scalar_size<double>(out_buf) != 6 * n) {
+        throw std::runtime_error("state and out must have size 6*n");
+    }
+
+    const HarmonicForce f(n, static_cast<const double*>(mu_buf.ptr),
+                          std::move(fields));
+    f(t, static_cast<const double*>(state_buf.ptr),
+      static_cast<double*>(out_buf.ptr));
+}
+
+double_array rk4_harmonic_cpp(double_array state, double time_step,
+                              size_t steps, double_array mu,
+                              std::vector<HarmonicField> fields, double t0) {
+    auto state_buf = state.request();
+    auto mu_buf = mu.request();
+
+    const size_t n = scalar_size<double>(mu_buf);
+    if (scalar_size<double>(state_buf) != 6 * n) {
+        throw std::runtime_error("state must have size 6*n");
+    }
+
+    const HarmonicForce f(n, static_cast<const double*>(mu_buf.ptr),
+                          std::move(fields));
+    double_array y = empty_trajectory<double>(steps, 6 * n);
+    auto y_buf = y.request();
+    {
+        py::gil_scoped_release release;
+        rk4_propagate(f, static_cast<const double*>(state_buf.ptr), 6 * n,
+                      time_step, steps, static_cast<double*>(y_buf.ptr), t0);
+    }
+    return y;
+}
+
+/* =========================
+   Post-Newtonian kernel
+   ========================= */
+
+void eih_cpp(double_array state, double_array mu, double_array out,
+             double c) {
+    auto state_buf = state.request();
+    auto mu_buf = mu.request();
+    auto out_buf = out.request();
+
+    const size_t n = scalar_size<double>(mu_buf);
+    if (scalar_size<double>(state_buf) != 6 * n ||
+        scalar_size<double>(out_buf) != 6 * n) {
+        throw std::runtime_error("state and out must have size 6*n");
+    }
+
+    EIHKernel kernel(n, c);
+    kernel(static_cast<const double*>(state_buf.ptr),
+           static_cast<const double*>(mu_buf.ptr),
+           static_cast<double*>(out_buf.ptr));
+}
+
+double_array rk4_eih_cpp(double_array state, double time_step, size_t steps,
+                         double_array mu, double c) {
+    auto state_buf = state.request();
+    auto mu_buf = mu.request();
+
+    const size_t n = scalar_size<double>(mu_buf);
+    if (scalar_size<double>(state_buf) != 6 * n) {
+        throw std::runtime_error("state must have size 6*n");
+    }
+
+    const EIHForce f(n, static_cast<const double*>(mu_buf.ptr), c);
+    double_array y = empty_trajectory<double>(steps, 6 * n);
+    auto y_buf = y.request();
+    {
+        py::gil_scoped_release release;
+        rk4_propagate(f, static_cast<const double*>(state_buf.ptr), 6 * n,
+                      time_step, steps, static_cast<double*>(y_buf.ptr));
+    }
+    return y;
+}
+
+/* =========================
+   Trajectory layouts
+   ========================= */
+
+// Transpose a (rows, bodies, state_dim) block into the first `rows` steps
+// of a (bodies, state_dim, tile_steps) tile
+void transpose_tile_cpp(double_array block, double_array tile,
+                        size_t threads) {
+    auto block_buf = block.request();
+    auto tile_buf = tile.request();
+    if (block_buf.ndim != 3 || tile_buf.ndim != 3 ||
+        block_buf.shape[1] != tile_buf.shape[0] ||
+        block_buf.shape[2] != tile_buf.shape[1] ||
+        block_buf.shape[0] > tile_buf.shape[2]) {
+        throw std::runtime_error(
+            "block must be (rows, bodies, state_dim) and tile (bodies, "
+            "state_dim, tile_steps) with rows <= tile_steps");
+    }
+
+    const size_t rows = static_cast<size_t>(block_buf.shape[0]);
+    const size_t cols =
+        static_cast<size_t>(block_buf.shape[1] * block_buf.shape[2]);
+    {
+        py::gil_scoped_release release;
+        transpose_rows(static_cast<const double*>(block_buf.ptr), rows, cols,
+                       static_cast<double*>(tile_buf.ptr),
+                       static_cast<size_t>(tile_buf.shape[2]), threads);
+    }
+}
+
+/* =========================
+   Integrals of motion
+   ========================= */
+
+// Energy, angular and linear momentum and center of mass of every step of a
+// (steps, bodies, state_dim) trajectory into out (steps, 10)
+void integrals_cpp(double_array data, double_array mu, double G,
+                   double_array out, size_t threads) {
+    auto data_buf = data.request();
+    auto mu_buf = mu.request();
+    auto out_buf = out.request();
+
+    const size_t n = scalar_size<double>(mu_buf);
+    if (data_buf.ndim != 3 || static_cast<size_t>(data_buf.shape[1]) != n ||
+        data_buf.shape[2] < 6) {
+        throw std::runtime_error("data must be (steps, n, state_dim >= 6)");
+    }
+    const size_t steps = static_cast<size_t>(data_buf.shape[0]);
+    if (out_buf.ndim != 2 || static_cast<size_t>(out_buf.shape[0]) != steps ||
+        static_cast<size_t>(out_buf.shape[1]) != INTEGRAL_DIM) {
+        throw std::runtime_error("out must be (steps, " +
+                                 std::to_string(INTEGRAL_DIM) + ")");
+    }
+
+    {
+        py::gil_scoped_release release;
+        trajectory_integrals(static_cast<const double*>(data_buf.ptr), steps, n,
+                             static_cast<size_t>(data_buf.shape[2]),
+                             static_cast<const double*>(mu_buf.ptr), G,
+                             static_cast<double*>(out_buf.ptr), threads);
+    }
+}
+
+/* =========================
+   Keplerian elements
+   ========================= */
+
+// Stride of a per-object array of size k or 1 (broadcast)
+size_t broadcast_stride(const py::buffer_info& buf, size_t k,
+                        const std::string& name) {
+    if (buf.ndim == 0 || (buf.ndim == 1 && buf.shape[0] == 1)) {
+        return 0;
+    }
+    if (buf.ndim != 1 || static_cast<size_t>(buf.shape[0]) != k) {
+        throw std::runtime_error(name + " must be a scalar or of size " +
+                                 std::to_string(k));
+    }
+    return 1;
+}
+
+// Cartesian states of elliptic orbits into r and v (k, 3) from elements
+// (k, 6): a, e, i, node, argument of periapsis, mean anomaly, advanced by
+// dt, rotated into the frame and offset by the center state
+void elements_to_states_cpp(double_array elements, double_array mu,
+                            double_array dt, double_array center,
+                            double_array rotation, out_array r, out_array v,
+                            size_t threads) {
+    auto elements_buf = elements.request();
+    auto mu_buf = mu.request();
+    auto dt_buf = dt.request();
+    auto center_buf = center.request();
+    auto rotation_buf = rotation.request();
+    if (!r.writeable() || !v.writeable()) {
+        throw std::runtime_error("r and v must be writeable");
+    }
+    auto r_buf = r.request(true);
+    auto v_buf = v.request(true);
+
+    if (elements_buf.ndim != 2 ||
+        static_cast<size_t>(elements_buf.shape[1]) != ELEMENT_DIM) {
+        throw std::runtime_error("elements must be (k, 6)");
+    }
+    const size_t k = static_cast<size_t>(elements_buf.shape[0]);
+    const size_t mu_stride = broadcast_stride(mu_buf, k, "mu");
+    const size_t dt_stride = broadcast_stride(dt_buf, k, "dt");
+    if (center_buf.size != 6 || rotation_buf.size != 9) {
+        throw std::runtime_error("center must be (6,) and rotation (3, 3)");
+    }
+    for (const py::buffer_info* buf : {&r_buf, &v_buf}) {
+        if (buf->ndim != 2 || static_cast<size_t>(buf->shape[0]) != k ||
+            buf->shape[1] != 3) {
+            throw std::runtime_error("r and v must be (k, 3)");
+        }
+    }
 
-    point_mass_force_kernel(s, n, m, o);
+    {
+        py::gil_scoped_release release;
+        elements_to_states(static_cast<const double*>(elements_buf.ptr),
+                           static_cast<const double*>(mu_buf.ptr), mu_stride,
+                           static_cast<const double*>(dt_buf.ptr), dt_stride,
+                           static_cast<const double*>(center_buf.ptr),
+                           static_cast<const double*>(rotation_buf.ptr), k,
+                           static_cast<double*>(r_buf.ptr),
+                           static_cast<double*>(v_buf.ptr), threads);
+    }
+}
+
+/* =========================
+   Chebyshev ephemeris
+   ========================= */
+
+ChebyshevEphemeris make_ephemeris(index_array first_segment,
+                                  double_array bounds, double_array coeffs) {
+    auto first_buf = first_segment.request();
+    auto bounds_buf = bounds.request();
+    auto coeffs_buf = coeffs.request();
+    if (first_buf.ndim != 1 || first_buf.shape[0] < 1) {
+        throw std::runtime_error("first_segment must be 1D of size bodies + 1");
+    }
+    if (bounds_buf.ndim != 2 || bounds_buf.shape[1] != 2 ||
+        coeffs_buf.ndim != 3 || coeffs_buf.shape[1] != 3 ||
+        coeffs_buf.shape[0] != bounds_buf.shape[0] || coeffs_buf.shape[2] < 1) {
+        throw std::runtime_error(
+            "bounds must be (segments, 2) and coeffs (segments, 3, degree + 1)");
+    }
+
+    const py::ssize_t* f = static_cast<const py::ssize_t*>(first_buf.ptr);
+    std::vector<size_t> first(f, f + first_buf.shape[0]);
+    const double* b = static_cast<const double*>(bounds_buf.ptr);
+    const double* c = static_cast<const double*>(coeffs_buf.ptr);
+    return ChebyshevEphemeris(
+        first.size() - 1, static_cast<size_t>(coeffs_buf.shape[2]) - 1,
+        std::move(first), std::vector<double>(b, b + bounds_buf.size),
+        std::vector<double>(c, c + coeffs_buf.size));
+}
+
+// Validate (times, bodies) query arrays and evaluate them without the GIL
+template <typename Ephemeris>
+double_array evaluate_queries(const Ephemeris& self, double_array times,
+                              index_array bodies, size_t threads) {
+    auto times_buf = times.request();
+    auto bodies_buf = bodies.request();
+    if (times_buf.ndim != 1 || bodies_buf.ndim != 1 ||
+        times_buf.shape[0] != bodies_buf.shape[0]) {
+        throw std::runtime_error("times and bodies must be 1D of equal size");
+    }
+
+    const size_t k = static_cast<size_t>(times_buf.shape[0]);
+    const py::ssize_t* b = static_cast<const py::ssize_t*>(bodies_buf.ptr);
+    std::vector<size_t> body(k);
+    for (size_t i = 0; i < k; ++i) {
+        if (b[i] < 0) {
+            throw std::runtime_error("body index out of range");
+        }
+        body[i] = static_cast<size_t>(b[i]);
+    }
+
+    double_array out = empty_trajectory<double>(k, 6);
+    auto out_buf = out.request();
+    {
+        py::gil_scoped_release release;
+        self.evaluate(body.data(), static_cast<const double*>(times_buf.ptr),
+                      k, static_cast<double*>(out_buf.ptr), threads);
+    }
+    return out;
+}
+
+// Keeps the (possibly memory-mapped) arrays alive next to the borrowing view
+struct HermiteSource {
+    double_array data;
+    std::optional<double_array> times;
+    HermiteTrajectory trajectory;
+
+    size_t steps() const { return trajectory.steps(); }
+    size_t bodies() const { return trajectory.bodies(); }
+};
+
+HermiteSource make_hermite(double_array data, double time_step,
+                           std::optional<double_array> times) {
+    auto data_buf = data.request();
+    if (data_buf.ndim != 3 || data_buf.shape[2] != 6) {
+        throw std::runtime_error("data must be (steps, bodies, 6)");
+    }
+    const size_t steps = static_cast<size_t>(data_buf.shape[0]);
+    const double* t = nullptr;
+    if (times) {
+        auto times_buf = times->request();
+        if (times_buf.ndim != 1 ||
+            static_cast<size_t>(times_buf.shape[0]) != steps) {
+            throw std::runtime_error("times must be 1D of size steps");
+        }
+        t = static_cast<const double*>(times_buf.ptr);
+    }
+    HermiteTrajectory trajectory(static_cast<const double*>(data_buf.ptr),
+                                 steps,
+                                 static_cast<size_t>(data_buf.shape[1]),
+                                 time_step, t);
+    return {std::move(data), std::move(times), trajectory};
+}
+
+double_array hermite_evaluate(const HermiteSource& self, double_array times,
+                              index_array bodies, size_t threads) {
+    return evaluate_queries(self.trajectory, std::move(times),
+                            std::move(bodies), threads);
+}
+
+/* =========================
+   Memory-mapped simstate
+   ========================= */
+
+// One axis of a view: an int keeps the axis with length 1, like _RVView
+struct AxisRange {
+    py::ssize_t start;
+    py::ssize_t count;
+    py::ssize_t step;
+};
+
+// False for keys that are not a strided view (index arrays, masks)
+bool parse_axis(py::handle key, size_t length, AxisRange& out) {
+    const py::ssize_t n = static_cast<py::ssize_t>(length);
+    if (py::isinstance<py::slice>(key)) {
+        py::ssize_t start, stop, step, count;
+        if (!py::reinterpret_borrow<py::slice>(key).compute(
+                n, &start, &stop, &step, &count)) {
+            throw py::error_already_set();
+        }
+        out = {start, count, step};
+        return true;
+    }
+    if (py::isinstance<py::int_>(key)) {
+        py::ssize_t i = key.cast<py::ssize_t>();
+        if (i < 0) {
+            i += n;
+        }
+        if (i < 0 || i >= n) {
+            throw py::index_error("index " + std::to_string(i) +
+                                  " out of range");
+        }
+        out = {i, 1, 1};
+        return true;
+    }
+    return false;
+}
+
+// Read-only array over the mapping, alive as long as `owner` (the reader)
+py::array mapped_view(py::handle owner, const double* ptr,
+                      std::vector<py::ssize_t> shape,
+                      std::vector<py::ssize_t> strides) {
+    py::array view(py::dtype::of<double>(), std::move(shape),
+                   std::move(strides), ptr, owner);
+    view.attr("flags").attr("writeable") = false;
+    return view;
+}
+
+py::buffer_info reader_buffer(SimstateReader& self) {
+    const py::ssize_t item = sizeof(double);
+    const py::ssize_t dim = static_cast<py::ssize_t>(self.state_dim());
+    const py::ssize_t bodies = static_cast<py::ssize_t>(self.bodies());
+    return py::buffer_info(
+        const_cast<double*>(self.data()), item,
+        py::format_descriptor<double>::format(), 3,
+        {static_cast<py::ssize_t>(self.steps()), bodies, dim},
+        {bodies * dim * item, dim * item, item}, true);
+}
+
+py::object reader_times(py::object self_obj) {
+    const SimstateReader& self = self_obj.cast<const SimstateReader&>();
+    if (self.times() == nullptr) {
+        return py::none();
+    }
+    return mapped_view(self_obj, self.times(),
+                       {static_cast<py::ssize_t>(self.steps())},
+                       {static_cast<py::ssize_t>(sizeof(double))});
+}
+
+// Positions (or velocities) of sim.r[key], (steps, bodies, 3), or of
+// sim.r_vis[key], (steps, 3, bodies), for key = step or (step, body) with
+// ints and slices; None for other keys
+py::object reader_rv(py::object self_obj, py::object key, bool velocity,
+                     bool vis) {
+    const SimstateReader& self = self_obj.cast<const SimstateReader&>();
+    py::handle step_key = key;
+    AxisRange b{0, static_cast<py::ssize_t>(self.bodies()), 1};
+    if (py::isinstance<py::tuple>(key)) {
+        py::tuple t = py::reinterpret_borrow<py::tuple>(key);
+        if (t.size() < 1 || t.size() > 2) {
+            return py::none();
+        }
+        step_key = t[0];
+        if (t.size() == 2 && !parse_axis(t[1], self.bodies(), b)) {
+            return py::none();
+        }
+    }
+    AxisRange s;
+    if (!parse_axis(step_key, self.steps(), s)) {
+        return py::none();
+    }
+
+    const py::ssize_t item = sizeof(double);
+    const py::ssize_t dim = static_cast<py::ssize_t>(self.state_dim());
+    const py::ssize_t row = static_cast<py::ssize_t>(self.bodies()) * dim;
+    const double* ptr =
+        self.data() + s.start * row + b.start * dim + (velocity ? 3 : 0);
+    if (vis) {
+        return mapped_view(self_obj, ptr, {s.count, 3, b.count},
+                           {s.step * row * item, item, b.step * dim * item});
+    }
+    return mapped_view(self_obj, ptr, {s.count, b.count, 3},
+                       {s.step * row * item, b.step * dim * item, item});
+}
+
+// Step at or before each time, shaped like `times`
+py::array_t<int64_t> reader_steps_at(const SimstateReader& self,
+                                     double_array times) {
+    auto times_buf = times.request();
+    py::array_t<int64_t> out(times_buf.shape);
+    auto out_buf = out.request();
+    {
+        py::gil_scoped_release release;
+        self.steps_at(static_cast<const double*>(times_buf.ptr),
+                      static_cast<size_t>(times_buf.size),
+                      static_cast<int64_t*>(out_buf.ptr));
+    }
+    return out;
+}
+
+void reader_advise(const SimstateReader& self, const std::string& pattern,
+                   size_t start, std::optional<size_t> stop) {
+    Advice advice;
+    if (pattern == "normal") {
+        advice = Advice::NORMAL;
+    } else if (pattern == "sequential") {
+        advice = Advice::SEQUENTIAL;
+    } else if (pattern == "random") {
+        advice = Advice::RANDOM;
+    } else if (pattern == "willneed") {
+        advice = Advice::WILLNEED;
+    } else if (pattern == "dontneed") {
+        advice = Advice::DONTNEED;
+    } else {
+        throw std::runtime_error("unknown access pattern " + pattern);
+    }
+    const size_t end = stop.value_or(self.steps());
+    if (start > end || end > self.steps()) {
+        throw py::index_error("steps [" + std::to_string(start) + ", " +
+                              std::to_string(end) + ") out of range for " +
+                              std::to_string(self.steps()) + " steps");
+    }
+    self.advise(start, end, advice);
+}
+
+/* =========================
+   Streaming to file
+   ========================= */
+
+py::dict rk4_simstate_cpp(double_array state, double time_step, size_t steps,
+                          double_array mu, const std::string& filename,
+                          py::bytes header, size_t buffer_steps,
+                          bool direct_io, bool overlap,
+                          const std::string& integrals_filename,
+                          py::bytes integrals_header, size_t integrals_every,
+                          double G) {
+    auto state_buf = state.request();
+    auto mu_buf = mu.request();
+
+    const size_t n = scalar_size<double>(mu_buf);
+    if (scalar_size<double>(state_buf) != 6 * n) {
+        throw std::runtime_error("state must have size 6*n");
+    }
+    if (buffer_steps == 0) {
+        throw std::runtime_error("buffer_steps must be positive");
+    }
+
+    const std::string head = header;
+    const std::string integrals_head = integrals_header;
+    const MonitoredPointMassForce f{n, static_cast<const double*>(mu_buf.ptr)};
+    RK4Stepper<double> stepper(6 * n);
+    WriterStats stats;
+    {
+        py::gil_scoped_release release;
+        if (integrals_filename.empty()) {
+            stats = propagate_to_file(
+                stepper, f, static_cast<const double*>(state_buf.ptr), n,
+                time_step, steps, filename, head.data(), head.size(),
+                buffer_steps, direct_io, overlap);
+        } else {
+            IntegralMonitor monitor(f, G, integrals_every, integrals_filename,
+                                    integrals_head.data(),
+                                    integrals_head.size(), buffer_steps);
+            stats = propagate_to_file(
+                stepper, f, static_cast<const double*>(state_buf.ptr), n,
+                time_step, steps, filename, head.data(), head.size(),
+                buffer_steps, direct_io, overlap, &monitor);
+        }
+    }
+
+    py::dict out;
+    out["steps"] = stats.steps;
+    out["seconds"] = stats.seconds;
+    out["steps_per_second"] =
+        stats.seconds > 0.0 ? static_cast<double>(stats.steps) / stats.seconds
+                            : 0.0;
+    out["write_seconds"] = stats.write_seconds;
+    out["stall_seconds"] = stats.stall_seconds;
+    return out;
 }
 
 /* =========================
    Module definition
    ========================= */
 
+template <typename T>
+void def_point_mass(py::module_& m, const std::string& suffix) {
+    m.def(("point_mass_cpp" + suffix).c_str(), &point_mass_cpp<T>,
+          py::arg("state"), py::arg("mu"), py::arg("out"));
+    m.def(("euler_cpp" + suffix).c_str(), &euler_cpp<T>, py::arg("state"),
+          py::arg("time_step"), py::arg("steps"), py::arg("mu"));
+    m.def(("rk4_cpp" + suffix).c_str(), &rk4_cpp<T>, py::arg("state"),
+          py::arg("time_step"), py::arg("steps"), py::arg("mu"));
+    m.def(("leapfrog_cpp" + suffix).c_str(), &leapfrog_cpp<T>,
+          py::arg("state"), py::arg("time_step"), py::arg("steps"),
+          py::arg("mu"));
+}
+
 PYBIND11_MODULE(_cpp_force_kernel, m) {
     m.doc() = "C++ point-mass N-body gravity module (symmetric, fast)";
 
-    m.def("point_mass_cpp", &point_mass_cpp, py::arg("state"), py::arg("mu"),
-          py::arg("out"));
+    def_point_mass<double>(m, "");
+    def_point_mass<float>(m, "_f32");
+    def_point_mass<DoubleDouble>(m, "_dd");
+    def_point_mass<Dual<double>>(m, "_dual");
+
+    m.def("point_mass_gradient_cpp", &point_mass_gradient_cpp,
+          py::arg("state"), py::arg("mu"), py::arg("bodies"), py::arg("out"),
+          py::arg("grad"));
+    m.def("stm_rk4_cpp", &stm_rk4_cpp, py::arg("state"), py::arg("time_step"),
+          py::arg("steps"), py::arg("mu"), py::arg("bodies"),
+          py::arg("stride") = 1);
+
+    py::class_<HarmonicField>(m, "HarmonicField")
+        .def(py::init(&make_field), py::arg("body"), py::arg("radius"),
+             py::arg("c"), py::arg("s"), py::arg("pole_ra") = 0.0,
+             py::arg("pole_dec") = std::numbers::pi / 2, py::arg("w_0") = 0.0,
+             py::arg("w_dot") = 0.0,
+             py::arg("cutoff") = std::numeric_limits<double>::infinity())
+        .def_property_readonly("body", &HarmonicField::body)
+        .def_property_readonly("degree", &HarmonicField::degree)
+        .def_property_readonly("order", &HarmonicField::order);
+    m.def("harmonic_cpp", &harmonic_cpp, py::arg("state"), py::arg("mu"),
+          py::arg("fields"), py::arg("t"), py::arg("out"));
+    m.def("rk4_harmonic_cpp", &rk4_harmonic_cpp, py::arg("state"),
+          py::arg("time_step"), py::arg("steps"), py::arg("mu"),
+          py::arg("fields"), py::arg("t0") = 0.0);
+
+    m.attr("SPEED_OF_LIGHT") = SPEED_OF_LIGHT;
+    m.def("eih_cpp", &eih_cpp, py::arg("state"), py::arg("mu"), py::arg("out"),
+          py::arg("c") = SPEED_OF_LIGHT);
+    m.def("rk4_eih_cpp", &rk4_eih_cpp, py::arg("state"), py::arg("time_step"),
+          py::arg("steps"), py::arg("mu"), py::arg("c") = SPEED_OF_LIGHT);
+
+    m.def("rk4_simstate_cpp", &rk4_simstate_cpp, py::arg("state"),
+          py::arg("time_step"), py::arg("steps"), py::arg("mu"),
+          py::arg("filename"), py::arg("header"),
+          py::arg("buffer_steps") = 10000, py::arg("direct_io") = false,
+          py::arg("overlap") = true, py::arg("integrals_filename") = "",
+          py::arg("integrals_header") = py::bytes(),
+          py::arg("integrals_every") = 1, py::arg("G") = GRAVITATIONAL_CONSTANT);
+
+    m.def("transpose_tile_cpp", &transpose_tile_cpp, py::arg("block"),
+          py::arg("tile"), py::arg("threads") = 0);
+
+    m.def("integrals_cpp", &integrals_cpp, py::arg("data"), py::arg("mu"),
+          py::arg("G"), py::arg("out"), py::arg("threads") = 0);
+
+    m.def("elements_to_states_cpp", &elements_to_states_cpp,
+          py::arg("elements"), py::arg("mu"), py::arg("dt"), py::arg("center"),
+          py::arg("rotation"), py::arg("r").noconvert(),
+          py::arg("v").noconvert(), py::arg("threads") = 0);
+
+    py::class_<ChebyshevEphemeris>(m, "ChebyshevEphemeris")
+        .def(py::init(&make_ephemeris), py::arg("first_segment"),
+             py::arg("bounds"), py::arg("coeffs"))
+        .def("evaluate", &evaluate_queries<ChebyshevEphemeris>,
+             py::arg("times"), py::arg("bodies"), py::arg("threads") = 0)
+        .def_property_readonly("bodies", &ChebyshevEphemeris::bodies)
+        .def_property_readonly("degree", &ChebyshevEphemeris::degree)
+        .def_property_readonly("segments", &ChebyshevEphemeris::segments);
+
+    py::class_<HermiteSource>(m, "HermiteTrajectory")
+        .def(py::init(&make_hermite), py::arg("data"), py::arg("time_step"),
+             py::arg("times") = py::none())
+        .def("evaluate", &hermite_evaluate, py::arg("times"),
+             py::arg("bodies"), py::arg("threads") = 0)
+        .def_property_readonly("steps", &HermiteSource::steps)
+        .def_property_readonly("bodies", &HermiteSource::bodies);
+
+    py::class_<SimstateReader>(m, "SimstateReader", py::buffer_protocol())
+        .def(py::init<const std::string&>(), py::arg("filename"))
+        .def_buffer(&reader_buffer)
+        .def("times", &reader_times)
+        .def("rv", &reader_rv, py::arg("key"), py::arg("velocity") = false,
+             py::arg("vis") = false)
+        .def("steps_at", &reader_steps_at, py::arg("times"))
+        .def("advise", &reader_advise, py::arg("pattern"),
+             py::arg("start") = 0, py::arg("stop") = py::none())
+        .def_property_readonly("steps", &SimstateReader::steps)
+        .def_property_readonly("bodies", &SimstateReader::bodies)
+        .def_property_readonly("state_dim", &SimstateReader::state_dim)
+        .def_property_readonly("dt", &SimstateReader::dt);
+
+    py::class_<PointMassAdjoint>(m, "PointMassAdjoint")
+        .def(py::init(&make_adjoint), py::arg("mu"), py::arg("time_step"),
+             py::arg("steps"), py::arg("scheme") = "rk4",
+             py::arg("checkpoint_every") = 0)
+        .def("forward", &adjoint_forward, py::arg("state"), py::arg("samples"))
+        .def("backward", &adjoint_backward, py::arg("cotangents"))
+        .def_property_readonly("checkpoint_every",
+                               &PointMassAdjoint::checkpoint_every);
 }
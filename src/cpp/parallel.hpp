@@ -0,0 +1,62 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+/* =========================
+   Parallel loops
+   ========================= */
+
+// Number of worker threads for `requested` (0: hardware concurrency)
+inline size_t thread_count(size_t requested) {
+    if (requested > 0) {
+        return requested;
+    }
+    const unsigned hardware = std::thread::hardware_concurrency();
+    return hardware > 0 ? hardware : 1;
+}
+
+// Call fn(begin, end) on contiguous blocks of [0, k), one per thread, with
+// at least `grain` items per block; small loops stay on the calling thread.
+// The first exception thrown by a block is rethrown after all have joined.
+template <typename F>
+void parallel_for(size_t k, size_t threads, size_t grain, const F& fn) {
+    const size_t blocks =
+        std::min(thread_count(threads), std::max<size_t>(1, k / grain));
+    if (blocks <= 1) {
+        fn(size_t{0}, k);
+        return;
+    }
+
+    std::vector<std::exception_ptr> errors(blocks);
+    std::vector<std::thread> pool;
+    pool.reserve(blocks - 1);
+    auto run = [&](size_t b) {
+        try {
+            fn(k * b / blocks, k * (b + 1) / blocks);
+        } catch (...) {
+            errors[b] = std::current_exception();
+        }
+    };
+    for (size_t b = 1; b < blocks; ++b) {
+        pool.emplace_back(run, b);
+    }
+    run(0);
+    for (std::thread& t : pool) {
+        t.join();
+    }
+    for (const std::exception_ptr& e : errors) {
+        if (e) {
+            std::rethrow_exception(e);
+        }
+    }
+}
@@ -0,0 +1,273 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define READER_POSIX 1
+#else
+#include <fstream>
+#endif
+
+/* =========================
+   Mapped file
+   ========================= */
+
+enum class Advice { NORMAL, SEQUENTIAL, RANDOM, WILLNEED, DONTNEED };
+
+// Read-only view of a whole file. On POSIX the file is memory-mapped and
+// access-pattern hints go to madvise; elsewhere it is read once into memory
+// and hints are ignored.
+class MappedFile {
+   public:
+    explicit MappedFile(const std::string& path) {
+#ifdef READER_POSIX
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("cannot open " + path);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("cannot stat " + path);
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ > 0) {
+            void* map = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+            if (map == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("cannot map " + path);
+            }
+            data_ = static_cast<const char*>(map);
+        }
+        ::close(fd);  // the mapping keeps the file referenced
+#else
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in) {
+            throw std::runtime_error("cannot open " + path);
+        }
+        size_ = static_cast<size_t>(in.tellg());
+        buffer_.resize((size_ + sizeof(double) - 1) / sizeof(double));
+        in.seekg(0);
+        in.read(reinterpret_cast<char*>(buffer_.data()),
+                static_cast<std::streamsize>(size_));
+        data_ = reinterpret_cast<const char*>(buffer_.data());
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+#ifdef READER_POSIX
+        if (data_ != nullptr) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+#endif
+    }
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+    // Hint the access pattern of bytes [offset, offset + length)
+    void advise(size_t offset, size_t length, Advice advice) const {
+#ifdef READER_POSIX
+        if (data_ == nullptr || offset >= size_) {
+            return;
+        }
+        const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        const size_t begin = offset - offset % page;
+        const size_t end = std::min(size_, offset + length);
+        const int flags[] = {MADV_NORMAL, MADV_SEQUENTIAL, MADV_RANDOM,
+                             MADV_WILLNEED, MADV_DONTNEED};
+        // Advice is only a hint: failures are not errors
+        ::madvise(const_cast<char*>(data_) + begin, end - begin,
+                  flags[static_cast<int>(advice)]);
+#else
+        (void)offset;
+        (void)length;
+        (void)advice;
+#endif
+    }
+
+   private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+#ifndef READER_POSIX
+    std::vector<double> buffer_;  // double storage keeps the rows aligned
+#endif
+};
+
+/* =========================
+   Time index
+   ========================= */
+
+// Every TIME_INDEX_STRIDE-th time of a column, one page of the column per
+// entry (8 KiB of index per million steps)
+constexpr size_t TIME_INDEX_STRIDE = 512;
+
+// Step lookup in the sorted time column of a variable-step file. The
+// coarse index is searched first, so the search of the column itself stays
+// within one block of it: a page or two of the mapping instead of one page
+// per bisection step.
+class TimeIndex {
+   public:
+    TimeIndex(const double* times, size_t steps,
+              size_t stride = TIME_INDEX_STRIDE)
+        : times_(times), steps_(steps), stride_(stride) {
+        if (stride_ == 0) {
+            throw std::runtime_error("stride must be positive");
+        }
+        coarse_.reserve((steps_ + stride_ - 1) / stride_);
+        for (size_t i = 0; i < steps_; i += stride_) {
+            coarse_.push_back(times_[i]);
+        }
+    }
+
+    // Last step whose time is <= t, 0 before the first step
+    size_t step_at(double t) const {
+        const auto block = std::upper_bound(coarse_.begin(), coarse_.end(), t);
+        if (block == coarse_.begin()) {
+            return 0;
+        }
+        const size_t first = (block - coarse_.begin() - 1) * stride_;
+        const double* last = times_ + std::min(first + stride_, steps_);
+        return std::upper_bound(times_ + first, last, t) - times_ - 1;
+    }
+
+   private:
+    const double* times_;
+    size_t steps_;
+    size_t stride_;
+    std::vector<double> coarse_;
+};
+
+/* =========================
+   Simstate reader
+   ========================= */
+
+// Header layout of an uncompressed (v1) .simstate file, little-endian and
+// packed: magic (8), version (u32), steps (u64), bodies (u32), state_dim
+// (u32), dt (f64), padding up to SIMSTATE_HEADER_SIZE. Rows of
+// (bodies, state_dim) float64 follow, then a time column when dt < 0.
+constexpr size_t SIMSTATE_HEADER_SIZE = 64;
+constexpr char SIMSTATE_MAGIC[] = "SIMSTATE";
+constexpr uint32_t SIMSTATE_VERSION = 1;
+
+// Maps a v1 .simstate file once and validates it; the trajectory is then
+// addressed in place. Compressed (v2) and tiled (v3) files are rejected:
+// their rows are not a single strided array.
+class SimstateReader {
+   public:
+    explicit SimstateReader(const std::string& path) : file_(path) {
+        const char* p = file_.data();
+        if (file_.size() < SIMSTATE_HEADER_SIZE ||
+            std::memcmp(p, SIMSTATE_MAGIC, 8) != 0) {
+            throw std::runtime_error("Not a SIMSTATE file");
+        }
+        uint32_t version, bodies, state_dim;
+        uint64_t steps;
+        std::memcpy(&version, p + 8, 4);
+        std::memcpy(&steps, p + 12, 8);
+        std::memcpy(&bodies, p + 20, 4);
+        std::memcpy(&state_dim, p + 24, 4);
+        std::memcpy(&dt_, p + 28, 8);
+        if (version != SIMSTATE_VERSION) {
+            throw std::runtime_error("File version " + std::to_string(version) +
+                                     " cannot be mapped, expected " +
+                                     std::to_string(SIMSTATE_VERSION));
+        }
+        steps_ = steps;
+        bodies_ = bodies;
+        state_dim_ = state_dim;
+
+        // Compared by division: steps times the step size of a corrupt
+        // header can overflow
+        const size_t step_bytes =
+            row_bytes() + (dt_ < 0 ? sizeof(double) : 0);
+        const size_t available = file_.size() - SIMSTATE_HEADER_SIZE;
+        if (step_bytes != 0 && steps_ > available / step_bytes) {
+            throw std::runtime_error(
+                "truncated file: " + std::to_string(available) +
+                " bytes of data cannot hold " + std::to_string(steps_) +
+                " steps of " + std::to_string(step_bytes) + " bytes");
+        }
+    }
+
+    size_t steps() const { return steps_; }
+    size_t bodies() const { return bodies_; }
+    size_t state_dim() const { return state_dim_; }
+    double dt() const { return dt_; }
+    size_t row_bytes() const { return bodies_ * state_dim_ * sizeof(double); }
+
+    // Row-major (steps, bodies, state_dim)
+    const double* data() const {
+        return reinterpret_cast<const double*>(file_.data() +
+                                               SIMSTATE_HEADER_SIZE);
+    }
+
+    // Time column of variable-step files (dt < 0), else nullptr
+    const double* times() const {
+        return dt_ < 0 ? data() + steps_ * bodies_ * state_dim_ : nullptr;
+    }
+
+    // Step at or before each of the `count` times `t` (clamped to the
+    // file): floor(t / dt) for fixed steps, a search of the time column
+    // for variable steps, its index built on the first query
+    void steps_at(const double* t, size_t count, int64_t* out) const {
+        const int64_t last = static_cast<int64_t>(steps_) - 1;
+        if (dt_ >= 0) {
+            for (size_t i = 0; i < count; ++i) {
+                const double step = dt_ > 0 ? std::floor(t[i] / dt_) : 0.0;
+                out[i] = !(step > 0) ? 0
+                         : step >= static_cast<double>(last)
+                             ? last
+                             : static_cast<int64_t>(step);
+            }
+            return;
+        }
+        std::call_once(index_once_, [this] {
+            index_ = std::make_unique<TimeIndex>(times(), steps_);
+        });
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = static_cast<int64_t>(index_->step_at(t[i]));
+        }
+    }
+
+    // Hint the access pattern of steps [start, stop)
+    void advise(size_t start, size_t stop, Advice advice) const {
+        stop = std::min(stop, steps_);
+        if (start >= stop) {
+            return;
+        }
+        file_.advise(SIMSTATE_HEADER_SIZE + start * row_bytes(),
+                     (stop - start) * row_bytes(), advice);
+    }
+
+   private:
+    MappedFile file_;
+    size_t steps_;
+    size_t bodies_;
+    size_t state_dim_;
+    double dt_;
+    mutable std::once_flag index_once_;
+    mutable std::unique_ptr<TimeIndex> index_;
+};
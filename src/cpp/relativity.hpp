@@ -0,0 +1,173 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+/* =========================
+   EIH (1PN) kernel
+   ========================= */
+
+constexpr double SPEED_OF_LIGHT = 299792458.0;  // [m/s]
+
+// Einstein-Infeld-Hoffmann point-mass accelerations (first post-Newtonian
+// order, isotropic PPN with beta = gamma = 1), as used for the planetary
+// ephemerides:
+//
+//   a_i = sum_j mu_j (r_j - r_i) / r^3 [1 - 4 phi_i/c^2 - phi_j/c^2
+//           + v_i^2/c^2 + 2 v_j^2/c^2 - 4 v_i.v_j/c^2
+//           - 3/(2c^2) ((r_i - r_j).v_j / r)^2 + (r_j - r_i).a_j / (2c^2)]
+//       + sum_j mu_j / (c^2 r^3) ((r_i - r_j).(4 v_i - 3 v_j)) (v_i - v_j)
+//       + 7/(2c^2) sum_j mu_j a_j / r
+//
+// with phi_i = sum_k mu_k / r_ik and a_j the Newtonian acceleration. The
+// bracket needs every body's phi and a_j, so the traversal is split: the
+// Newtonian pair loop also accumulates phi and caches each pair's
+// separation and 1/r, and the correction loop reuses them without another
+// sqrt. Both loops visit each pair once and update i and j symmetrically.
+class EIHKernel {
+   public:
+    explicit EIHKernel(size_t n, double c = SPEED_OF_LIGHT)
+        : n_(n),
+          inv_c2_(1.0 / (c * c)),
+          phi_(n),
+          a_newton_(3 * n),
+          pair_(4 * (n * (n - 1) / 2)) {}
+
+    void operator()(const double* __restrict__ state,  // size: 6*n
+                    const double* __restrict__ mu,     // size: n
+                    double* __restrict__ out            // size: 6*n
+    ) {
+        const size_t vel_offset = 3 * n_;
+        const double* v = state + vel_offset;
+        double* a = a_newton_.data();
+        double* phi = phi_.data();
+
+        for (size_t k = 0; k < vel_offset; ++k) {
+            out[k] = v[k];
+            a[k] = 0.0;
+        }
+        for (size_t k = 0; k < n_; ++k) {
+            phi[k] = 0.0;
+        }
+
+        // Newtonian pass: accelerations, potentials and the pair cache
+        double* p = pair_.data();
+        for (size_t i = 0; i < n_; ++i) {
+            const double xi = state[3 * i];
+            const double yi = state[3 * i + 1];
+            const double zi = state[3 * i + 2];
+            const double mi = mu[i];
+
+            for (size_t j = i + 1; j < n_; ++j, p += 4) {
+                const double dx = xi - state[3 * j];
+                const double dy = yi - state[3 * j + 1];
+                const double dz = zi - state[3 * j + 2];
+
+                const double r2 = dx * dx + dy * dy + dz * dz;
+                const double inv_r = 1.0 / std::sqrt(r2);
+                const double inv_r3 = inv_r * inv_r * inv_r;
+                const double mj = mu[j];
+
+                a[3 * i] -= mj * dx * inv_r3;
+                a[3 * i + 1] -= mj * dy * inv_r3;
+                a[3 * i + 2] -= mj * dz * inv_r3;
+
+                a[3 * j] += mi * dx * inv_r3;
+                a[3 * j + 1] += mi * dy * inv_r3;
+                a[3 * j + 2] += mi * dz * inv_r3;
+
+                phi[i] += mj * inv_r;
+                phi[j] += mi * inv_r;
+
+                p[0] = dx;
+                p[1] = dy;
+                p[2] = dz;
+                p[3] = inv_r;
+            }
+        }
+
+        double* acc = out + vel_offset;
+        for (size_t k = 0; k < vel_offset; ++k) {
+            acc[k] = a[k];
+        }
+
+        // 1PN correction pass over the cached pairs
+        const double c2 = inv_c2_;
+        p = pair_.data();
+        for (size_t i = 0; i < n_; ++i) {
+            const double* vi = v + 3 * i;
+            const double* ai = a + 3 * i;
+            const double vi2 = vi[0] * vi[0] + vi[1] * vi[1] + vi[2] * vi[2];
+            const double mi = mu[i];
+
+            for (size_t j = i + 1; j < n_; ++j, p += 4) {
+                const double* vj = v + 3 * j;
+                const double* aj = a + 3 * j;
+                const double dx = p[0], dy = p[1], dz = p[2];
+                const double inv_r = p[3];
+                const double inv_r3 = inv_r * inv_r * inv_r;
+                const double mj = mu[j];
+
+                const double vj2 = vj[0] * vj[0] + vj[1] * vj[1] + vj[2] * vj[2];
+                const double vivj = vi[0] * vj[0] + vi[1] * vj[1] + vi[2] * vj[2];
+
+                // d = r_i - r_j, so r_j - r_i = -d
+                const double d_vi = dx * vi[0] + dy * vi[1] + dz * vi[2];
+                const double d_vj = dx * vj[0] + dy * vj[1] + dz * vj[2];
+                const double d_ai = dx * ai[0] + dy * ai[1] + dz * ai[2];
+                const double d_aj = dx * aj[0] + dy * aj[1] + dz * aj[2];
+
+                const double common = -4.0 * vivj;
+                const double bracket_i =
+                    c2 * (-4.0 * phi[i] - phi[j] + vi2 + 2.0 * vj2 + common -
+                          1.5 * d_vj * d_vj * inv_r * inv_r - 0.5 * d_aj);
+                const double bracket_j =
+                    c2 * (-4.0 * phi[j] - phi[i] + vj2 + 2.0 * vi2 + common -
+                          1.5 * d_vi * d_vi * inv_r * inv_r + 0.5 * d_ai);
+
+                // (r_i - r_j).(4 v_i - 3 v_j) and (r_j - r_i).(4 v_j - 3 v_i)
+                const double s_i = c2 * inv_r3 * (4.0 * d_vi - 3.0 * d_vj);
+                const double s_j = c2 * inv_r3 * (3.0 * d_vi - 4.0 * d_vj);
+                const double tail = 3.5 * c2 * inv_r;
+
+                double* acc_i = acc + 3 * i;
+                double* acc_j = acc + 3 * j;
+                const double d[3] = {dx, dy, dz};
+                for (size_t c = 0; c < 3; ++c) {
+                    const double dv = vi[c] - vj[c];
+                    acc_i[c] += mj * (-d[c] * inv_r3 * bracket_i + s_i * dv +
+                                      tail * aj[c]);
+                    acc_j[c] += mi * (d[c] * inv_r3 * bracket_j - s_j * dv +
+                                      tail * ai[c]);
+                }
+            }
+        }
+    }
+
+   private:
+    size_t n_;
+    double inv_c2_;
+    std::vector<double> phi_;
+    std::vector<double> a_newton_;
+    std::vector<double> pair_;  // per pair: dx, dy, dz, 1/r
+};
+
+// Binds mu so the kernel fits the integrators' f(t, y, dy) signature
+struct EIHForce {
+    const double* mu;
+    mutable EIHKernel kernel;
+
+    EIHForce(size_t n, const double* mu_, double c = SPEED_OF_LIGHT)
+        : mu(mu_), kernel(n, c) {}
+
+    void operator()(double /*t*/, const double* y, double* dy) const {
+        kernel(y, mu, dy);
+    }
+};
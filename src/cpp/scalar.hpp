@@ -0,0 +1,186 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+/* =========================
+   Double-double scalar
+   ========================= */
+
+// Unevaluated sum hi + lo with |lo| <= ulp(hi) / 2, giving ~106 bits of
+// mantissa. The error-free transformations below rely on strict IEEE
+// semantics: translation units instantiating kernels on this type must be
+// compiled without -ffast-math (see double_double.cpp).
+struct DoubleDouble {
+    double hi = 0.0;
+    double lo = 0.0;
+
+    constexpr DoubleDouble() = default;
+    constexpr DoubleDouble(double x) : hi(x), lo(0.0) {}
+    constexpr DoubleDouble(double h, double l) : hi(h), lo(l) {}
+
+    explicit operator double() const { return hi + lo; }
+};
+
+namespace dd_detail {
+
+inline DoubleDouble quick_two_sum(double a, double b) {
+    const double s = a + b;
+    return {s, b - (s - a)};
+}
+
+inline DoubleDouble two_sum(double a, double b) {
+    const double s = a + b;
+    const double bb = s - a;
+    return {s, (a - (s - bb)) + (b - bb)};
+}
+
+inline DoubleDouble two_prod(double a, double b) {
+    const double p = a * b;
+    return {p, std::fma(a, b, -p)};
+}
+
+}  // namespace dd_detail
+
+inline DoubleDouble operator+(DoubleDouble a, DoubleDouble b) {
+    DoubleDouble s = dd_detail::two_sum(a.hi, b.hi);
+    const DoubleDouble t = dd_detail::two_sum(a.lo, b.lo);
+    s.lo += t.hi;
+    s = dd_detail::quick_two_sum(s.hi, s.lo);
+    s.lo += t.lo;
+    return dd_detail::quick_two_sum(s.hi, s.lo);
+}
+
+inline DoubleDouble operator-(DoubleDouble a) { return {-a.hi, -a.lo}; }
+
+inline DoubleDouble operator-(DoubleDouble a, DoubleDouble b) {
+    return a + (-b);
+}
+
+inline DoubleDouble operator*(DoubleDouble a, DoubleDouble b) {
+    DoubleDouble p = dd_detail::two_prod(a.hi, b.hi);
+    p.lo += a.hi * b.lo + a.lo * b.hi;
+    return dd_detail::quick_two_sum(p.hi, p.lo);
+}
+
+inline DoubleDouble operator/(DoubleDouble a, DoubleDouble b) {
+    // Two rounds of long division
+    const double q1 = a.hi / b.hi;
+    DoubleDouble r = a - b * DoubleDouble(q1);
+    const double q2 = r.hi / b.hi;
+    r = r - b * DoubleDouble(q2);
+    const double q3 = r.hi / b.hi;
+    return dd_detail::quick_two_sum(q1, q2) + DoubleDouble(q3);
+}
+
+inline DoubleDouble& operator+=(DoubleDouble& a, DoubleDouble b) {
+    return a = a + b;
+}
+inline DoubleDouble& operator-=(DoubleDouble& a, DoubleDouble b) {
+    return a = a - b;
+}
+inline DoubleDouble& operator*=(DoubleDouble& a, DoubleDouble b) {
+    return a = a * b;
+}
+
+inline DoubleDouble sqrt(DoubleDouble a) {
+    if (a.hi <= 0.0) {
+        return DoubleDouble(std::sqrt(a.hi));
+    }
+    // One Newton step on the double-precision estimate (Karp's trick)
+    const double x = 1.0 / std::sqrt(a.hi);
+    const double ax = a.hi * x;
+    const DoubleDouble ax2 = dd_detail::two_prod(ax, ax);
+    return dd_detail::two_sum(ax, (a - ax2).hi * (x * 0.5));
+}
+
+/* =========================
+   Forward-mode dual number
+   ========================= */
+
+// Value plus a single directional derivative. Seeding the tangent of the
+// initial state and/or mu propagates d(output)/d(seed) through any kernel.
+template <typename T>
+struct Dual {
+    T val = T(0);
+    T der = T(0);
+
+    constexpr Dual() = default;
+    constexpr Dual(T v) : val(v), der(T(0)) {}
+    constexpr Dual(T v, T d) : val(v), der(d) {}
+};
+
+template <typename T>
+inline Dual<T> operator+(Dual<T> a, Dual<T> b) {
+    return {a.val + b.val, a.der + b.der};
+}
+template <typename T>
+inline Dual<T> operator-(Dual<T> a) {
+    return {-a.val, -a.der};
+}
+template <typename T>
+inline Dual<T> operator-(Dual<T> a, Dual<T> b) {
+    return {a.val - b.val, a.der - b.der};
+}
+template <typename T>
+inline Dual<T> operator*(Dual<T> a, Dual<T> b) {
+    return {a.val * b.val, a.der * b.val + a.val * b.der};
+}
+template <typename T>
+inline Dual<T> operator/(Dual<T> a, Dual<T> b) {
+    const T inv = T(1) / b.val;
+    const T q = a.val * inv;
+    return {q, (a.der - q * b.der) * inv};
+}
+template <typename T>
+inline Dual<T>& operator+=(Dual<T>& a, Dual<T> b) {
+    return a = a + b;
+}
+template <typename T>
+inline Dual<T>& operator-=(Dual<T>& a, Dual<T> b) {
+    return a = a - b;
+}
+template <typename T>
+inline Dual<T>& operator*=(Dual<T>& a, Dual<T> b) {
+    return a = a * b;
+}
+
+template <typename T>
+inline Dual<T> sqrt(Dual<T> a) {
+    using std::sqrt;
+    const T s = sqrt(a.val);
+    return {s, a.der / (T(2) * s)};
+}
+
+/* =========================
+   Storage traits
+   ========================= */
+
+// How a scalar type is laid out in a NumPy buffer: `lanes` consecutive
+// values of `storage` per scalar (e.g. [hi, lo] or [value, derivative]).
+template <typename T>
+struct ScalarTraits {
+    using storage = T;
+    static constexpr size_t lanes = 1;
+};
+
+template <>
+struct ScalarTraits<DoubleDouble> {
+    using storage = double;
+    static constexpr size_t lanes = 2;
+};
+
+template <typename T>
+struct ScalarTraits<Dual<T>> {
+    using storage = T;
+    static constexpr size_t lanes = 2;
+};
+
+static_assert(sizeof(DoubleDouble) == 2 * sizeof(double));
+static_assert(sizeof(Dual<double>) == 2 * sizeof(double));
@@ -0,0 +1,225 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "integrators.hpp"
+
+/* =========================
+   Gravity gradient kernel
+   ========================= */
+
+constexpr size_t NOT_IN_SUBSET = std::numeric_limits<size_t>::max();
+
+// Point-mass derivative (as point_mass_force_kernel) fused with the gravity
+// gradient G = d(a_S)/d(r_S) restricted to a subset S of m bodies.
+// subset[i] is the position of body i in S, or NOT_IN_SUBSET. Bodies outside
+// S still perturb the subset but their own motion is not differentiated.
+template <typename T>
+inline void point_mass_gradient_kernel(
+    const T* __restrict__ state,    // size: 6*n
+    size_t n,
+    const T* __restrict__ mu,       // size: n
+    const size_t* __restrict__ subset,  // size: n
+    size_t m,
+    T* __restrict__ out,   // size: 6*n
+    T* __restrict__ grad   // size: 3m*3m, row-major
+) {
+    using std::sqrt;
+
+    const size_t vel_offset = 3 * n;
+    const size_t g_dim = 3 * m;
+
+    for (size_t k = 0; k < vel_offset; ++k) {
+        out[k] = state[k + vel_offset];
+        out[k + vel_offset] = T(0);
+    }
+    for (size_t k = 0; k < g_dim * g_dim; ++k) {
+        grad[k] = T(0);
+    }
+
+    // Add s * T_ij to the 3x3 block (a, b) of G
+    auto add_block = [&](size_t a, size_t b, T s, const T* tensor) {
+        T* block = grad + 3 * a * g_dim + 3 * b;
+        for (size_t r = 0; r < 3; ++r) {
+            for (size_t c = 0; c < 3; ++c) {
+                block[r * g_dim + c] += s * tensor[3 * r + c];
+            }
+        }
+    };
+
+    for (size_t i = 0; i < n; ++i) {
+        const T xi = state[3 * i];
+        const T yi = state[3 * i + 1];
+        const T zi = state[3 * i + 2];
+
+        const T mi = mu[i];
+        const size_t si = subset[i];
+
+        for (size_t j = i + 1; j < n; ++j) {
+            const T dx = xi - state[3 * j];
+            const T dy = yi - state[3 * j + 1];
+            const T dz = zi - state[3 * j + 2];
+
+            const T r2 = dx * dx + dy * dy + dz * dz;
+            const T inv_r = T(1) / sqrt(r2);
+            const T inv_r3 = inv_r * inv_r * inv_r;
+
+            const T fx = dx * inv_r3;
+            const T fy = dy * inv_r3;
+            const T fz = dz * inv_r3;
+
+            const T mj = mu[j];
+
+            out[vel_offset + 3 * i] -= mj * fx;
+            out[vel_offset + 3 * i + 1] -= mj * fy;
+            out[vel_offset + 3 * i + 2] -= mj * fz;
+
+            out[vel_offset + 3 * j] += mi * fx;
+            out[vel_offset + 3 * j + 1] += mi * fy;
+            out[vel_offset + 3 * j + 2] += mi * fz;
+
+            const size_t sj = subset[j];
+            if (si == NOT_IN_SUBSET && sj == NOT_IN_SUBSET) {
+                continue;
+            }
+
+            // T_ij = 3 d d^T / r^5 - I / r^3, shared by all four blocks
+            const T inv_r5_3 = T(3) * inv_r3 * inv_r * inv_r;
+            const T d[3] = {dx, dy, dz};
+            T tensor[9];
+            for (size_t r = 0; r < 3; ++r) {
+                for (size_t c = 0; c < 3; ++c) {
+                    tensor[3 * r + c] = inv_r5_3 * d[r] * d[c];
+                }
+                tensor[4 * r] -= inv_r3;
+            }
+
+            if (si != NOT_IN_SUBSET) {
+                add_block(si, si, mj, tensor);
+                if (sj != NOT_IN_SUBSET) {
+                    add_block(si, sj, -mj, tensor);
+                }
+            }
+            if (sj != NOT_IN_SUBSET) {
+                add_block(sj, sj, mi, tensor);
+                if (si != NOT_IN_SUBSET) {
+                    add_block(sj, si, -mi, tensor);
+                }
+            }
+        }
+    }
+}
+
+/* =========================
+   Variational equations
+   ========================= */
+
+// Derivative of the augmented vector [y (6n), Phi (6m x 6m, row-major)],
+// where Phi is the state transition matrix of the subset state
+// [r_S (3m), v_S (3m)]: Phi' = [[0, I], [G, 0]] Phi.
+template <typename T>
+struct VariationalForce {
+    size_t n;
+    const T* mu;
+    const size_t* subset;
+    size_t m;
+    mutable std::vector<T> grad;
+
+    VariationalForce(size_t n_, const T* mu_, const size_t* subset_, size_t m_)
+        : n(n_), mu(mu_), subset(subset_), m(m_), grad(9 * m_ * m_) {}
+
+    size_t dim() const { return 6 * n + 36 * m * m; }
+
+    void operator()(double /*t*/, const T* z, T* dz) const {
+        point_mass_gradient_kernel(z, n, mu, subset, m, dz, grad.data());
+
+        const size_t g_dim = 3 * m;
+        const size_t cols = 6 * m;
+        const T* phi = z + 6 * n;
+        T* d_phi = dz + 6 * n;
+
+        // d(Phi_r)/dt = Phi_v
+        for (size_t k = 0; k < g_dim * cols; ++k) {
+            d_phi[k] = phi[g_dim * cols + k];
+        }
+
+        // d(Phi_v)/dt = G Phi_r
+        T* d_phi_v = d_phi + g_dim * cols;
+        for (size_t k = 0; k < g_dim * cols; ++k) {
+            d_phi_v[k] = T(0);
+        }
+        for (size_t r = 0; r < g_dim; ++r) {
+            const T* g_row = grad.data() + r * g_dim;
+            T* out_row = d_phi_v + r * cols;
+            for (size_t k = 0; k < g_dim; ++k) {
+                const T g = g_row[k];
+                const T* phi_row = phi + k * cols;
+                for (size_t c = 0; c < cols; ++c) {
+                    out_row[c] += g * phi_row[c];
+                }
+            }
+        }
+    }
+};
+
+// Identity STM for the augmented vector tail
+template <typename T>
+inline void identity_stm(size_t m, T* phi) {
+    const size_t cols = 6 * m;
+    for (size_t k = 0; k < cols * cols; ++k) {
+        phi[k] = T(0);
+    }
+    for (size_t k = 0; k < cols; ++k) {
+        phi[k * cols + k] = T(1);
+    }
+}
+
+/* =========================
+   STM driver
+   ========================= */
+
+// RK4 on the augmented vector. Writes every state row to y_out (steps x 6n)
+// and every stride-th STM to phi_out ((steps - 1) / stride + 1 matrices).
+template <typename T>
+void stm_rk4_propagate(const T* state, size_t n, const T* mu,
+                       const size_t* subset, size_t m, double h, size_t steps,
+                       size_t stride, T* y_out, T* phi_out) {
+    VariationalForce<T> f(n, mu, subset, m);
+    const size_t y_dim = 6 * n;
+    const size_t phi_size = 36 * m * m;
+
+    std::vector<T> z(f.dim());
+    std::vector<T> z_next(f.dim());
+    for (size_t k = 0; k < y_dim; ++k) {
+        z[k] = state[k];
+    }
+    identity_stm(m, z.data() + y_dim);
+
+    RK4Stepper<T> stepper(f.dim());
+    for (size_t i = 0; i < steps; ++i) {
+        for (size_t k = 0; k < y_dim; ++k) {
+            y_out[i * y_dim + k] = z[k];
+        }
+        if (i % stride == 0) {
+            T* phi = phi_out + (i / stride) * phi_size;
+            for (size_t k = 0; k < phi_size; ++k) {
+                phi[k] = z[y_dim + k];
+            }
+        }
+        if (i + 1 < steps) {
+            stepper.step(f, static_cast<double>(i) * h, h, z.data(),
+                         z_next.data());
+            std::swap(z, z_next);
+        }
+    }
+}
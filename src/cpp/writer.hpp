@@ -0,0 +1,370 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#define WRITER_POSIX 1
+#endif
+
+/* =========================
+   File sink
+   ========================= */
+
+constexpr size_t IO_ALIGNMENT = 4096;  // [bytes] page and O_DIRECT block size
+
+// Sequential binary output. On Linux the file can be opened with O_DIRECT,
+// bypassing the page cache: writes must then be whole aligned blocks from
+// aligned memory, so the unaligned tail of the stream is written after
+// dropping the flag. Elsewhere O_DIRECT is ignored.
+class FileSink {
+   public:
+    FileSink(const std::string& path, bool direct) {
+#ifdef WRITER_POSIX
+        int flags = O_WRONLY | O_CREAT | O_TRUNC;
+#ifdef O_DIRECT
+        if (direct) {
+            flags |= O_DIRECT;
+            direct_ = true;
+        }
+#endif
+        fd_ = ::open(path.c_str(), flags, 0644);
+        if (fd_ < 0 && direct_) {
+            // Filesystems such as tmpfs refuse O_DIRECT: use the page cache
+            direct_ = false;
+            fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        }
+        if (fd_ < 0) {
+            throw std::runtime_error("cannot open " + path);
+        }
+#else
+        (void)direct;
+        file_ = std::fopen(path.c_str(), "wb");
+        if (file_ == nullptr) {
+            throw std::runtime_error("cannot open " + path);
+        }
+#endif
+    }
+
+    FileSink(const FileSink&) = delete;
+    FileSink& operator=(const FileSink&) = delete;
+
+    ~FileSink() {
+        try {
+            close();
+        } catch (const std::exception&) {
+            // Only reached while unwinding; the original error wins
+        }
+    }
+
+    // `data` must be IO_ALIGNMENT-aligned when the sink is direct
+    void write(const char* data, size_t bytes) {
+#ifdef WRITER_POSIX
+        if (direct_) {
+            const size_t aligned = bytes - bytes % IO_ALIGNMENT;
+            write_all(data, aligned);
+            data += aligned;
+            bytes -= aligned;
+            if (bytes > 0) {
+                // Only the last write of the stream can be unaligned
+                ::fcntl(fd_, F_SETFL, ::fcntl(fd_, F_GETFL) & ~O_DIRECT);
+                direct_ = false;
+            }
+        }
+        write_all(data, bytes);
+#else
+        if (std::fwrite(data, 1, bytes, file_) != bytes) {
+            throw std::runtime_error("short write");
+        }
+#endif
+    }
+
+    void close() {
+#ifdef WRITER_POSIX
+        if (fd_ >= 0) {
+            const int status = ::close(fd_);
+            fd_ = -1;
+            if (status != 0) {
+                throw std::runtime_error("close failed");
+            }
+        }
+#else
+        if (file_ != nullptr) {
+            const int status = std::fclose(file_);
+            file_ = nullptr;
+            if (status != 0) {
+                throw std::runtime_error("close failed");
+            }
+        }
+#endif
+    }
+
+   private:
+#ifdef WRITER_POSIX
+    void write_all(const char* data, size_t bytes) {
+        while (bytes > 0) {
+            const ssize_t written = ::write(fd_, data, bytes);
+            if (written <= 0) {
+                throw std::runtime_error("write failed");
+            }
+            data += written;
+            bytes -= static_cast<size_t>(written);
+        }
+    }
+
+    int fd_ = -1;
+    bool direct_ = false;
+#else
+    std::FILE* file_ = nullptr;
+#endif
+};
+
+/* =========================
+   Double-buffered writer
+   ========================= */
+
+// Byte stream over two aligned staging buffers. The producer fills one
+// buffer while a background thread flushes the other, so integration and
+// disk I/O overlap; the producer only waits (stalls) when the disk is
+// slower than the integrator. With overlap disabled every flush happens
+// inline, which gives the serial baseline for throughput comparisons.
+class AsyncWriter {
+   public:
+    AsyncWriter(const std::string& path, size_t buffer_bytes, bool direct,
+                bool overlap)
+        : sink_(path, direct),
+          capacity_(round_up(buffer_bytes)),
+          overlap_(overlap) {
+        for (char*& b : buffer_) {
+            b = static_cast<char*>(
+                ::operator new[](capacity_, std::align_val_t{IO_ALIGNMENT}));
+        }
+        if (overlap_) {
+            thread_ = std::thread(&AsyncWriter::run, this);
+        }
+    }
+
+    AsyncWriter(const AsyncWriter&) = delete;
+    AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+    ~AsyncWriter() {
+        stop();
+        for (char* b : buffer_) {
+            ::operator delete[](b, std::align_val_t{IO_ALIGNMENT});
+        }
+    }
+
+    void append(const void* data, size_t bytes) {
+        const char* src = static_cast<const char*>(data);
+        while (bytes > 0) {
+            const size_t take = std::min(bytes, capacity_ - fill_);
+            std::memcpy(buffer_[current_] + fill_, src, take);
+            fill_ += take;
+            src += take;
+            bytes -= take;
+            if (fill_ == capacity_) {
+                submit();
+            }
+        }
+    }
+
+    // Flush what is left and close the file; rethrows I/O errors
+    void finish() {
+        if (fill_ > 0) {
+            submit();
+        }
+        stop();
+        if (!error_.empty()) {
+            throw std::runtime_error(error_);
+        }
+        sink_.close();
+    }
+
+    double write_seconds() const { return write_seconds_; }
+    double stall_seconds() const { return stall_seconds_; }
+
+   private:
+    using clock = std::chrono::steady_clock;
+
+    static size_t round_up(size_t bytes) {
+        const size_t blocks = (bytes + IO_ALIGNMENT - 1) / IO_ALIGNMENT;
+        return (blocks > 0 ? blocks : 1) * IO_ALIGNMENT;
+    }
+
+    void flush(const char* data, size_t bytes) {
+        const auto start = clock::now();
+        sink_.write(data, bytes);
+        write_seconds_ +=
+            std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    // Hand the current buffer over and continue in the other one
+    void submit() {
+        if (!overlap_) {
+            flush(buffer_[current_], fill_);
+            fill_ = 0;
+            return;
+        }
+
+        const auto start = clock::now();
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_.wait(lock, [this] { return pending_ == NONE; });
+        stall_seconds_ +=
+            std::chrono::duration<double>(clock::now() - start).count();
+        if (!error_.empty()) {
+            throw std::runtime_error(error_);
+        }
+
+        pending_ = current_;
+        pending_bytes_ = fill_;
+        lock.unlock();
+        ready_.notify_one();
+
+        current_ ^= 1;
+        fill_ = 0;
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            ready_.wait(lock, [this] { return pending_ != NONE || done_; });
+            if (pending_ == NONE) {
+                return;
+            }
+            const size_t index = pending_;
+            const size_t bytes = pending_bytes_;
+            lock.unlock();
+
+            std::string error;
+            try {
+                flush(buffer_[index], bytes);
+            } catch (const std::exception& e) {
+                error = e.what();
+            }
+
+            lock.lock();
+            if (!error.empty() && error_.empty()) {
+                error_ = error;
+            }
+            pending_ = NONE;
+            idle_.notify_one();
+        }
+    }
+
+    // Wait for the last flush and join the thread
+    void stop() {
+        if (!thread_.joinable()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            done_ = true;
+        }
+        ready_.notify_one();
+        thread_.join();
+    }
+
+    static constexpr size_t NONE = static_cast<size_t>(-1);
+
+    FileSink sink_;
+    size_t capacity_;
+    bool overlap_;
+    char* buffer_[2] = {nullptr, nullptr};
+    size_t current_ = 0;
+    size_t fill_ = 0;
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable ready_, idle_;
+    size_t pending_ = NONE;
+    size_t pending_bytes_ = 0;
+    bool done_ = false;
+    std::string error_;
+
+    double write_seconds_ = 0.0;  // accumulated by whichever thread flushes
+    double stall_seconds_ = 0.0;
+};
+
+/* =========================
+   Trajectory to file
+   ========================= */
+
+struct WriterStats {
+    size_t steps;
+    double seconds;
+    double write_seconds;
+    double stall_seconds;
+};
+
+// Observer of the states streamed by propagate_to_file: row(i, y) sees
+// state i before the step leaving it, finish(y) the last state
+struct NoMonitor {
+    void row(size_t /*i*/, const double* /*y*/) {}
+    void finish(const double* /*y*/) {}
+};
+
+// Propagate `steps` rows like `propagate` and stream them to a .simstate
+// file: `header` is written first, then every row interleaved per body as
+// [r_i, v_i]. Memory is two staging buffers regardless of `steps`.
+template <typename Stepper, typename Force, typename Monitor = NoMonitor>
+WriterStats propagate_to_file(Stepper& stepper, const Force& f,
+                              const double* state, size_t n, double h,
+                              size_t steps, const std::string& path,
+                              const char* header, size_t header_bytes,
+                              size_t buffer_steps, bool direct, bool overlap,
+                              Monitor* monitor = nullptr) {
+    const auto start = std::chrono::steady_clock::now();
+    const size_t dim = 6 * n;
+    AsyncWriter writer(path, buffer_steps * dim * sizeof(double), direct,
+                       overlap);
+    writer.append(header, header_bytes);
+
+    std::vector<double> y(state, state + dim), y_next(dim), row(dim);
+    for (size_t i = 0; i < steps; ++i) {
+        if (i > 0) {
+            stepper.step(f, static_cast<double>(i - 1) * h, h, y.data(),
+                         y_next.data());
+            y.swap(y_next);
+        }
+        const double* r = y.data();
+        const double* v = r + 3 * n;
+        for (size_t b = 0; b < n; ++b) {
+            for (size_t c = 0; c < 3; ++c) {
+                row[6 * b + c] = r[3 * b + c];
+                row[6 * b + 3 + c] = v[3 * b + c];
+            }
+        }
+        writer.append(row.data(), dim * sizeof(double));
+        if (monitor != nullptr) {
+            monitor->row(i, y.data());
+        }
+    }
+    if (monitor != nullptr) {
+        monitor->finish(y.data());
+    }
+    writer.finish();
+
+    return {steps,
+            std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                          start)
+                .count(),
+            writer.write_seconds(), writer.stall_seconds()};
+}
@@ -4,13 +4,18 @@
 
 from typing import Tuple
 
+from project.simulation.integrator import FunctionProtocol
 from project.simulation.model import NumbaPointMass
 from project.simulation.presets import BodyPresets
 from project.simulation.propagator import Propagator
 from project.utils import Dir
 from project.utils.apis.horizons import generate_sim_file
 from project.utils.data import BodyList
-from project.utils.simstate import SIMSTATE_FILE, SimstateMemmap
+from project.utils.simcache import DEFAULT_BUDGET, TrajectoryCache, trajectory_key
+from project.utils.simcheckpoint import checkpoint_filename, force_model_key
+from project.utils.simlod import TrajectoryPyramid, ensure_simlod, lod_filename
+from project.utils.simsnap import SIMSNAP_EXTENSION
+from project.utils.simstate import SimstateMemmap
 
 
 class Simulation:
@@ -21,7 +26,15 @@ class Simulation:
         time: float,
         horizons: bool = False,
         epoch: Tuple[int, int, int] | None = None,
+        force_model: FunctionProtocol | None = None,
+        cache_budget: int | None = DEFAULT_BUDGET,
     ) -> None:
+        """
+        Trajectory of the system in data/<name>.toml, propagated with RK4
+        (by default with `NumbaPointMass`) or taken from the content-addressed
+        cache in `Dir.simulation`, which is kept within `cache_budget` bytes
+        (None: unbounded) by evicting the least recently used runs.
+        """
         if horizons:
             if epoch is None:
                 raise ValueError("Must specify epoch for Horizons fetch")
@@ -33,7 +46,9 @@ class Simulation:
         self.steps = int(time / dt)
 
         file_in = Dir.data / (self.name + ".toml")
-        file_traj = Dir.simulation / SIMSTATE_FILE.format(self.name, dt, self.steps)
+        # Snapshots of large catalogues load without parsing every body
+        if (Dir.data / (self.name + SIMSNAP_EXTENSION)).exists():
+            file_in = Dir.data / (self.name + SIMSNAP_EXTENSION)
 
         if not file_in.exists():
             if horizons and epoch is not None and hasattr(BodyPresets, name):
@@ -56,10 +71,36 @@ class Simulation:
         else:
             self.epoch = ""
 
-        if not file_traj.exists():
+        force_model = force_model or NumbaPointMass()
+        force = force_model_key(force_model)
+        if force is None:
+            raise ValueError(f"{type(force_model).__name__} runs cannot be cached")
+        cache = TrajectoryCache(Dir.simulation, cache_budget)
+        self.key = trajectory_key(
+            self.body_list.y_0, self.body_list.mu, "rk4", force, dt
+        )
+        file_traj = cache.filename(self.key, dt, self.steps)
+
+        # Reuse earlier runs: a longer one serves this one as a prefix, a
+        # shorter checkpointed one is extended instead of recomputed
+        cached = cache.trajectories(self.key, dt)
+        longer = [path for steps, path in cached if steps >= self.steps]
+        shorter = [
+            path
+            for steps, path in cached
+            if steps < self.steps and checkpoint_filename(path).exists()
+        ]
+        p = Propagator("rk4", force_model)
+        if longer:
+            file_traj = longer[0]
+        elif shorter:
+            print(f"Simulating {time:.2e} seconds...")
+            p.extend(shorter[-1], self.body_list, file_traj)
+            lod_filename(shorter[-1]).unlink(missing_ok=True)  # consumed
+            print("\nSimulation complete.")
+        else:
             print(f"Simulating {time:.2e} seconds...")
             # simulate_n_steps(self.body_list, self.steps, dt, file_traj, prnt=True)
-            p = Propagator("rk4", NumbaPointMass())
             p.propagate(
                 time_step=dt,
                 stop_time=int(self.steps * dt),
@@ -68,4 +109,18 @@ class Simulation:
             )
             print("\nSimulation complete.")
 
-        self.mm = SimstateMemmap(file_traj)
+        self.mm = SimstateMemmap(file_traj, steps=self.steps + 1)
+        # Decimated levels for strided reads at high playback speeds, shared
+        # with the longer trajectory this one may be a prefix of
+        lod = ensure_simlod(file_traj, SimstateMemmap(file_traj))
+        self.lod = TrajectoryPyramid(self.mm, lod)
+        self.file = file_traj
+
+        cache.touch(
+            self.key,
+            name=self.name,
+            integrator="rk4",
+            force=force,
+            dt=dt,
+            steps=max(steps for steps, _ in cache.trajectories(self.key, dt)),
+        )
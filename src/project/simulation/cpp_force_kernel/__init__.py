@@ -17,5 +17,77 @@ from . import _cpp_force_kernel
 
 # Re-export the public API
 point_mass_cpp = _cpp_force_kernel.point_mass_cpp
+point_mass_cpp_f32 = _cpp_force_kernel.point_mass_cpp_f32
+point_mass_cpp_dd = _cpp_force_kernel.point_mass_cpp_dd
+point_mass_cpp_dual = _cpp_force_kernel.point_mass_cpp_dual
 
-__all__ = ["point_mass_cpp"]
+euler_cpp = _cpp_force_kernel.euler_cpp
+euler_cpp_f32 = _cpp_force_kernel.euler_cpp_f32
+euler_cpp_dd = _cpp_force_kernel.euler_cpp_dd
+euler_cpp_dual = _cpp_force_kernel.euler_cpp_dual
+
+rk4_cpp = _cpp_force_kernel.rk4_cpp
+rk4_cpp_f32 = _cpp_force_kernel.rk4_cpp_f32
+rk4_cpp_dd = _cpp_force_kernel.rk4_cpp_dd
+rk4_cpp_dual = _cpp_force_kernel.rk4_cpp_dual
+
+leapfrog_cpp = _cpp_force_kernel.leapfrog_cpp
+leapfrog_cpp_f32 = _cpp_force_kernel.leapfrog_cpp_f32
+leapfrog_cpp_dd = _cpp_force_kernel.leapfrog_cpp_dd
+leapfrog_cpp_dual = _cpp_force_kernel.leapfrog_cpp_dual
+
+point_mass_gradient_cpp = _cpp_force_kernel.point_mass_gradient_cpp
+stm_rk4_cpp = _cpp_force_kernel.stm_rk4_cpp
+PointMassAdjoint = _cpp_force_kernel.PointMassAdjoint
+
+HarmonicField = _cpp_force_kernel.HarmonicField
+harmonic_cpp = _cpp_force_kernel.harmonic_cpp
+rk4_harmonic_cpp = _cpp_force_kernel.rk4_harmonic_cpp
+
+SPEED_OF_LIGHT = _cpp_force_kernel.SPEED_OF_LIGHT
+eih_cpp = _cpp_force_kernel.eih_cpp
+rk4_eih_cpp = _cpp_force_kernel.rk4_eih_cpp
+
+rk4_simstate_cpp = _cpp_force_kernel.rk4_simstate_cpp
+transpose_tile_cpp = _cpp_force_kernel.transpose_tile_cpp
+integrals_cpp = _cpp_force_kernel.integrals_cpp
+elements_to_states_cpp = _cpp_force_kernel.elements_to_states_cpp
+
+ChebyshevEphemeris = _cpp_force_kernel.ChebyshevEphemeris
+HermiteTrajectory = _cpp_force_kernel.HermiteTrajectory
+SimstateReader = _cpp_force_kernel.SimstateReader
+
+__all__ = [
+    "point_mass_cpp",
+    "point_mass_cpp_f32",
+    "point_mass_cpp_dd",
+    "point_mass_cpp_dual",
+    "euler_cpp",
+    "euler_cpp_f32",
+    "euler_cpp_dd",
+    "euler_cpp_dual",
+    "rk4_cpp",
+    "rk4_cpp_f32",
+    "rk4_cpp_dd",
+    "rk4_cpp_dual",
+    "leapfrog_cpp",
+    "leapfrog_cpp_f32",
+    "leapfrog_cpp_dd",
+    "leapfrog_cpp_dual",
+    "point_mass_gradient_cpp",
+    "stm_rk4_cpp",
+    "PointMassAdjoint",
+    "HarmonicField",
+    "harmonic_cpp",
+    "rk4_harmonic_cpp",
+    "SPEED_OF_LIGHT",
+    "eih_cpp",
+    "rk4_eih_cpp",
+    "rk4_simstate_cpp",
+    "transpose_tile_cpp",
+    "integrals_cpp",
+    "elements_to_states_cpp",
+    "ChebyshevEphemeris",
+    "HermiteTrajectory",
+    "SimstateReader",
+]
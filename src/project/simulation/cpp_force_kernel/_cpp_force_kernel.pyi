@@ -4,10 +4,274 @@
 #
 # SPDX-License-Identifier: AGPL-3.0-or-later
 
-from project.utils import FloatArray
+from typing import Dict, List, Tuple
+
+from project.utils import FloatArray, IntArray
+
+# Scalar variants share one signature. float32 (_f32) and float64 (no suffix)
+# take 1D arrays; double-double (_dd, [hi, lo]) and dual (_dual, [value,
+# derivative]) take arrays with a trailing axis of 2.
 
 def point_mass_cpp(
     state: FloatArray,
     mu: FloatArray,
     out: FloatArray,
 ) -> None: ...
+def point_mass_cpp_f32(
+    state: FloatArray,
+    mu: FloatArray,
+    out: FloatArray,
+) -> None: ...
+def point_mass_cpp_dd(
+    state: FloatArray,
+    mu: FloatArray,
+    out: FloatArray,
+) -> None: ...
+def point_mass_cpp_dual(
+    state: FloatArray,
+    mu: FloatArray,
+    out: FloatArray,
+) -> None: ...
+def euler_cpp(
+    state: FloatArray,
+    time_step: float,
+    steps: int,
+    mu: FloatArray,
+) -> FloatArray: ...
+def euler_cpp_f32(
+    state: FloatArray,
+    time_step: float,
+    steps: int,
+    mu: FloatArray,
+) -> FloatArray: ...
+def euler_cpp_dd(
+    state: FloatArray,
+    time_step: float,
+    steps: int,
+    mu: FloatArray,
+) -> FloatArray: ...
+def euler_cpp_dual(
+    state: FloatArray,
+    time_step: float,
+    steps: int,
+    mu: FloatArray,
+) -> FloatArray: ...
+def rk4_cpp(
+    state: FloatArray,
+    time_step: float,
+    steps: int,
+    mu: FloatArray,
+) -> FloatArray: ...
+def rk4_cpp_f32(
+    state: FloatArray,
+    time_step: float,
+    steps: int,
+    mu: FloatArray,
+) -> FloatArray: ...
+def rk4_cpp_dd(
+    state: FloatArray,
+    time_step: float,
+    steps: int,
+    mu: FloatArray,
+) -> FloatArray: ...
+def rk4_cpp_dual(
+    state: FloatArray,
+    time_step: float,
+    steps: int,
+    mu: FloatArray,
+) -> FloatArray: ...
+def leapfrog_cpp(
+    state: FloatArray,
+    time_step: float,
+    steps: int,
+    mu: FloatArray,
+) -> FloatArray: ...
+def leapfrog_cpp_f32(
+    state: FloatArray,
+    time_step: float,
+    steps: int,
+    mu: FloatArray,
+) -> FloatArray: ...
+def leapfrog_cpp_dd(
+    state: FloatArray,
+    time_step: float,
+    steps: int,
+    mu: FloatArray,
+) -> FloatArray: ...
+def leapfrog_cpp_dual(
+    state: FloatArray,
+    time_step: float,
+    steps: int,
+    mu: FloatArray,
+) -> FloatArray: ...
+def point_mass_gradient_cpp(
+    state: FloatArray,
+    mu: FloatArray,
+    bodies: IntArray,
+    out: FloatArray,
+    grad: FloatArray,
+) -> None: ...
+def stm_rk4_cpp(
+    state: FloatArray,
+    time_step: float,
+    steps: int,
+    mu: FloatArray,
+    bodies: IntArray,
+    stride: int = 1,
+) -> Tuple[FloatArray, FloatArray]: ...
+
+class PointMassAdjoint:
+    """Discrete adjoint of the rk4/leapfrog point-mass propagation"""
+
+    def __init__(
+        self,
+        mu: FloatArray,
+        time_step: float,
+        steps: int,
+        scheme: str = "rk4",
+        checkpoint_every: int = 0,
+    ) -> None: ...
+    def forward(self, state: FloatArray, samples: IntArray) -> FloatArray: ...
+    def backward(self, cotangents: FloatArray) -> Tuple[FloatArray, FloatArray]: ...
+    @property
+    def checkpoint_every(self) -> int: ...
+
+class HarmonicField:
+    """Normalized spherical-harmonic field of an extended primary"""
+
+    def __init__(
+        self,
+        body: int,
+        radius: float,
+        c: FloatArray,
+        s: FloatArray,
+        pole_ra: float = 0.0,
+        pole_dec: float = ...,
+        w_0: float = 0.0,
+        w_dot: float = 0.0,
+        cutoff: float = ...,
+    ) -> None: ...
+    @property
+    def body(self) -> int: ...
+    @property
+    def degree(self) -> int: ...
+    @property
+    def order(self) -> int: ...
+
+def harmonic_cpp(
+    state: FloatArray,
+    mu: FloatArray,
+    fields: List[HarmonicField],
+    t: float,
+    out: FloatArray,
+) -> None: ...
+def rk4_harmonic_cpp(
+    state: FloatArray,
+    time_step: float,
+    steps: int,
+    mu: FloatArray,
+    fields: List[HarmonicField],
+    t0: float = 0.0,
+) -> FloatArray: ...
+
+SPEED_OF_LIGHT: float
+
+def eih_cpp(
+    state: FloatArray,
+    mu: FloatArray,
+    out: FloatArray,
+    c: float = ...,
+) -> None: ...
+def rk4_eih_cpp(
+    state: FloatArray,
+    time_step: float,
+    steps: int,
+    mu: FloatArray,
+    c: float = ...,
+) -> FloatArray: ...
+def rk4_simstate_cpp(
+    state: FloatArray,
+    time_step: float,
+    steps: int,
+    mu: FloatArray,
+    filename: str,
+    header: bytes,
+    buffer_steps: int = 10000,
+    direct_io: bool = False,
+    overlap: bool = True,
+    integrals_filename: str = "",
+    integrals_header: bytes = b"",
+    integrals_every: int = 1,
+    G: float = 6.6743e-11,
+) -> Dict[str, float]: ...
+def transpose_tile_cpp(
+    block: FloatArray,
+    tile: FloatArray,
+    threads: int = 0,
+) -> None: ...
+def integrals_cpp(
+    data: FloatArray,
+    mu: FloatArray,
+    G: float,
+    out: FloatArray,
+    threads: int = 0,
+) -> None: ...
+def elements_to_states_cpp(
+    elements: FloatArray,
+    mu: FloatArray,
+    dt: FloatArray,
+    center: FloatArray,
+    rotation: FloatArray,
+    r: FloatArray,
+    v: FloatArray,
+    threads: int = 0,
+) -> None: ...
+
+class ChebyshevEphemeris:
+    def __init__(
+        self,
+        first_segment: IntArray,
+        bounds: FloatArray,
+        coeffs: FloatArray,
+    ) -> None: ...
+    def evaluate(
+        self, times: FloatArray, bodies: IntArray, threads: int = 0
+    ) -> FloatArray: ...
+    @property
+    def bodies(self) -> int: ...
+    @property
+    def degree(self) -> int: ...
+    @property
+    def segments(self) -> int: ...
+
+class HermiteTrajectory:
+    def __init__(
+        self,
+        data: FloatArray,
+        time_step: float,
+        times: FloatArray | None = None,
+    ) -> None: ...
+    def evaluate(
+        self, times: FloatArray, bodies: IntArray, threads: int = 0
+    ) -> FloatArray: ...
+    @property
+    def steps(self) -> int: ...
+    @property
+    def bodies(self) -> int: ...
+
+class SimstateReader:
+    def __init__(self, filename: str) -> None: ...
+    def __buffer__(self, flags: int) -> memoryview: ...
+    def times(self) -> FloatArray | None: ...
+    def rv(
+        self, key: object, velocity: bool = False, vis: bool = False
+    ) -> FloatArray | None: ...
+    def advise(self, pattern: str, start: int = 0, stop: int | None = None) -> None: ...
+    @property
+    def steps(self) -> int: ...
+    @property
+    def bodies(self) -> int: ...
+    @property
+    def state_dim(self) -> int: ...
+    @property
+    def dt(self) -> float: ...
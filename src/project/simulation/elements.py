@@ -0,0 +1,200 @@
+# SPDX-FileCopyrightText: © 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+#
+# SPDX-License-Identifier: AGPL-3.0-or-later
+
+"""Osculating-element catalogues
+
+Catalogues of small bodies (MPCORB-style) give heliocentric osculating
+elements a, e, i, node, argument of periapsis and mean anomaly at an epoch,
+in the ecliptic and equinox of J2000. `elements_to_states` converts them in
+bulk natively (Kepler's equation solved lane-wise over the objects and
+threaded), advancing each object from its epoch, rotating into the
+equatorial frame of the Horizons states and adding the state of the central
+body, so that the states land in the SSB frame of the simulation.
+
+`write_catalogue_simsnap` seeds a test-particle run: the massive bodies of
+a `BodyList` followed by the catalogue objects, their states written
+straight into the mapped columns of a .simsnap snapshot.
+"""
+
+from dataclasses import dataclass
+from datetime import datetime
+from pathlib import Path
+from typing import List, Tuple
+
+import numpy as np
+from numpy.typing import ArrayLike
+
+from project.simulation.cpp_force_kernel import elements_to_states_cpp
+from project.utils import D, FloatArray, T, datetime_to_jd
+from project.utils.data import BodyList
+from project.utils.simsnap import SimsnapWriter
+
+OBLIQUITY_J2000 = np.deg2rad(84381.448 / 3600)  # IAU 1976 [rad]
+# Ecliptic J2000 -> equatorial (ICRF) coordinates
+ECLIPTIC_J2000: FloatArray = np.array(
+    [
+        [1.0, 0.0, 0.0],
+        [0.0, np.cos(OBLIQUITY_J2000), -np.sin(OBLIQUITY_J2000)],
+        [0.0, np.sin(OBLIQUITY_J2000), np.cos(OBLIQUITY_J2000)],
+    ]
+)
+
+# MPC packed dates: century letter, two year digits, month and day as
+# base-32 digits (1-9, A = 10, ..., V = 31)
+_CENTURY = {"I": 1800, "J": 1900, "K": 2000}
+
+
+def unpack_epoch(packed: str) -> float:
+    """Julian date of an MPC packed epoch, e.g. "K2555" -> 2025-05-05"""
+    year = _CENTURY[packed[0]] + int(packed[1:3])
+    return datetime_to_jd(datetime(year, int(packed[3], 32), int(packed[4], 32)))
+
+
+@dataclass
+class ElementCatalogue:
+    """
+    Osculating elements of k objects: `elements` (k, 6) holds a [m], e,
+    i, node, argument of periapsis and mean anomaly [rad], `epoch` (k,)
+    the Julian dates they refer to.
+    """
+
+    names: List[str]
+    elements: FloatArray
+    epoch: FloatArray
+
+    def __len__(self) -> int:
+        return len(self.names)
+
+
+def read_mpcorb(filename: Path) -> ElementCatalogue:
+    """Read an MPCORB.DAT-style file (fixed columns, header ended by a line
+    of dashes when present); lines too short to hold elements are skipped"""
+    with open(filename, encoding="ascii", errors="replace") as f:
+        lines = f.read().splitlines()
+    for k, line in enumerate(lines):
+        if line.startswith("-----"):
+            lines = lines[k + 1 :]
+            break
+
+    names, epochs, rows = [], [], []
+    for line in lines:
+        if len(line) < 103:
+            continue
+        names.append(line[166:194].strip() or line[0:7].strip())
+        epochs.append(unpack_epoch(line[20:25]))
+        # M, peri, node, incl, e, a
+        rows.append(
+            [float(line[c:d]) for c, d in ((26, 35), (37, 46), (48, 57), (59, 68))]
+            + [float(line[70:79]), float(line[92:103])]
+        )
+
+    values = np.array(rows, dtype=np.float64).reshape(-1, 6)
+    elements = np.empty_like(values)
+    elements[:, 0] = values[:, 5] * D.au
+    elements[:, 1] = values[:, 4]
+    elements[:, 2:6] = np.deg2rad(values[:, [3, 2, 1, 0]])
+    return ElementCatalogue(names, elements, np.array(epochs, dtype=np.float64))
+
+
+def elements_to_states(
+    elements: ArrayLike,
+    mu: ArrayLike,
+    dt: ArrayLike = 0.0,
+    center: ArrayLike | None = None,
+    rotation: ArrayLike = ECLIPTIC_J2000,
+    r: FloatArray | None = None,
+    v: FloatArray | None = None,
+    threads: int = 0,
+) -> Tuple[FloatArray, FloatArray]:
+    """
+    Cartesian states of elliptic orbits from osculating elements.
+
+    Parameters
+    ----------
+    elements : ArrayLike
+        (k, 6) a [m], e, i, node, argument of periapsis, mean anomaly [rad]
+    mu : ArrayLike
+        Gravitational parameter of the central body (or per object) [m^3/s^2]
+    dt : ArrayLike
+        Time from the element epoch (scalar or per object) [s]
+    center : ArrayLike | None
+        State [r, v] of the central body in the output frame, by default 0
+    rotation : ArrayLike
+        (3, 3) rotation from the element reference plane to the output frame,
+        by default ecliptic J2000 to equatorial
+    r, v : FloatArray | None
+        (k, 3) float64 C-contiguous outputs written in place (e.g. snapshot
+        columns), by default allocated
+    threads : int
+        Worker threads, 0 for all cores
+
+    Returns
+    -------
+    Tuple[FloatArray, FloatArray]
+        r [m] and v [m/s], (k, 3)
+    """
+    elements = np.ascontiguousarray(elements, dtype=np.float64)
+    k = elements.shape[0]
+    r = np.empty((k, 3)) if r is None else r
+    v = np.empty((k, 3)) if v is None else v
+    for out in (r, v):
+        if (
+            out.dtype != np.float64
+            or not out.flags.c_contiguous
+            or not out.flags.writeable
+        ):
+            raise ValueError("r and v must be writeable C-contiguous float64")
+    elements_to_states_cpp(
+        elements,
+        np.atleast_1d(np.asarray(mu, dtype=np.float64)),
+        np.atleast_1d(np.asarray(dt, dtype=np.float64)),
+        np.zeros(6) if center is None else np.asarray(center, dtype=np.float64),
+        np.asarray(rotation, dtype=np.float64),
+        r,
+        v,
+        threads,
+    )
+    return r, v
+
+
+def write_catalogue_simsnap(
+    filename: Path,
+    catalogue: ElementCatalogue,
+    body_list: BodyList,
+    center: int = 0,
+    threads: int = 0,
+) -> None:
+    """
+    Snapshot of the bodies of `body_list` followed by the catalogue objects
+    as massless test particles at the epoch of the body list, their
+    heliocentric elements taken about body `center` (the Sun).
+    """
+    if not body_list.metadata or "epoch" not in body_list.metadata:
+        raise ValueError("body_list needs a metadata epoch")
+    epoch = datetime_to_jd(
+        datetime.strptime(body_list.metadata["epoch"], "%Y-%m-%d %H:%M:%S")
+    )
+    n = len(body_list)
+    names = [body.name for body in body_list] + catalogue.names
+    mu = np.concatenate([body_list.mu, np.zeros(len(catalogue))])
+    radius = [np.nan if body.radius is None else body.radius for body in body_list]
+
+    with SimsnapWriter(
+        filename,
+        names,
+        mu,
+        radius + [np.nan] * len(catalogue),
+        body_list.metadata,
+    ) as w:
+        w.snapshot.r_0[:n] = body_list.r_0.reshape(-1, 3)
+        w.snapshot.v_0[:n] = body_list.v_0.reshape(-1, 3)
+        elements_to_states(
+            catalogue.elements,
+            body_list.mu[center],
+            (epoch - catalogue.epoch) * T.d,
+            np.concatenate([w.snapshot.r_0[center], w.snapshot.v_0[center]]),
+            r=w.snapshot.r_0[n:],
+            v=w.snapshot.v_0[n:],
+            threads=threads,
+        )
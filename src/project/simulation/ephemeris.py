@@ -0,0 +1,318 @@
+# SPDX-FileCopyrightText: © 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+#
+# SPDX-License-Identifier: AGPL-3.0-or-later
+
+"""Ephemeris module
+
+A trajectory is compressed into per-body Chebyshev segments (SPK types 2/3
+style). Each segment is a least-squares fit of the position polynomial to
+the stored positions and velocities, so velocity is its derivative, and
+segments grow adaptively until the fit would exceed the tolerance.
+
+Stored trajectories and segment files answer the same batch queries: arrays
+of times and body indices in, states out, evaluated natively (vectorized
+over queries and threaded) by cubic Hermite interpolation between stored
+steps or by Chebyshev evaluation.
+"""
+
+import struct
+from functools import lru_cache
+from pathlib import Path
+from typing import List, Tuple
+
+import numpy as np
+from numpy.polynomial import chebyshev
+
+from project.simulation.cpp_force_kernel import ChebyshevEphemeris, HermiteTrajectory
+from project.utils import FloatArray, IntArray
+from project.utils.simstate import SimstateMemmap
+
+SIMEPHEM_EXTENSION = ".simephem"
+SIMEPHEM_FILE = "{}__{}__{}" + SIMEPHEM_EXTENSION  # name, dt, steps
+
+MAGIC = b"SIMEPHEM"
+VERSION = 1
+HEADER_FMT = (
+    "<"  # little-endian
+    "8s"  # magic
+    "I"  # version
+    "I"  # bodies
+    "I"  # degree
+    "Q"  # segments
+    "d"  # t_start
+    "d"  # t_stop
+    "20s"  # future / padding
+)
+HEADER_SIZE = struct.calcsize(HEADER_FMT)  # 64 bytes
+
+DEFAULT_DEGREE = 12
+WINDOW_STEPS = 1 << 16
+
+
+def fit_chebyshev(
+    sim: SimstateMemmap,
+    tolerance: float,
+    degree: int = DEFAULT_DEGREE,
+    velocity_tolerance: float | None = None,
+    window_steps: int = WINDOW_STEPS,
+) -> Tuple[IntArray, FloatArray, FloatArray]:
+    """Fit adaptive Chebyshev segments to every body of a trajectory
+
+    The file is read in windows of `window_steps` steps (sequential reads,
+    bounded memory); segments end at window boundaries. Within a window each
+    segment is grown by doubling, then bisection, to the longest run of
+    steps whose fit stays within the tolerances at every stored step.
+
+    Parameters
+    ----------
+    sim : SimstateMemmap
+        Trajectory to compress
+    tolerance : float
+        Maximum position error at the stored steps [m]
+    degree : int, optional
+        Polynomial degree, by default 12
+    velocity_tolerance : float | None, optional
+        Maximum velocity error [m/s], by default tolerance / |dt|
+    window_steps : int, optional
+        Steps read at once, by default 65536
+
+    Returns
+    -------
+    Tuple[IntArray, FloatArray, FloatArray]
+        first_segment (bodies + 1), bounds (segments, 2) [s] and coefficients
+        (segments, 3, degree + 1) [m], segments grouped by body
+    """
+    if velocity_tolerance is None:
+        velocity_tolerance = tolerance / (abs(sim.dt) or 1)
+
+    segments: List[List[Tuple[float, float, FloatArray]]] = [
+        [] for _ in range(sim.bodies)
+    ]
+    sim.advise("sequential")
+    start = 0
+    while start < sim.steps - 1:
+        stop = min(start + window_steps, sim.steps - 1)
+        block = np.asarray(sim.mm[start : stop + 1])
+        if sim.dt > 0:
+            t = np.arange(start, stop + 1) * float(sim.dt)
+        else:
+            t = np.asarray(sim.t[start : stop + 1], dtype=np.float64)
+        for b in range(sim.bodies):
+            segments[b].extend(
+                _fit_body(
+                    t,
+                    block[:, b, :3],
+                    block[:, b, 3:6],
+                    degree,
+                    tolerance,
+                    velocity_tolerance,
+                )
+            )
+        start = stop
+
+    first_segment = np.cumsum([0] + [len(s) for s in segments]).astype(np.intp)
+    flat = [seg for body in segments for seg in body]
+    bounds = np.array([(t0, t1) for t0, t1, _ in flat], dtype=np.float64)
+    coeffs = np.array([c for _, _, c in flat], dtype=np.float64)
+    return first_segment, bounds.reshape(-1, 2), coeffs.reshape(-1, 3, degree + 1)
+
+
+def _fit_body(
+    t: FloatArray,
+    r: FloatArray,
+    v: FloatArray,
+    degree: int,
+    tolerance: float,
+    velocity_tolerance: float,
+) -> List[Tuple[float, float, FloatArray]]:
+    """Greedy adaptive segmentation of one body over one window"""
+    uniform = np.allclose(np.diff(t), t[1] - t[0], rtol=1e-12, atol=0)
+    n = t.size
+    min_steps = max(1, (degree + 1) // 2)
+
+    def fit(i0: int, steps: int) -> Tuple[FloatArray, bool]:
+        i1 = i0 + steps + 1
+        half = (t[i1 - 1] - t[i0]) / 2
+        if uniform:
+            vander, dvander, pinv = _uniform_basis(steps, degree)
+        else:
+            tau = (t[i0:i1] - t[i0]) / half - 1.0
+            vander, dvander, pinv = _basis(tau, degree)
+        coeffs = pinv @ np.vstack([r[i0:i1], v[i0:i1] * half])
+        ok = (
+            np.abs(vander @ coeffs - r[i0:i1]).max() <= tolerance
+            and np.abs(dvander @ coeffs / half - v[i0:i1]).max() <= velocity_tolerance
+        )
+        return coeffs.T, ok
+
+    out = []
+    i0 = 0
+    while i0 < n - 1:
+        good, bad = 0, 0
+        steps = min(min_steps, n - 1 - i0)
+        while True:  # doubling
+            _, ok = fit(i0, steps)
+            if not ok:
+                bad = steps
+                break
+            good = steps
+            if i0 + steps == n - 1:
+                break
+            steps = min(2 * steps, n - 1 - i0)
+        while bad - good > 1:  # bisection
+            mid = (good + bad) // 2
+            if fit(i0, mid)[1]:
+                good = mid
+            else:
+                bad = mid
+        # A single step is kept even above tolerance (under-resolved motion)
+        good = max(good, 1)
+        coeffs, _ = fit(i0, good)
+        out.append((float(t[i0]), float(t[i0 + good]), coeffs))
+        i0 += good
+    return out
+
+
+@lru_cache(maxsize=64)
+def _uniform_basis(steps: int, degree: int) -> Tuple[FloatArray, ...]:
+    return _basis(np.linspace(-1.0, 1.0, steps + 1), degree)
+
+
+def _basis(tau: FloatArray, degree: int) -> Tuple[FloatArray, ...]:
+    """Chebyshev values, tau-derivatives and the pseudo-inverse of the stacked
+    [position; velocity] least-squares system"""
+    vander = chebyshev.chebvander(tau, degree)
+    derivative = np.zeros((degree + 1, degree + 1))
+    for k in range(1, degree + 1):
+        derivative[k, :k] = chebyshev.chebder(np.eye(degree + 1)[k])[:k]
+    dvander = vander @ derivative.T
+    pinv = np.linalg.pinv(np.vstack([vander, dvander]))
+    return vander, dvander, pinv
+
+
+def write_simephem(
+    filename: Path,
+    sim: SimstateMemmap,
+    tolerance: float,
+    degree: int = DEFAULT_DEGREE,
+    velocity_tolerance: float | None = None,
+) -> None:
+    """Compress a trajectory into a .simephem file, see `fit_chebyshev`"""
+    first_segment, bounds, coeffs = fit_chebyshev(
+        sim, tolerance, degree, velocity_tolerance
+    )
+    with open(filename, "wb") as f:
+        f.write(
+            struct.pack(
+                HEADER_FMT,
+                MAGIC,
+                VERSION,
+                sim.bodies,
+                degree,
+                bounds.shape[0],
+                float(bounds[:, 0].min()),
+                float(bounds[:, 1].max()),
+                b"\x00" * 20,
+            )
+        )
+        first_segment.astype("<u8").tofile(f)
+        bounds.astype("<f8").tofile(f)
+        coeffs.astype("<f8").tofile(f)
+
+
+class SimephemMemmap:
+    """Chebyshev ephemeris file with native evaluation at arbitrary times"""
+
+    def __init__(self, filename: Path) -> None:
+        with open(filename, "rb") as f:
+            magic, version, bodies, degree, segments, t_start, t_stop, _ = (
+                struct.unpack(HEADER_FMT, f.read(HEADER_SIZE))
+            )
+        if magic != MAGIC:
+            raise ValueError("Not a SIMEPHEM file")
+        if version != VERSION:
+            raise ValueError(f"File version {version} != expected {VERSION}")
+
+        self.bodies = bodies
+        self.degree = degree
+        self.t_start = t_start
+        self.t_stop = t_stop
+
+        offset = HEADER_SIZE
+        self.first_segment = np.memmap(
+            filename, dtype="<u8", mode="r", offset=offset, shape=(bodies + 1,)
+        )
+        offset += self.first_segment.nbytes
+        self.bounds = np.memmap(
+            filename, dtype="<f8", mode="r", offset=offset, shape=(segments, 2)
+        )
+        offset += self.bounds.nbytes
+        self.coeffs = np.memmap(
+            filename,
+            dtype="<f8",
+            mode="r",
+            offset=offset,
+            shape=(segments, 3, degree + 1),
+        )
+
+        self.native = ChebyshevEphemeris(
+            self.first_segment.astype(np.intp), self.bounds, self.coeffs
+        )
+
+    def state(
+        self, t: FloatArray | float, body: IntArray | int, threads: int = 0
+    ) -> FloatArray:
+        """States [r, v] of shape (k, 6) at times `t` [s] of bodies `body`,
+        broadcast against each other, on `threads` threads (0: all cores)"""
+        return self.native.evaluate(*_queries(t, body), threads)
+
+
+class HermiteInterpolator:
+    """Cubic Hermite interpolation of a stored trajectory between steps
+
+    Uncompressed files are evaluated in place on the memory map. For
+    compressed files only the steps bracketing the queries are decoded.
+    """
+
+    def __init__(self, sim: SimstateMemmap) -> None:
+        self.sim = sim
+        self.native = None
+        if isinstance(sim.mm, np.ndarray):
+            self.native = HermiteTrajectory(
+                sim.mm, max(sim.dt, 0.0), None if sim.dt > 0 else sim.t
+            )
+
+    def state(
+        self, t: FloatArray | float, body: IntArray | int, threads: int = 0
+    ) -> FloatArray:
+        """States [r, v] of shape (k, 6) at times `t` [s] of bodies `body`,
+        broadcast against each other, on `threads` threads (0: all cores)"""
+        times, bodies = _queries(t, body)
+        if self.native is not None:
+            return self.native.evaluate(times, bodies, threads)
+        if times.size == 0:
+            return np.empty((0, 6))
+
+        sim = self.sim
+        before = np.minimum(sim.step_at(times), sim.steps - 2).astype(np.intp)
+        rows = np.unique(np.concatenate([before, before + 1]))
+        row_times = rows * float(sim.dt) if sim.dt > 0 else np.asarray(sim.t[rows])
+        native = HermiteTrajectory(np.asarray(sim.mm[rows]), 0.0, row_times)
+        return native.evaluate(times, bodies, threads)
+
+
+def load_ephemeris(filename: Path) -> SimephemMemmap | HermiteInterpolator:
+    """Batch query interface of a .simephem or .simstate file"""
+    if Path(filename).suffix == SIMEPHEM_EXTENSION:
+        return SimephemMemmap(filename)
+    return HermiteInterpolator(SimstateMemmap(filename))
+
+
+def _queries(
+    t: FloatArray | float, body: IntArray | int
+) -> Tuple[FloatArray, IntArray]:
+    """Broadcast query times and bodies to flat contiguous arrays"""
+    t_b, body_b = np.broadcast_arrays(
+        np.asarray(t, dtype=np.float64), np.asarray(body, dtype=np.intp)
+    )
+    return np.ascontiguousarray(t_b.ravel()), np.ascontiguousarray(body_b.ravel())
@@ -0,0 +1,104 @@
+# SPDX-FileCopyrightText: © 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+#
+# SPDX-License-Identifier: AGPL-3.0-or-later
+
+"""Spherical-harmonic gravity field module"""
+
+import tomllib
+from datetime import datetime
+from pathlib import Path
+from typing import Any, Dict, List
+
+import numpy as np
+
+from project.simulation.cpp_force_kernel import HarmonicField
+from project.utils import Dir, FloatArray
+from project.utils.data import BodyList
+from project.utils.time_utils import T
+
+J2000 = datetime(2000, 1, 1, 12, 0, 0)
+
+
+def load_gravity_fields(
+    body_list: BodyList,
+    file_path: Path = Dir.data / "gravity_fields.toml",
+    degree: int | None = None,
+    cutoff: float = np.inf,
+) -> List[HarmonicField]:
+    """Build native fields for the bodies of `body_list` found in `file_path`
+
+    Parameters
+    ----------
+    body_list : BodyList
+        Bodies to propagate; its metadata epoch (if any) is t = 0, otherwise
+        J2000 is assumed
+    file_path : Path, optional
+        Field definitions, by default data/gravity_fields.toml
+    degree : int | None, optional
+        Truncate every field to this degree and order, by default the full
+        tables
+    cutoff : float, optional
+        Distance from a primary beyond which it acts as a point mass [m],
+        by default no cutoff
+
+    Returns
+    -------
+    List[HarmonicField]
+        Native fields, in body order
+    """
+    with open(file_path, "rb") as f:
+        definitions = {d["name"]: d for d in tomllib.load(f)["gravity_field"]}
+
+    days = 0.0
+    if body_list.metadata and "epoch" in body_list.metadata:
+        epoch = datetime.strptime(body_list.metadata["epoch"], "%Y-%m-%d %H:%M:%S")
+        days = (epoch - J2000).total_seconds() / T.d
+
+    fields = []
+    for i, body in enumerate(body_list):
+        if body.name not in definitions:
+            continue
+        d = definitions[body.name]
+        c, s = _coefficients(d, degree)
+        w_0, w_dot = d.get("w", [0.0, 0.0])
+        pole_ra, pole_dec = d.get("pole", [0.0, 90.0])
+        fields.append(
+            HarmonicField(
+                i,
+                d["radius"],
+                c,
+                s,
+                pole_ra=np.radians(pole_ra),
+                pole_dec=np.radians(pole_dec),
+                w_0=np.radians(w_0 + w_dot * days),
+                w_dot=np.radians(w_dot) / T.d,
+                cutoff=cutoff,
+            )
+        )
+    return fields
+
+
+def _coefficients(
+    definition: Dict[str, Any], degree: int | None
+) -> tuple[FloatArray, FloatArray]:
+    """Normalized (C, S) tables of shape (degree + 1, order + 1)"""
+    j = definition.get("j", [])
+    rows = definition.get("coefficients", [])
+
+    max_degree = max([len(j) + 1] + [int(r[0]) for r in rows])
+    max_order = max([0] + [int(r[1]) for r in rows])
+    if degree is not None:
+        max_degree = min(max_degree, degree)
+        max_order = min(max_order, degree)
+
+    c = np.zeros((max_degree + 1, max_order + 1))
+    s = np.zeros_like(c)
+    for n, j_n in enumerate(j, start=2):
+        if n <= max_degree:
+            c[n, 0] -= j_n / np.sqrt(2 * n + 1)
+    for n, m, c_nm, s_nm in rows:
+        n, m = int(n), int(m)
+        if n <= max_degree and m <= max_order:
+            c[n, m] += c_nm
+            s[n, m] += s_nm
+    return c, s
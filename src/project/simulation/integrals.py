@@ -2,79 +2,34 @@
 #
 # SPDX-License-Identifier: AGPL-3.0-or-later
 
+import os
 import time
+from contextlib import nullcontext
 from pathlib import Path
+from types import TracebackType
+from typing import Callable, ContextManager, Type
 
-import numba as nb
 import numpy as np
 
-from project.utils import Float, FloatArray, print_done, print_progress
-from project.utils.siminteg import SIMINTEG_FILE, SimintegMemmap, write_siminteg
-from project.utils.simstate import SimstateMemmap
+from project.simulation.cpp_force_kernel import integrals_cpp
+from project.utils import FloatArray, print_done, print_progress
+from project.utils.siminteg import (
+    INTEG_DIM,
+    SIMINTEG_FILE,
+    SimintegMemmap,
+    SimintegWriter,
+    integ_filename,
+    integ_rows,
+)
+from project.utils.simstate import (
+    SimstateMemmap,
+    parse_simstate_filename,
+    partial_filename,
+    simstate_view_from_state_view,
+)
 
 G = 6.67430e-11
-
-
-# ============================================================================
-# Internal helpers
-# ============================================================================
-
-
-def _pairwise_potential_energy(r: FloatArray, mu: FloatArray) -> Float:
-    """
-    Compute total gravitational potential energy for one timestep.
-
-    Parameters
-    ----------
-    r : (3, n) array
-        Positions
-    mu : (n,) array
-        Gravitational parameters (G*m)
-
-    Returns
-    -------
-    float
-        Total potential energy
-    """
-    n = r.shape[1]
-    i_idx, j_idx = np.triu_indices(n, k=1)
-    r_i = r[:, i_idx]
-    r_j = r[:, j_idx]
-    dr = r_i - r_j
-    dist = np.linalg.norm(dr, axis=0)
-    with np.errstate(divide="ignore", invalid="ignore"):
-        U: FloatArray = -(mu[i_idx] * mu[j_idx]) / (G * dist)
-    return np.nansum(U)
-
-
-@nb.njit(fastmath=True, cache=True)
-def _pairwise_potential_energy_numba(r: FloatArray, mu: FloatArray, G: float) -> Float:
-    n = r.shape[1]
-    U = 0.0
-
-    for i in range(n):
-        xi = r[0, i]
-        yi = r[1, i]
-        zi = r[2, i]
-
-        mui = mu[i]
-
-        for j in range(i + 1, n):
-            dx = xi - r[0, j]
-            dy = yi - r[1, j]
-            dz = zi - r[2, j]
-
-            r2 = dx * dx + dy * dy + dz * dz
-            inv_r = 1.0 / np.sqrt(r2)
-
-            U -= mui * mu[j] * inv_r / G
-
-    return U
-
-
-# ============================================================================
-# Main integrals calculation
-# ============================================================================
+BLOCK_STEPS = 1 << 16  # steps per native call (progress, bounded decoding)
 
 
 def calculate_integrals(
@@ -82,9 +37,16 @@ def calculate_integrals(
     mu: FloatArray,
     cache_file: Path | None = None,
     verbose: bool = True,
+    threads: int = 0,
 ) -> FloatArray:
     """
-    Compute total energy and angular momentum time history.
+    Compute total energy, angular and linear momentum and center of mass
+    time history.
+
+    Steps are evaluated natively, in parallel, block by block straight from
+    the trajectory map; with a cache file each block is appended to it and
+    committed instead of kept in memory, so an interrupted computation
+    resumes from its last block.
 
     Parameters
     ----------
@@ -96,60 +58,184 @@ def calculate_integrals(
         Optional .siminteg cache file
     verbose : bool
         Print progress
+    threads : int
+        Worker threads, by default all cores
 
     Returns
     -------
-    integrals : (steps, 4) array
+    integrals : (steps, 10) array
         Column 0: total energy
         Columns 1-3: angular momentum vector
+        Columns 4-6: linear momentum vector
+        Columns 7-9: center of mass position
+        (a cache recorded during propagation may hold every stride-th step
+        only, see `SimintegMemmap.stride`)
     """
     n_steps = sim.steps
-    masses = mu / G
+    mu = np.ascontiguousarray(mu, dtype=np.float64)
+
+    if not cache_file:
+        integrals = np.empty((n_steps, INTEG_DIM), dtype=np.float64)
+        _integrals_blocks(sim, mu, 0, threads, verbose, integrals.__setitem__)
+        return integrals
 
     # Use cache if available
-    if cache_file and cache_file.exists():
+    if cache_file.exists() and SimintegMemmap(cache_file).complete:
         if verbose:
             print(f"Loading integrals from cache: {cache_file}")
-        mm = np.memmap(cache_file, dtype="float64", mode="r", shape=(n_steps, 4))
-        return np.array(mm)
-
-    integrals = np.zeros((n_steps, 4), dtype=np.float64)
+        return SimintegMemmap(cache_file).mm
 
+    with SimintegWriter(cache_file, n_steps, INTEG_DIM, sim.dt) as writer:
+        if verbose:
+            verb = "Resuming" if writer.rows else "Writing"
+            print(f"{verb} integrals cache: {cache_file}")
+        _integrals_blocks(
+            sim,
+            mu,
+            writer.rows,
+            threads,
+            verbose,
+            lambda _, rows: writer.append(rows),
+        )
+    return SimintegMemmap(cache_file).mm
+
+
+def _integrals_blocks(
+    sim: SimstateMemmap,
+    mu: FloatArray,
+    first: int,
+    threads: int,
+    verbose: bool,
+    emit: Callable[[slice, FloatArray], None],
+) -> None:
+    """Integrals of steps `first`.. of `sim`, handed to `emit` block by block"""
+    n_steps = sim.steps
     start_time = time.time()
     if verbose:
-        print("Calculating energy and angular momentum...")
-
-    for t in range(n_steps):
-        if verbose and t % 10000 == 0:
-            print_progress(t, n_steps, start_time)
-
-        # Positions & velocities (shape: 3 x n)
-        r = sim.r_vis[t][0]
-        v = sim.v_vis[t][0]
+        print("Calculating energy and momenta...")
 
-        # Kinetic energy
-        T = 0.5 * np.sum(masses * np.sum(v**2, axis=0))
+    sim.advise("sequential", first)
+    out = np.empty((min(BLOCK_STEPS, n_steps), INTEG_DIM), dtype=np.float64)
+    for start in range(first, n_steps, BLOCK_STEPS):
+        if verbose:
+            print_progress(start, n_steps, start_time)
+        stop = min(start + BLOCK_STEPS, n_steps)
+        block = out[: stop - start]
+        integrals_cpp(np.asarray(sim.mm[start:stop]), mu, G, block, threads)
+        emit(slice(start, stop), block)
 
-        # Potential energy
-        U = _pairwise_potential_energy_numba(r, mu, G)
+    if verbose:
+        print_done()
 
-        # Total energy
-        integrals[t, 0] = T + U
 
-        # Angular momentum vector
-        p = masses[None, :] * v
-        integrals[t, 1:] = np.sum(np.cross(r, p, axis=0), axis=1)
+class IntegralRecorder:
+    """
+    Integrals of a propagation recorded as its chunks are produced, so the
+    trajectory never has to be read back.
 
-    if verbose:
-        print_done()
+    Every `stride`-th step is evaluated natively from the chunk in memory
+    and appended to a .siminteg file, built as `<filename>.part` and
+    renamed on close like `SimstateWriter` does.
 
-    # Save to cache
-    if cache_file:
-        if verbose:
-            print(f"\nSaving integrals to cache: {cache_file}")
-        write_siminteg(cache_file, integrals)
+    Parameters
+    ----------
+    filename : Path
+        Output .siminteg file (name__dt__steps.siminteg)
+    steps : int
+        Steps of the propagation, including the initial state
+    dt : float
+        Time step [s]
+    mu : (n,) array
+        Gravitational parameters (G*m)
+    stride : int, optional
+        Steps between recorded rows, by default every step
+    resume : int, optional
+        Steps already recorded in `<filename>.part` by an interrupted run,
+        whose rows are kept; by default the file is started over
+    keep_partial : bool, optional
+        Keep `<filename>.part` when aborted, to resume it later
+    """
 
-    return integrals
+    def __init__(
+        self,
+        filename: Path,
+        steps: int,
+        dt: float,
+        mu: FloatArray,
+        stride: int = 1,
+        resume: int = 0,
+        keep_partial: bool = False,
+    ) -> None:
+        self.filename = filename
+        self.steps = steps
+        self.stride = stride
+        self.recorded = resume  # steps seen so far
+        self._keep_partial = keep_partial
+        self._mu = np.ascontiguousarray(mu, dtype=np.float64)
+        self._part = partial_filename(filename)
+        if not resume:
+            self._part.unlink(missing_ok=True)  # left by an earlier failed run
+        self._out = SimintegWriter(self._part, steps, INTEG_DIM, dt, stride)
+        if resume:
+            self._out.rewind(integ_rows(resume, stride))
+
+    def record(self, chunk: FloatArray) -> None:
+        """Next rows of the propagation, (rows, 6n) as [r (3n), v (3n)]"""
+        data = simstate_view_from_state_view(chunk, self._mu.size)
+        first = -self.recorded % self.stride
+        picked = np.ascontiguousarray(data[first :: self.stride], dtype=np.float64)
+        rows = np.empty((picked.shape[0], INTEG_DIM), dtype=np.float64)
+        integrals_cpp(picked, self._mu, G, rows)
+        self._out.append(rows)
+        self.recorded += chunk.shape[0]
+
+    def close(self) -> None:
+        """Finish the file; raises if steps are missing"""
+        self._out.close()
+        if self.recorded != self.steps:
+            self._part.unlink(missing_ok=True)
+            raise ValueError(
+                f"{self.recorded} steps recorded, header expects {self.steps}"
+            )
+        os.replace(self._part, self.filename)
+
+    def abort(self) -> None:
+        """Drop the partial file, unless kept to resume it"""
+        self._out.close()
+        if not self._keep_partial:
+            self._part.unlink(missing_ok=True)
+
+    def __enter__(self) -> "IntegralRecorder":
+        return self
+
+    def __exit__(
+        self,
+        exc_type: Type[BaseException] | None,
+        exc: BaseException | None,
+        tb: TracebackType | None,
+    ) -> None:
+        if exc_type is None:
+            self.close()
+        else:
+            self.abort()
+
+
+def record_integrals(
+    filename: Path,
+    steps: int,
+    every: int | None,
+    mu: FloatArray | None,
+    resume: int = 0,
+    keep_partial: bool = False,
+) -> ContextManager[IntegralRecorder | None]:
+    """Recorder of the integrals of trajectory `filename` (steps, dt from
+    its name) every `every` steps, or a no-op context when `every` is None"""
+    if every is None or mu is None:
+        return nullcontext()
+    _, dt, _ = parse_simstate_filename(filename)
+    return IntegralRecorder(
+        integ_filename(filename), steps, dt, mu, every, resume, keep_partial
+    )
 
 
 if __name__ == "__main__":
@@ -174,31 +260,32 @@ if __name__ == "__main__":
     integ_cache = Dir.simulation / SIMINTEG_FILE.format(sim.name, sim.dt, sim.steps)
 
     # Calculate with caching
-    integ = calculate_integrals(sim.mm, mu_arr, integ_cache)
+    calculate_integrals(sim.mm, mu_arr, integ_cache)
     int_mm = SimintegMemmap(integ_cache)
 
-    # Plot
-    h_0 = int_mm.h[0]
-    t_ = sim.mm.t / 3600 / 24  # convert to days
+    # Plot drift envelopes from the per-chunk summary, not the full columns
+    t_e, lo_e, hi_e = int_mm.envelope(0)
+    e_0 = int_mm.e[0]
+    t_px, lo_px, hi_px = int_mm.envelope(4)
 
     plt.figure(figsize=(12, 8))
 
     plt.subplot(2, 1, 1)
-    plt.plot(t_, (int_mm.h[:] - h_0) / h_0 * 100, label="Specific angular momentum")
+    plt.fill_between(
+        t_e / 3600 / 24,
+        (lo_e - e_0) / e_0 * 100,
+        (hi_e - e_0) / e_0 * 100,
+        label="Total Energy",
+    )
     plt.ylabel("Change [%]")
-    plt.title("Change in Angular Momentum")
+    plt.title("Change in Energy")
     plt.legend()
 
     plt.subplot(2, 1, 2)
-    plt.plot(
-        t_,
-        (int_mm.e - int_mm.e[0]) / int_mm.e[0] * 100,
-        label="Total Energy",
-        linewidth=2,
-    )
-    plt.ylabel("Change [%]")
+    plt.fill_between(t_px / 3600 / 24, lo_px, hi_px, label="Linear momentum x")
+    plt.ylabel("Momentum [kg m/s]")
     plt.xlabel("Time [days]")
-    plt.title("Change in Energy Components")
+    plt.title("Linear Momentum Drift")
     plt.legend()
 
     plt.tight_layout()
@@ -4,7 +4,17 @@
 
 """Integrator module"""
 
-from typing import Callable, Concatenate, Protocol, runtime_checkable
+from pathlib import Path
+from typing import (
+    Callable,
+    Concatenate,
+    Dict,
+    Iterable,
+    Iterator,
+    List,
+    Protocol,
+    runtime_checkable,
+)
 
 import numpy as np
 
@@ -42,6 +52,47 @@ class EulerCapable(Protocol[P]):
     ) -> FloatArray: ...
 
 
+@runtime_checkable
+class RK4StreamCapable(Protocol[P]):
+    def _rk4_chunks(
+        self,
+        state: FloatArray,
+        time_step: float,
+        stop_time: float,
+        chunk_steps: int,
+        *args: P.args,
+        **kwargs: P.kwargs,
+    ) -> Iterator[FloatArray]: ...
+
+
+@runtime_checkable
+class EulerStreamCapable(Protocol[P]):
+    def _euler_chunks(
+        self,
+        state: FloatArray,
+        time_step: float,
+        stop_time: float,
+        chunk_steps: int,
+        *args: P.args,
+        **kwargs: P.kwargs,
+    ) -> Iterator[FloatArray]: ...
+
+
+@runtime_checkable
+class RK4FileCapable(Protocol[P]):
+    def _rk4_to_file(
+        self,
+        state: FloatArray,
+        time_step: float,
+        stop_time: float,
+        filename: Path,
+        chunk_steps: int,
+        integrals_every: int | None,
+        *args: P.args,
+        **kwargs: P.kwargs,
+    ) -> Dict[str, float]: ...
+
+
 class Integrator:
     @staticmethod
     def euler(
@@ -127,6 +178,86 @@ class Integrator:
             state, time_step, stop_time, func, progress, print_step, *args, **kwargs
         )
 
+    @staticmethod
+    def euler_chunks(
+        state: FloatArray,
+        time_step: float,
+        stop_time: float,
+        func: FunctionProtocol[P],
+        chunk_steps: int = 10_000,
+        *args: P.args,
+        **kwargs: P.kwargs,
+    ) -> Iterator[FloatArray]:
+        """Euler integrator yielding the trajectory in chunks
+
+        Parameters
+        ----------
+        state : A
+            Initial state vector
+        time_step : float
+            Time step [s]
+        stop_time : float
+            Stop time [s]
+        func : FunctionProtocol[P]
+            Function to integrate
+        chunk_steps : int, optional
+            Steps per chunk, by default 10_000
+
+        Returns
+        -------
+        Iterator[A]
+            Consecutive row blocks of the trajectory, the first one starting
+            with the initial state. Peak memory is one chunk
+        """
+        if isinstance(func, EulerStreamCapable):
+            return func._euler_chunks(
+                state, time_step, stop_time, chunk_steps, *args, **kwargs
+            )
+
+        return Integrator._euler_chunks(
+            state, time_step, stop_time, func, chunk_steps, *args, **kwargs
+        )
+
+    @staticmethod
+    def rk4_chunks(
+        state: FloatArray,
+        time_step: float,
+        stop_time: float,
+        func: FunctionProtocol[P],
+        chunk_steps: int = 10_000,
+        *args: P.args,
+        **kwargs: P.kwargs,
+    ) -> Iterator[FloatArray]:
+        """Runge-Kutta 4 integrator yielding the trajectory in chunks
+
+        Parameters
+        ----------
+        state : A
+            Initial state vector
+        time_step : float
+            Time step [s]
+        stop_time : float
+            Stop time [s]
+        func : FunctionProtocol[P]
+            Function to integrate
+        chunk_steps : int, optional
+            Steps per chunk, by default 10_000
+
+        Returns
+        -------
+        Iterator[A]
+            Consecutive row blocks of the trajectory, the first one starting
+            with the initial state. Peak memory is one chunk
+        """
+        if isinstance(func, RK4StreamCapable):
+            return func._rk4_chunks(
+                state, time_step, stop_time, chunk_steps, *args, **kwargs
+            )
+
+        return Integrator._rk4_chunks(
+            state, time_step, stop_time, func, chunk_steps, *args, **kwargs
+        )
+
     @staticmethod
     def _euler(
         state: FloatArray,
@@ -160,36 +291,22 @@ class Integrator:
         A
             Integrated function
         """
-        # Define time array
-        time_array_seconds = np.arange(
-            start=0,
-            stop=stop_time + time_step,  # Include last point
-            step=time_step,
-            dtype=np.float64,
+        steps = _numpy_steps(time_step, stop_time)
+        chunks = Integrator._euler_chunks(
+            state,
+            time_step,
+            stop_time,
+            func,
+            print_step if progress else steps,
+            *args,
+            **kwargs,
         )
-        steps = time_array_seconds.size
-        dim = state.size
-        # Initialize full state vector
-        y = np.zeros((steps, dim))
-        if progress:
-            pt = ProgressTracker(
-                n=steps, print_step=print_step, name="Integrating Euler"
-            )
-        # Perform Euler integration
-        y[0, :] = state
-
-        # Euler buffer
-        tmp = np.empty(dim)
+        if not progress:
+            return next(chunks)
 
-        for i in range(steps - 1):
-            func(y[i, :], tmp, *args, **kwargs)
-            y[i + 1, :] = y[i, :] + time_step * tmp
-            if progress:
-                pt.print(i=i)
-        if progress:
-            pt.print(i=steps)
-
-        return y
+        return _gather_chunks(
+            chunks, steps=steps, print_step=print_step, name="Integrating Euler"
+        )
 
     @staticmethod
     def _rk4(
@@ -224,21 +341,63 @@ class Integrator:
         A
             Integrated function
         """
-        # Define time array
-        time_array_seconds = np.arange(
-            start=0,
-            stop=stop_time + time_step,  # Include last point
-            step=time_step,
-            dtype=np.float64,
+        steps = _numpy_steps(time_step, stop_time)
+        chunks = Integrator._rk4_chunks(
+            state,
+            time_step,
+            stop_time,
+            func,
+            print_step if progress else steps,
+            *args,
+            **kwargs,
+        )
+        if not progress:
+            return next(chunks)
+
+        return _gather_chunks(
+            chunks, steps=steps, print_step=print_step, name="Integrating RK4"
+        )
+
+    @staticmethod
+    def _euler_chunks(
+        state: FloatArray,
+        time_step: float,
+        stop_time: float,
+        func: Callable[Concatenate[FloatArray, FloatArray, P], None],
+        chunk_steps: int = 10_000,
+        *args: P.args,
+        **kwargs: P.kwargs,
+    ) -> Iterator[FloatArray]:
+        """Euler integrator in chunks (numpy implementation)"""
+        dim = state.size
+
+        # Euler buffer
+        tmp = np.empty(dim)
+
+        def propagate(y_0: FloatArray, rows: int) -> FloatArray:
+            y = np.empty((rows, dim))
+            y[0, :] = y_0
+            for i in range(rows - 1):
+                func(y[i, :], tmp, *args, **kwargs)
+                y[i + 1, :] = y[i, :] + time_step * tmp
+            return y
+
+        return _trajectory_chunks(
+            propagate, state, _numpy_steps(time_step, stop_time), chunk_steps
         )
-        steps = time_array_seconds.size
+
+    @staticmethod
+    def _rk4_chunks(
+        state: FloatArray,
+        time_step: float,
+        stop_time: float,
+        func: Callable[Concatenate[FloatArray, FloatArray, P], None],
+        chunk_steps: int = 10_000,
+        *args: P.args,
+        **kwargs: P.kwargs,
+    ) -> Iterator[FloatArray]:
+        """Runge-Kutta 4 integrator in chunks (numpy implementation)"""
         dim = state.size
-        # Initialize full state vector
-        y = np.zeros((steps, dim))
-        if progress:
-            pt = ProgressTracker(n=steps, print_step=print_step, name="Integrating RK4")
-        # Perform RK4 integration
-        y[0, :] = state
 
         # RK buffers
         k1 = np.empty(dim)
@@ -246,15 +405,68 @@ class Integrator:
         k3 = np.empty(dim)
         k4 = np.empty(dim)
 
-        for i in range(steps - 1):
-            func(y[i, :], k1, *args, **kwargs)
-            func(y[i, :] + k1 * time_step / 2, k2, *args, **kwargs)
-            func(y[i, :] + k2 * time_step / 2, k3, *args, **kwargs)
-            func(y[i, :] + k3 * time_step, k4, *args, **kwargs)
-            y[i + 1, :] = y[i, :] + time_step / 6 * (k1 + 2 * k2 + 2 * k3 + k4)
-            if progress:
-                pt.print(i=i)
-        if progress:
-            pt.print(i=steps)
-
-        return y
+        def propagate(y_0: FloatArray, rows: int) -> FloatArray:
+            y = np.empty((rows, dim))
+            y[0, :] = y_0
+            for i in range(rows - 1):
+                func(y[i, :], k1, *args, **kwargs)
+                func(y[i, :] + k1 * time_step / 2, k2, *args, **kwargs)
+                func(y[i, :] + k2 * time_step / 2, k3, *args, **kwargs)
+                func(y[i, :] + k3 * time_step, k4, *args, **kwargs)
+                y[i + 1, :] = y[i, :] + time_step / 6 * (k1 + 2 * k2 + 2 * k3 + k4)
+            return y
+
+        return _trajectory_chunks(
+            propagate, state, _numpy_steps(time_step, stop_time), chunk_steps
+        )
+
+
+def _numpy_steps(time_step: float, stop_time: float) -> int:
+    """Number of rows of the numpy integrators, last point included"""
+    return np.arange(
+        start=0,
+        stop=stop_time + time_step,  # Include last point
+        step=time_step,
+        dtype=np.float64,
+    ).size
+
+
+def _trajectory_chunks(
+    propagate: Callable[[FloatArray, int], FloatArray],
+    state: FloatArray,
+    steps: int,
+    chunk_steps: int,
+) -> Iterator[FloatArray]:
+    """Yield a trajectory of `steps` rows in chunks of at most `chunk_steps` steps.
+
+    `propagate(y_0, rows)` must return `rows` rows starting with `y_0`. The
+    first chunk includes the initial state, later chunks start from the row
+    after the previous chunk's last one.
+    """
+    rows = min(chunk_steps + 1, steps)
+    y = propagate(state, rows)
+    yield y
+    done = rows
+    while done < steps:
+        rows = min(chunk_steps, steps - done)
+        y = propagate(y[-1], rows + 1)
+        yield y[1:]
+        done += rows
+
+
+def _gather_chunks(
+    chunks: Iterable[FloatArray],
+    steps: int,
+    print_step: int,
+    name: str,
+) -> FloatArray:
+    pt = ProgressTracker(n=steps, print_step=print_step, name=name)
+    out: List[FloatArray] = []
+    done = -1  # the initial state is not a step
+    for chunk in chunks:
+        out.append(chunk)
+        done += chunk.shape[0]
+        pt.print(i=done)
+    pt.print(i=steps)
+
+    return np.vstack(out)
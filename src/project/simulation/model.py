@@ -4,14 +4,55 @@
 
 """Force model kernels module"""
 
-from typing import List, cast
+import os
+import time
+from pathlib import Path
+from typing import (
+    Callable,
+    Dict,
+    Iterator,
+    Literal,
+    Sequence,
+    Tuple,
+    cast,
+)
 
 import numba as nb
 import numpy as np
 
-from project.simulation.cpp_force_kernel import point_mass_cpp
-from project.simulation.integrator import FunctionProtocol
-from project.utils import FloatArray, ProgressTracker
+from project.simulation.cpp_force_kernel import (
+    SPEED_OF_LIGHT,
+    HarmonicField,
+    eih_cpp,
+    harmonic_cpp,
+    point_mass_cpp,
+    point_mass_cpp_dd,
+    point_mass_cpp_f32,
+    rk4_cpp,
+    rk4_cpp_dd,
+    rk4_cpp_dual,
+    rk4_cpp_f32,
+    rk4_eih_cpp,
+    rk4_harmonic_cpp,
+    rk4_simstate_cpp,
+)
+from project.simulation.integrator import (
+    FunctionProtocol,
+    _gather_chunks,
+    _trajectory_chunks,
+)
+from project.simulation.integrals import G, record_integrals
+from project.utils import FloatArray
+from project.utils.siminteg import INTEG_DIM, finish_siminteg, integ_filename
+from project.utils.siminteg import pack_header as pack_integ_header
+from project.utils.simstate import (
+    SimstateWriter,
+    pack_header,
+    parse_simstate_filename,
+    partial_filename,
+)
+
+Precision = Literal["f32", "f64", "dd"]
 
 
 class NumpyPointMass(FunctionProtocol):
@@ -37,70 +78,442 @@ class NumbaPointMass(FunctionProtocol):
         progress: bool = True,
         print_step: int = 10_000,
     ) -> FloatArray:
+        return _collect_chunks(
+            self._rk4_chunks,
+            state,
+            time_step,
+            stop_time,
+            n,
+            mu,
+            progress,
+            print_step,
+            name="Integrating Numba RK4",
+        )
+
+    def _rk4_chunks(
+        self,
+        state: FloatArray,
+        time_step: float,
+        stop_time: float,
+        chunk_steps: int,
+        n: int,
+        mu: FloatArray,
+    ) -> Iterator[FloatArray]:
         steps = int(stop_time / time_step) + 1
         state_buffer = np.empty_like(state)
 
-        if not progress:
+        def propagate(y_0: FloatArray, rows: int) -> FloatArray:
             return cast(
-                FloatArray, _rk4_numba(state, time_step, steps, n, mu, state_buffer)
+                FloatArray, _rk4_numba(y_0, time_step, rows, n, mu, state_buffer)
             )
 
-        pt = ProgressTracker(
-            n=steps, print_step=print_step, name="Integrating Numba RK4"
+        return _trajectory_chunks(propagate, state, steps, chunk_steps)
+
+
+class CPPPointMass(FunctionProtocol):
+    """Native point-mass kernel and RK4 driver.
+
+    Parameters
+    ----------
+    precision : Precision, optional
+        Scalar type used natively: "f32" for fast previews, "f64" for
+        production runs, "dd" (double-double) for high-accuracy references.
+        Inputs and outputs are always float64, by default "f64"
+    direct_io : bool, optional
+        Stream trajectory files with O_DIRECT (Linux only), bypassing the
+        page cache for runs much larger than RAM, by default False
+    """
+
+    # direct_io only changes how files are written, not the trajectory
+    key_settings = ("precision",)
+
+    def __init__(self, precision: Precision = "f64", direct_io: bool = False) -> None:
+        self.precision = precision
+        self.direct_io = direct_io
+        self._point_mass, self._rk4, self._pack, self._unpack = _CPP_PRECISIONS[
+            precision
+        ]
+
+    def __call__(
+        self, state: FloatArray, out: FloatArray, n: int, mu: FloatArray
+    ) -> None:
+        if self.precision == "f64":
+            point_mass_cpp(state, mu, out)
+            return
+
+        packed = self._pack(np.empty_like(state))
+        self._point_mass(self._pack(state), self._pack(mu), packed)
+        out[:] = self._unpack(packed)
+
+    def _rk4_backend(
+        self,
+        state: FloatArray,
+        time_step: float,
+        stop_time: float,
+        n: int,
+        mu: FloatArray,
+        progress: bool = True,
+        print_step: int = 10_000,
+    ) -> FloatArray:
+        return _collect_chunks(
+            self._rk4_chunks,
+            state,
+            time_step,
+            stop_time,
+            n,
+            mu,
+            progress,
+            print_step,
+            name=f"Integrating C++ RK4 ({self.precision})",
         )
 
-        out: List[FloatArray] = []
-
-        progress_steps = steps // print_step
-        remainder = steps % print_step
-
-        for i in range(progress_steps):
-            # First batch (including all)
-            if i == 0:
-                out.append(
-                    _rk4_numba(state, time_step, print_step + 1, n, mu, state_buffer)
-                )
-            # Successive batches (not including first element)
-            else:
-                out.append(
-                    _rk4_numba(
-                        out[-1][-1, :], time_step, print_step + 1, n, mu, state_buffer
-                    )[1:, :]
-                )
-
-            pt.print(i=i * print_step)
-
-        # Last batch, only if remainder is not zero
-        if remainder > 0:
-            if progress_steps == 0:
-                last_state = state
-            else:
-                last_state = out[-1][-1, :]
-
-            last = _rk4_numba(
-                last_state,
-                time_step,
-                remainder,
+    def _rk4_chunks(
+        self,
+        state: FloatArray,
+        time_step: float,
+        stop_time: float,
+        chunk_steps: int,
+        n: int,
+        mu: FloatArray,
+    ) -> Iterator[FloatArray]:
+        steps = int(stop_time / time_step) + 1
+        mu_packed = self._pack(mu)
+
+        # Chunks continue from the packed last row, so double-double runs keep
+        # their low words across chunk boundaries
+        def propagate(y_0: FloatArray, rows: int) -> FloatArray:
+            return self._rk4(y_0, time_step, rows, mu_packed)
+
+        return (
+            self._unpack(y)
+            for y in _trajectory_chunks(
+                propagate, self._pack(state), steps, chunk_steps
+            )
+        )
+
+    def _rk4_to_file(
+        self,
+        state: FloatArray,
+        time_step: float,
+        stop_time: float,
+        filename: Path,
+        chunk_steps: int,
+        integrals_every: int | None,
+        n: int,
+        mu: FloatArray,
+    ) -> Dict[str, float]:
+        """Integrate straight into a .simstate file.
+
+        In float64 the native driver fills one staging buffer of
+        `chunk_steps` rows while a writer thread flushes the other, so disk
+        I/O overlaps integration. Other precisions stream their chunks
+        through `SimstateWriter`.
+
+        With `integrals_every`, energy, momenta and center of mass of every
+        `integrals_every`-th step are written to the .siminteg file next to
+        the trajectory. In float64 they are fused into the propagation: the
+        pair potential reuses the inverse distances of the first RK4 stage,
+        and the min/max summary is appended once the rows are streamed.
+
+        Returns
+        -------
+        Dict[str, float]
+            steps, seconds, steps_per_second, write_seconds, stall_seconds
+        """
+        if self.precision != "f64":
+            return _write_chunks(
+                self._rk4_chunks(state, time_step, stop_time, chunk_steps, n, mu),
+                filename,
                 n,
+                integrals_every,
                 mu,
-                state_buffer,
             )
 
-            if remainder > 1 and progress_steps != 0:
-                out.append(last[1:, :])
-            else:
-                out.append(last)
+        _, _, steps_f = parse_simstate_filename(filename)
+        steps = int(stop_time / time_step) + 1
+        if steps != steps_f + 1:
+            raise ValueError(f"{steps - 1} steps do not match filename's {steps_f}")
+
+        part = partial_filename(filename)
+        integ = integ_filename(filename)
+        integ_part = partial_filename(integ)
+        try:
+            stats = rk4_simstate_cpp(
+                self._pack(state),
+                time_step,
+                steps,
+                self._pack(mu),
+                str(part),
+                pack_header(steps, n, 6, time_step),
+                buffer_steps=chunk_steps,
+                direct_io=self.direct_io,
+                integrals_filename="" if integrals_every is None else str(integ_part),
+                integrals_header=pack_integ_header(
+                    steps, INTEG_DIM, time_step, integrals_every or 1
+                ),
+                integrals_every=integrals_every or 1,
+                G=G,
+            )
+        except BaseException:
+            part.unlink(missing_ok=True)
+            integ_part.unlink(missing_ok=True)
+            raise
+        os.replace(part, filename)
+        if integrals_every is not None:
+            finish_siminteg(integ_part)
+            os.replace(integ_part, integ)
+        return stats
+
+
+class CPPHarmonic(FunctionProtocol):
+    """Native point-mass kernel with spherical-harmonic fields of extended
+    primaries, evaluated in the same pair loop.
+
+    Parameters
+    ----------
+    fields : Sequence[HarmonicField]
+        Fields of the oblate primaries, see `harmonics.load_gravity_fields`
+    """
+
+    def __init__(self, fields: Sequence[HarmonicField]) -> None:
+        self.fields = list(fields)
+
+    def __call__(
+        self, state: FloatArray, out: FloatArray, n: int, mu: FloatArray
+    ) -> None:
+        # No time argument here: tesseral terms use the orientation at t = 0
+        harmonic_cpp(state, mu, self.fields, 0.0, out)
+
+    def _rk4_backend(
+        self,
+        state: FloatArray,
+        time_step: float,
+        stop_time: float,
+        n: int,
+        mu: FloatArray,
+        progress: bool = True,
+        print_step: int = 10_000,
+    ) -> FloatArray:
+        return _collect_chunks(
+            self._rk4_chunks,
+            state,
+            time_step,
+            stop_time,
+            n,
+            mu,
+            progress,
+            print_step,
+            name="Integrating C++ RK4 (harmonics)",
+        )
+
+    def _rk4_chunks(
+        self,
+        state: FloatArray,
+        time_step: float,
+        stop_time: float,
+        chunk_steps: int,
+        n: int,
+        mu: FloatArray,
+    ) -> Iterator[FloatArray]:
+        steps = int(stop_time / time_step) + 1
+        start = 0
+
+        # Each chunk restarts the native clock at its first row
+        def propagate(y_0: FloatArray, rows: int) -> FloatArray:
+            nonlocal start
+            y = rk4_harmonic_cpp(
+                y_0, time_step, rows, mu, self.fields, start * time_step
+            )
+            start += rows - 1
+            return y
+
+        return _trajectory_chunks(propagate, state, steps, chunk_steps)
 
-            pt.print(i=steps)
 
-        return np.vstack(out)
+class CPPRelativistic(FunctionProtocol):
+    """Native Einstein-Infeld-Hoffmann (1PN) point-mass kernel.
 
+    Parameters
+    ----------
+    c : float, optional
+        Speed of light [m/s], by default SPEED_OF_LIGHT. Lowering it
+        exaggerates the corrections for testing
+    """
+
+    def __init__(self, c: float = SPEED_OF_LIGHT) -> None:
+        self.c = c
 
-class CPPPointMass(FunctionProtocol):
     def __call__(
         self, state: FloatArray, out: FloatArray, n: int, mu: FloatArray
     ) -> None:
-        point_mass_cpp(state, mu, out)
+        eih_cpp(state, mu, out, self.c)
+
+    def _rk4_backend(
+        self,
+        state: FloatArray,
+        time_step: float,
+        stop_time: float,
+        n: int,
+        mu: FloatArray,
+        progress: bool = True,
+        print_step: int = 10_000,
+    ) -> FloatArray:
+        return _collect_chunks(
+            self._rk4_chunks,
+            state,
+            time_step,
+            stop_time,
+            n,
+            mu,
+            progress,
+            print_step,
+            name="Integrating C++ RK4 (EIH)",
+        )
+
+    def _rk4_chunks(
+        self,
+        state: FloatArray,
+        time_step: float,
+        stop_time: float,
+        chunk_steps: int,
+        n: int,
+        mu: FloatArray,
+    ) -> Iterator[FloatArray]:
+        steps = int(stop_time / time_step) + 1
+
+        def propagate(y_0: FloatArray, rows: int) -> FloatArray:
+            return rk4_eih_cpp(y_0, time_step, rows, mu, self.c)
+
+        return _trajectory_chunks(propagate, state, steps, chunk_steps)
+
+
+def rk4_tangent(
+    state: FloatArray,
+    d_state: FloatArray,
+    time_step: float,
+    stop_time: float,
+    mu: FloatArray,
+    d_mu: FloatArray | None = None,
+) -> Tuple[FloatArray, FloatArray]:
+    """Propagate a trajectory and its directional derivative (dual numbers).
+
+    Parameters
+    ----------
+    state : FloatArray
+        Initial state vector
+    d_state : FloatArray
+        Seed direction for the initial state
+    time_step : float
+        Time step [s]
+    stop_time : float
+        Stop time [s]
+    mu : FloatArray
+        Gravitational parameters
+    d_mu : FloatArray | None, optional
+        Seed direction for mu, by default zero
+
+    Returns
+    -------
+    Tuple[FloatArray, FloatArray]
+        Trajectory (steps, 6*n) and its derivative along the seed
+    """
+    steps = int(stop_time / time_step) + 1
+    if d_mu is None:
+        d_mu = np.zeros_like(mu)
+    y = rk4_cpp_dual(
+        np.stack([state, d_state], axis=-1),
+        time_step,
+        steps,
+        np.stack([mu, d_mu], axis=-1),
+    )
+    return y[..., 0], y[..., 1]
+
+
+def _collect_chunks(
+    rk4_chunks: Callable[..., Iterator[FloatArray]],
+    state: FloatArray,
+    time_step: float,
+    stop_time: float,
+    n: int,
+    mu: FloatArray,
+    progress: bool,
+    print_step: int,
+    name: str,
+) -> FloatArray:
+    """Materialize a `_rk4_chunks` trajectory, reporting progress per chunk"""
+    steps = int(stop_time / time_step) + 1
+    if not progress:
+        return next(rk4_chunks(state, time_step, stop_time, steps, n, mu))
+
+    return _gather_chunks(
+        rk4_chunks(state, time_step, stop_time, print_step, n, mu),
+        steps=steps,
+        print_step=print_step,
+        name=name,
+    )
+
+
+def _write_chunks(
+    chunks: Iterator[FloatArray],
+    filename: Path,
+    n: int,
+    integrals_every: int | None = None,
+    mu: FloatArray | None = None,
+) -> Dict[str, float]:
+    """Serial fallback of `_rk4_to_file`: integrate, then write, chunk by chunk"""
+    start = time.perf_counter()
+    write_seconds = 0.0
+    with (
+        SimstateWriter(filename, n) as writer,
+        record_integrals(filename, writer.steps, integrals_every, mu) as recorder,
+    ):
+        for chunk in chunks:
+            t = time.perf_counter()
+            writer.write(chunk)
+            if recorder is not None:
+                recorder.record(chunk)
+            write_seconds += time.perf_counter() - t
+    seconds = time.perf_counter() - start
+    return {
+        "steps": writer.steps,
+        "seconds": seconds,
+        "steps_per_second": writer.steps / seconds if seconds > 0 else 0.0,
+        "write_seconds": write_seconds,
+        "stall_seconds": 0.0,
+    }
+
+
+def _dd_pack(x: FloatArray) -> FloatArray:
+    return np.stack([x, np.zeros_like(x)], axis=-1)
+
+
+def _dd_unpack(x: FloatArray) -> FloatArray:
+    return cast(FloatArray, x[..., 0] + x[..., 1])
+
+
+_CPP_PRECISIONS: Dict[
+    str,
+    Tuple[
+        Callable[[FloatArray, FloatArray, FloatArray], None],
+        Callable[[FloatArray, float, int, FloatArray], FloatArray],
+        Callable[[FloatArray], FloatArray],
+        Callable[[FloatArray], FloatArray],
+    ],
+] = {
+    "f32": (
+        point_mass_cpp_f32,
+        rk4_cpp_f32,
+        lambda x: x.astype(np.float32),
+        lambda x: x.astype(np.float64),
+    ),
+    "f64": (
+        point_mass_cpp,
+        rk4_cpp,
+        lambda x: np.ascontiguousarray(x, dtype=np.float64),
+        lambda x: x,
+    ),
+    "dd": (point_mass_cpp_dd, rk4_cpp_dd, _dd_pack, _dd_unpack),
+}
 
 
 @nb.njit(fastmath=True, cache=True)
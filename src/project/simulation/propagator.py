@@ -4,12 +4,39 @@
 
 """Propagator module"""
 
+import os
 from pathlib import Path
-from typing import Literal
+from typing import Literal, cast
 
-from project.simulation.integrator import FunctionProtocol, Integrator
+import numpy as np
+from numpy.typing import ArrayLike
+
+from project.simulation.integrals import record_integrals
+from project.simulation.integrator import (
+    FunctionProtocol,
+    Integrator,
+    RK4FileCapable,
+)
+from project.utils import FloatArray, ProgressTracker
 from project.utils.data import BodyList
-from project.utils.simstate import simstate_view_from_state_view, write_simstate
+from project.utils.simcheckpoint import (
+    Checkpoint,
+    checkpoint_filename,
+    force_model_key,
+    read_checkpoint,
+    write_checkpoint,
+)
+from project.utils.siminteg import integ_filename
+from project.utils.simrate import SimrateWriter, write_simrate
+from project.utils.simshards import ShardedSimstateWriter
+from project.utils.simstate import (
+    SIMSTATE_FILE,
+    SimstateMemmap,
+    SimstateWriter,
+    extend_simstate,
+    parse_simstate_filename,
+    partial_filename,
+)
 
 
 class Propagator:
@@ -19,11 +46,50 @@ class Propagator:
         force_model: FunctionProtocol,
         progress: bool = True,
         print_step: int = 10000,
+        chunk_steps: int = 10000,
+        codec: str | None = None,
+        error_bound: float | None = None,
+        tile_steps: int | None = None,
+        integrals_every: int | None = None,
+        checkpoint_steps: int | None = None,
+        shard_steps: int | None = None,
+        output_strides: ArrayLike | None = None,
+        output_tolerance: float | None = None,
     ) -> None:
+        self.integrator_name = integrator
         self.integrator = getattr(Integrator, integrator)
+        self.integrator_chunks = getattr(Integrator, f"{integrator}_chunks")
         self.force_model = force_model
         self.progress = progress
         self.print_step = print_step
+        self.chunk_steps = chunk_steps
+        # Compressed (v2), lossy and body-major (v3) output, see SimstateWriter
+        self.codec = codec
+        self.error_bound = error_bound
+        self.tile_steps = tile_steps
+        # Energy and momenta every `integrals_every` steps, written to the
+        # .siminteg next to the trajectory while it is propagated
+        self.integrals_every = integrals_every
+        # Checkpoint of the integrator every `checkpoint_steps` rows written,
+        # so that an interrupted propagation can be resumed, see `resume`
+        self.checkpoint_steps = checkpoint_steps
+        # Time-sharded output of `shard_steps` rows per file, see simshards
+        self.shard_steps = shard_steps
+        # Trajectory stored at per-body cadences (see simrate) instead of
+        # rows: strides streamed as it is propagated, or derived from a
+        # position tolerance on a full-rate run that is then dropped
+        if output_strides is not None and output_tolerance is not None:
+            raise ValueError("Give either output_strides or output_tolerance")
+        if (output_strides is not None or output_tolerance is not None) and any(
+            option is not None
+            for option in (codec, error_bound, tile_steps, shard_steps)
+        ):
+            raise ValueError(
+                "Per-body cadences replace codec, error_bound, tile_steps and "
+                "shard_steps"
+            )
+        self.output_strides = output_strides
+        self.output_tolerance = output_tolerance
 
     def propagate(
         self,
@@ -34,21 +100,341 @@ class Propagator:
     ) -> None:
         if self.progress:
             print("Propagating simulation...")
-        y = self.integrator(
-            body_list.y_0,
-            time_step,
-            stop_time,
-            self.force_model,
-            n=body_list.n,
-            mu=body_list.mu,
-            progress=self.progress,
-            print_step=self.print_step,
-        )  # y.shape = (steps, 6*bodies)
-
-        if filename is not None:
-            if self.progress:
-                print("Saving simulation to file...")
-            write_simstate(filename, simstate_view_from_state_view(y, body_list.n))
+
+        if filename is None:
+            self.integrator(
+                body_list.y_0,
+                time_step,
+                stop_time,
+                self.force_model,
+                n=body_list.n,
+                mu=body_list.mu,
+                progress=self.progress,
+                print_step=self.print_step,
+            )  # y.shape = (steps, 6*bodies)
+        elif self.output_tolerance is not None:
+            # The strides are measured on the full-rate run
+            name, dt, steps_f = parse_simstate_filename(filename)
+            full = filename.with_name(SIMSTATE_FILE.format(f"{name}-full", dt, steps_f))
+            try:
+                self._stream(
+                    body_list.y_0,
+                    time_step,
+                    stop_time,
+                    body_list.n,
+                    body_list.mu,
+                    full,
+                    self.integrals_every,
+                )
+                write_simrate(filename, full, tolerance=self.output_tolerance)
+                if integ_filename(full).exists():
+                    os.replace(integ_filename(full), integ_filename(filename))
+            finally:
+                full.unlink(missing_ok=True)
+        else:
+            self._stream(
+                body_list.y_0,
+                time_step,
+                stop_time,
+                body_list.n,
+                body_list.mu,
+                filename,
+                self.integrals_every,
+            )
+            self._checkpoint(filename, time_step)
+
+        if self.progress:
+            print("Propagation done!")
+
+    def extend(
+        self,
+        source: Path,
+        body_list: BodyList,
+        filename: Path,
+    ) -> None:
+        """
+        Continue the trajectory in `source` up to the steps of `filename`,
+        integrating only the missing steps from the checkpoint `source`
+        ended in. The result is bit-identical to propagating `filename` from
+        the start with the same integrator and force model.
+
+        `source` (uncompressed, with its checkpoint) is consumed: its rows
+        are extended in place and it is renamed to `filename`, so the
+        propagator may not set codec, error_bound, tile_steps or shard_steps.
+        """
+        self._check_row_layout("extend")
+        checkpoint = read_checkpoint(checkpoint_filename(source))
+        _, dt, _ = parse_simstate_filename(filename)
+        if (checkpoint.integrator, checkpoint.force, checkpoint.dt) != (
+            self.integrator_name,
+            force_model_key(self.force_model),
+            dt,
+        ):
+            raise ValueError(
+                f"{source} was propagated by {checkpoint.integrator} with "
+                f"{checkpoint.force} at dt={checkpoint.dt}, cannot extend it"
+            )
+        if self.progress:
+            print(f"Extending {source.name} from step {checkpoint.steps - 1}...")
+
+        # The missing steps take the path a fresh run would, into a tail
+        # file starting at the checkpoint, appended to source afterwards
+        name, _, steps_f = parse_simstate_filename(filename)
+        remaining = steps_f + 1 - checkpoint.steps
+        tail = filename.with_name(SIMSTATE_FILE.format(f"{name}-tail", dt, remaining))
+        try:
+            self._stream(
+                checkpoint.state,
+                dt,
+                remaining * dt,
+                body_list.n,
+                body_list.mu,
+                tail,
+                integrals_every=None,
+            )
+            extend_simstate(source, tail, filename)
+        finally:
+            tail.unlink(missing_ok=True)
+        checkpoint_filename(source).unlink()
+        self._checkpoint(filename, dt)
+
+        if self.progress:
+            print("Propagation done!")
+
+    def resume(self, filename: Path, body_list: BodyList) -> None:
+        """
+        Finish the propagation into `filename` that was interrupted (crash,
+        Ctrl-C) after its last checkpoint, see `checkpoint_steps`. The rows
+        in `<filename>.part` up to the checkpoint are kept and the result is
+        bit-identical to an uninterrupted run.
+        """
+        self._check_row_layout("resume")
+        checkpoint = read_checkpoint(checkpoint_filename(filename))
+        if not partial_filename(filename).exists():
+            raise FileNotFoundError(f"No interrupted propagation of {filename}")
+        _, dt, _ = parse_simstate_filename(filename)
+        if (checkpoint.integrator, checkpoint.force, checkpoint.dt) != (
+            self.integrator_name,
+            force_model_key(self.force_model),
+            dt,
+        ):
+            raise ValueError(
+                f"{filename} was propagated by {checkpoint.integrator} with "
+                f"{checkpoint.force} at dt={checkpoint.dt}, cannot resume it"
+            )
+        if self.progress:
+            print(f"Resuming {filename.name} from step {checkpoint.steps - 1}...")
+
+        self._stream(
+            checkpoint.state,
+            dt,
+            0.0,
+            body_list.n,
+            body_list.mu,
+            filename,
+            self.integrals_every,
+            resume=checkpoint,
+        )
+        self._checkpoint(filename, dt)
 
         if self.progress:
             print("Propagation done!")
+
+    def _check_row_layout(self, action: str) -> None:
+        """Runs are only continued in uncompressed single files, whose rows
+        can be appended to"""
+        options = {
+            "codec": self.codec,
+            "error_bound": self.error_bound,
+            "tile_steps": self.tile_steps,
+            "shard_steps": self.shard_steps,
+            "output_strides": self.output_strides,
+            "output_tolerance": self.output_tolerance,
+        }
+        used = [k for k, v in options.items() if v is not None]
+        if used:
+            raise ValueError(f"cannot {action} with {', '.join(used)} set")
+
+    def _force_key(self) -> str | None:
+        """Key of the force model when its runs can be continued exactly:
+        not for lossy files, per-body cadences, double-double runs or unkeyed
+        force models"""
+        if (
+            self.error_bound is not None
+            or self.output_strides is not None
+            or self.output_tolerance is not None
+            or getattr(self.force_model, "precision", None) == "dd"
+        ):
+            return None
+        return force_model_key(self.force_model)
+
+    def _checkpoint(self, filename: Path, time_step: float) -> None:
+        """Record the state `filename` ends in, when stored exactly"""
+        force = self._force_key()
+        if force is None:
+            return
+        sim = SimstateMemmap(filename)
+        write_checkpoint(
+            checkpoint_filename(filename),
+            Checkpoint(
+                steps=sim.steps,
+                dt=time_step,
+                integrator=self.integrator_name,
+                force=force,
+                state=_state_from_row(np.asarray(sim.mm[-1])),
+            ),
+        )
+
+    def _stream(
+        self,
+        state: FloatArray,
+        time_step: float,
+        stop_time: float,
+        n: int,
+        mu: FloatArray,
+        filename: Path,
+        integrals_every: int | None,
+        resume: Checkpoint | None = None,
+    ) -> None:
+        """Write chunks to the file as they are produced: peak memory is one
+        chunk regardless of stop_time. With `resume`, `state` is the state
+        after its rows and the file is completed from there. With
+        `output_strides`, only the samples of each body are written."""
+        strides = self.output_strides
+        force = None
+        if (
+            self.checkpoint_steps is not None
+            and self.codec is None
+            and self.tile_steps is None
+            and self.shard_steps is None
+        ):
+            # Only uncompressed rows are on disk as soon as they are written
+            force = self._force_key()
+        if (
+            force is None
+            and self.codec is None
+            and self.error_bound is None
+            and self.tile_steps is None
+            and self.shard_steps is None
+            and strides is None
+            and self.integrator_name == "rk4"
+            and isinstance(self.force_model, RK4FileCapable)
+        ):
+            stats = self.force_model._rk4_to_file(
+                state,
+                time_step,
+                stop_time,
+                filename,
+                self.chunk_steps,
+                integrals_every,
+                n=n,
+                mu=mu,
+            )
+            if self.progress:
+                print(
+                    f"Propagated to file: {stats['steps_per_second']:,.0f} steps/s "
+                    f"({stats['write_seconds']:.2f} s writing, "
+                    f"{stats['stall_seconds']:.2f} s stalled)"
+                )
+            return
+
+        done = 0 if resume is None else resume.steps
+        keep = force is not None
+        writer: SimstateWriter | ShardedSimstateWriter | SimrateWriter
+        if strides is not None:
+            writer = SimrateWriter(filename, filename, strides)
+        elif self.shard_steps is not None:
+            writer = ShardedSimstateWriter(
+                filename,
+                n,
+                self.shard_steps,
+                codec=self.codec,
+                error_bound=self.error_bound,
+                tile_steps=self.tile_steps,
+            )
+        else:
+            writer = SimstateWriter(
+                filename,
+                n,
+                codec=self.codec,
+                error_bound=self.error_bound,
+                tile_steps=self.tile_steps,
+                resume=done or None,
+                keep_partial=keep,
+            )
+        with (
+            writer,
+            record_integrals(
+                filename, writer.steps, integrals_every, mu, done, keep
+            ) as recorder,
+        ):
+            if resume is not None:
+                stop_time = (writer.steps - done) * time_step
+            chunks = self.integrator_chunks(
+                state,
+                time_step,
+                stop_time,
+                self.force_model,
+                self.chunk_steps,
+                n=n,
+                mu=mu,
+            )
+            pt = ProgressTracker(
+                n=writer.steps,
+                print_step=self.chunk_steps,
+                name="Propagating to file",
+            )
+            saved, skip = done, resume is not None
+            try:
+                for chunk in chunks:
+                    if skip:
+                        # Starts with the last row of the file
+                        chunk, skip = chunk[1:], False
+                    writer.write(chunk)
+                    if recorder is not None:
+                        recorder.record(chunk)
+                    # Rows of both files, and the state after them
+                    done, state = writer.rows, chunk[-1] if chunk.size else state
+                    if (
+                        force is not None
+                        and done - saved >= cast(int, self.checkpoint_steps)
+                        and done < writer.steps
+                    ):
+                        self._save(filename, writer, done, time_step, force, state)
+                        saved = done
+                    if self.progress:
+                        pt.print(i=writer.rows - 1)
+            except KeyboardInterrupt:
+                if force is not None and done > saved:
+                    self._save(filename, writer, done, time_step, force, state)
+                raise
+            if self.progress:
+                pt.print(i=writer.steps)
+
+    def _save(
+        self,
+        filename: Path,
+        writer: SimstateWriter | ShardedSimstateWriter | SimrateWriter,
+        rows: int,
+        time_step: float,
+        force: str,
+        state: FloatArray,
+    ) -> None:
+        """Checkpoint `state` after the first `rows` rows of `filename`,
+        once they are on disk (the integrals are committed as written)"""
+        writer.sync()
+        write_checkpoint(
+            checkpoint_filename(filename),
+            Checkpoint(
+                steps=rows,
+                dt=time_step,
+                integrator=self.integrator_name,
+                force=force,
+                state=np.array(state, dtype=np.float64),
+            ),
+        )
+
+
+def _state_from_row(row: FloatArray) -> FloatArray:
+    """Integrator state [r (3n), v (3n)] of one stored (n, 6) step"""
+    return np.concatenate([row[:, :3].ravel(), row[:, 3:6].ravel()])
@@ -0,0 +1,63 @@
+# SPDX-FileCopyrightText: © 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+#
+# SPDX-License-Identifier: AGPL-3.0-or-later
+
+"""Variational equations module"""
+
+from typing import Sequence, Tuple
+
+import numpy as np
+
+from project.simulation.cpp_force_kernel import stm_rk4_cpp
+from project.utils import FloatArray
+from project.utils.data import BodyList
+
+
+def propagate_stm(
+    body_list: BodyList,
+    time_step: float,
+    stop_time: float,
+    bodies: Sequence[int] | None = None,
+    stride: int = 1,
+) -> Tuple[FloatArray, FloatArray]:
+    """Propagate the state together with its state transition matrix
+
+    The variational equations are integrated natively with RK4 alongside the
+    trajectory, using the gravity gradient evaluated in the same pair loop as
+    the accelerations.
+
+    Parameters
+    ----------
+    body_list : BodyList
+        Bodies to propagate
+    time_step : float
+        Time step [s]
+    stop_time : float
+        Stop time [s]
+    bodies : Sequence[int] | None, optional
+        Indices of the bodies whose states are differentiated, by default all.
+        The remaining bodies still perturb the subset, but the subset's
+        back-reaction on them is not differentiated, so a small subset of
+        light bodies keeps the cost at O(m^3) instead of O(n^3)
+    stride : int, optional
+        Store the STM every `stride` steps, by default 1
+
+    Returns
+    -------
+    Tuple[FloatArray, FloatArray]
+        Trajectory (steps, 6*n) and STMs ((steps - 1) // stride + 1, 6*m, 6*m).
+        STM rows and columns follow the subset state [r_S (3*m), v_S (3*m)],
+        with bodies in the order given by `bodies`
+    """
+    steps = int(stop_time / time_step) + 1
+    if bodies is None:
+        bodies = range(body_list.n)
+
+    return stm_rk4_cpp(
+        body_list.y_0,
+        time_step,
+        steps,
+        body_list.mu,
+        np.asarray(bodies, dtype=np.intp),
+        stride,
+    )
@@ -790,13 +790,13 @@ class Visualization:
             end_frame = min(self.sim.steps, end_frame)
 
             if start_frame < end_frame:
-                positions_to_add = self.sim.mm.r_vis[start_frame:end_frame:step, :]
+                positions_to_add = self.sim.lod.r_vis(start_frame, end_frame, step)
 
                 # Apply focus offset if needed
                 if self.trail_focus_body_idx is not None:
-                    focus_positions = self.sim.mm.r_vis[
-                        start_frame:end_frame:step, self.trail_focus_body_idx
-                    ]
+                    focus_positions = self.sim.lod.r_vis(
+                        start_frame, end_frame, step, self.trail_focus_body_idx
+                    )
                     positions_to_add = positions_to_add - focus_positions
 
                 # Add new positions
@@ -862,15 +862,15 @@ class Visualization:
     def rebuild_relative_trail_cache(self) -> None:
         new_cache = np.empty((self.trail_length, 3, self.sim.num_bodies))
         initial_point = max(0, self.frame - self.trail_length * self.trail_step + 1)
-        current_pos = self.sim.mm.r_vis[
-            initial_point : self.frame + 1 : self.trail_step, :
-        ]
+        current_pos = self.sim.lod.r_vis(initial_point, self.frame + 1, self.trail_step)
 
         if self.trail_focus_body_idx is not None:
-            pos_diff = self.sim.mm.r_vis[
-                initial_point : self.frame + 1 : self.trail_step,
+            pos_diff = self.sim.lod.r_vis(
+                initial_point,
+                self.frame + 1,
+                self.trail_step,
                 self.trail_focus_body_idx,
-            ]
+            )
             current_pos = current_pos - pos_diff
 
         n = current_pos.shape[0]
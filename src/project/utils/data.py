@@ -2,11 +2,23 @@
 #
 # SPDX-License-Identifier: AGPL-3.0-or-later
 
+import operator
 import os
+import sys
 import tomllib
 from collections.abc import Iterable
 from pathlib import Path
-from typing import Annotated, Any, Dict, List, TypeVar
+from typing import (
+    Annotated,
+    Any,
+    Callable,
+    Dict,
+    Iterator,
+    List,
+    SupportsIndex,
+    TypeVar,
+    overload,
+)
 
 import numpy as np
 import tomli_w
@@ -18,6 +30,7 @@ from pydantic import (
 from pydantic_core import core_schema
 
 from project.utils import FloatArray, camel_to_snake
+from project.utils.simsnap import SIMSNAP_EXTENSION, SimsnapMemmap, write_simsnap
 
 T = TypeVar("T", bound="Body")
 
@@ -73,6 +86,12 @@ class Body(BaseModel):
         """Load mission phase."""
         return cls(**body)
 
+    def __eq__(self, other: object) -> bool:
+        # Field-wise, vectors by value (the default compares arrays ambiguously)
+        if not isinstance(other, Body):
+            return NotImplemented
+        return self.dump() == other.dump()
+
     def dump(self) -> Dict[str, Any]:
         """Dump body"""
         # Convert to dict first
@@ -80,7 +99,7 @@ class Body(BaseModel):
 
         # Convert Vector3 arrays to lists
         for key in ["r_0", "v_0"]:
-            if key in body_dict and body_dict[key] is not None:
+            if hasattr(body_dict.get(key), "tolist"):
                 body_dict[key] = body_dict[key].tolist()
 
         return body_dict
@@ -101,7 +120,10 @@ class BodyList(list[Body]):
 
     @staticmethod
     def load(file_path: Path) -> "BodyList":
-        """Load mission profile from file."""
+        """Load mission profile from file: TOML, or a .simsnap snapshot whose
+        columns are mapped without building the bodies."""
+        if Path(file_path).suffix == SIMSNAP_EXTENSION:
+            return SnapshotBodyList(SimsnapMemmap(Path(file_path)))
         with open(file_path, "rb") as f:
             data = tomllib.load(f)
         bl_raw = data["body_list"]
@@ -110,10 +132,13 @@ class BodyList(list[Body]):
         return bl
 
     def dump(self, file_path: Path) -> None:
-        """Dump body list to file."""
+        """Dump body list to file, TOML or a .simsnap snapshot."""
+        if Path(file_path).suffix == SIMSNAP_EXTENSION:
+            self._dump_snapshot(Path(file_path))
+            return
 
-        # Use lowercase class name as key
-        key = camel_to_snake(self.__class__.__name__)
+        # Use lowercase class name as key, snapshots dumping as body lists
+        key = camel_to_snake(BodyList.__name__)
 
         save_data = []
         for body in self:
@@ -132,16 +157,29 @@ class BodyList(list[Body]):
             save_data.append(body_data)
 
         if not os.path.exists(file_path):
-            data = {key: save_data}
+            data: Dict[str, Any] = {key: save_data}
         else:
             with open(file_path, "rb") as f:
                 data = tomllib.load(f)
 
             data[key] = save_data
+        if self.metadata is not None:
+            data["metadata"] = self.metadata
 
         with open(file_path, "wb") as f:
             tomli_w.dump(data, f)
 
+    def _dump_snapshot(self, file_path: Path) -> None:
+        write_simsnap(
+            file_path,
+            [body.name for body in self],
+            [np.nan if body.mu is None else body.mu for body in self],
+            self.r_0.reshape(-1, 3),
+            self.v_0.reshape(-1, 3),
+            [np.nan if body.radius is None else body.radius for body in self],
+            self.metadata,
+        )
+
     @property
     def r_0(self) -> FloatArray:
         if self._r_0 is None:
@@ -177,3 +215,135 @@ class BodyList(list[Body]):
         if self._n is None:
             self._n = len(self)
         return self._n
+
+
+def _read_only(name: str) -> Callable[..., Any]:
+    """List method of `SnapshotBodyList` that would change its entries"""
+
+    def method(self: "SnapshotBodyList", *args: Any, **kwargs: Any) -> Any:
+        raise TypeError(f"{type(self).__name__} is read-only, cannot {name}")
+
+    method.__name__ = name
+    return method
+
+
+class SnapshotBodyList(BodyList):
+    """Bodies of a .simsnap snapshot: `r_0`, `v_0` and `mu` are views of its
+    mapped columns, and a `Body` is only built when an entry is accessed
+
+    The underlying list stays empty, so every list operation is served from
+    the snapshot; it is a read-only sequence and mutating methods raise
+    TypeError. `copy`, `+` and `*` return plain lists of bodies."""
+
+    def __init__(self, snapshot: SimsnapMemmap) -> None:
+        super().__init__([])
+        self.snapshot = snapshot
+        self.metadata = snapshot.metadata
+        self._r_0 = snapshot.r_0.reshape(-1)
+        self._v_0 = snapshot.v_0.reshape(-1)
+        self._mu = snapshot.mu
+        self._n = snapshot.n
+
+    def __len__(self) -> int:
+        return int(self.snapshot.n)
+
+    @overload
+    def __getitem__(self, index: SupportsIndex) -> Body: ...
+
+    @overload
+    def __getitem__(self, index: slice) -> List[Body]: ...
+
+    def __getitem__(self, index: SupportsIndex | slice) -> Body | List[Body]:
+        if isinstance(index, slice):
+            return [self._body(i) for i in range(*index.indices(len(self)))]
+        i = operator.index(index)
+        if i < 0:
+            i += len(self)
+        if not 0 <= i < len(self):
+            raise IndexError(f"body {index} out of range for {len(self)} bodies")
+        return self._body(i)
+
+    def __iter__(self) -> Iterator[Body]:
+        return (self._body(i) for i in range(len(self)))
+
+    def __reversed__(self) -> Iterator[Body]:
+        return (self._body(i) for i in reversed(range(len(self))))
+
+    def __bool__(self) -> bool:
+        return len(self) > 0
+
+    def __contains__(self, value: object) -> bool:
+        return any(body == value for body in self)
+
+    def __eq__(self, other: object) -> bool:
+        if not isinstance(other, list):
+            return NotImplemented
+        return len(self) == len(other) and list(self) == list(other)
+
+    def __ne__(self, other: object) -> bool:
+        equal = self.__eq__(other)
+        return equal if equal is NotImplemented else not equal
+
+    def __add__(self, other: List[Body]) -> List[Body]:  # type: ignore[override]
+        return list(self) + list(other)
+
+    def __radd__(self, other: List[Body]) -> List[Body]:
+        return list(other) + list(self)
+
+    def __mul__(self, count: SupportsIndex) -> List[Body]:  # type: ignore[override]
+        return list(self) * count
+
+    __rmul__ = __mul__  # type: ignore[assignment]
+
+    def __repr__(self) -> str:
+        return f"{type(self).__name__}({self.snapshot.filename!s}, {len(self)} bodies)"
+
+    def index(
+        self, value: Body, start: SupportsIndex = 0, stop: SupportsIndex = sys.maxsize
+    ) -> int:
+        for i in range(*slice(start, stop).indices(len(self))):
+            if self._body(i) == value:
+                return i
+        raise ValueError(f"{value!r} is not in {type(self).__name__}")
+
+    def count(self, value: Body) -> int:
+        return sum(body == value for body in self)
+
+    def copy(self) -> List[Body]:
+        return list(self)
+
+    append = _read_only("append")
+    extend = _read_only("extend")
+    insert = _read_only("insert")
+    pop = _read_only("pop")
+    remove = _read_only("remove")
+    clear = _read_only("clear")
+    sort = _read_only("sort")
+    reverse = _read_only("reverse")
+    __setitem__ = _read_only("__setitem__")
+    __delitem__ = _read_only("__delitem__")
+    __iadd__ = _read_only("__iadd__")
+    __imul__ = _read_only("__imul__")
+
+    def _body(self, i: int) -> Body:
+        snapshot = self.snapshot
+        mu, radius = float(snapshot.mu[i]), float(snapshot.radius[i])
+        return Body(
+            name=snapshot.name(i),
+            mu=None if np.isnan(mu) else mu,
+            r_0=snapshot.r_0[i].tolist(),
+            v_0=snapshot.v_0[i].tolist(),
+            radius=None if np.isnan(radius) else radius,
+        )
+
+    def _dump_snapshot(self, file_path: Path) -> None:
+        snapshot = self.snapshot
+        write_simsnap(
+            file_path,
+            snapshot.names,
+            snapshot.mu,
+            snapshot.r_0,
+            snapshot.v_0,
+            snapshot.radius,
+            self.metadata,
+        )
@@ -0,0 +1,145 @@
+# SPDX-FileCopyrightText: © 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+#
+# SPDX-License-Identifier: AGPL-3.0-or-later
+
+"""Content-addressed trajectory cache
+
+Trajectories are named after a hash of what determines them (initial state,
+gravitational parameters, integrator, force model and time step) instead of
+the name of the system, as `<key>__<dt>__<steps>.simstate` plus sidecars.
+Identical runs therefore share one file whatever they are called, a changed
+input never reuses a stale one, and runs of the same key differing only in
+length are served as prefixes or extended (see `Propagator.extend`).
+
+`index.toml` in the cache directory records when each key was last used;
+once the files exceed the disk budget the least recently used keys are
+evicted.
+"""
+
+import hashlib
+import os
+import shutil
+import time
+import tomllib
+from pathlib import Path
+from typing import Any, Dict, List, Tuple
+
+import numpy as np
+import tomli_w
+
+from project.utils import FloatArray
+from project.utils.simstate import SIMSTATE_FILE, cached_simstates, partial_filename
+
+CACHE_INDEX = "index.toml"
+DEFAULT_BUDGET = 50 << 30  # bytes
+
+
+def trajectory_key(
+    y_0: FloatArray, mu: FloatArray, integrator: str, force: str, dt: float
+) -> str:
+    """16 hex digits identifying a propagation, see `force_model_key`"""
+    h = hashlib.blake2b(digest_size=8)
+    for array in (y_0, mu):
+        h.update(np.ascontiguousarray(array, dtype="<f8").tobytes())
+    for text in (integrator, force, repr(float(dt))):
+        h.update(b"\x00" + text.encode())
+    return h.hexdigest()
+
+
+class TrajectoryCache:
+    """
+    Trajectories and sidecars in `directory`, keyed by `trajectory_key`.
+
+    Parameters
+    ----------
+    directory : Path
+        Cache directory, created when missing
+    budget : int | None
+        Disk budget [bytes] of all cached files, by default 50 GiB; None
+        disables eviction
+    """
+
+    def __init__(self, directory: Path, budget: int | None = DEFAULT_BUDGET) -> None:
+        self.directory = directory
+        self.budget = budget
+        self.index_file = directory / CACHE_INDEX
+        directory.mkdir(parents=True, exist_ok=True)
+
+    def load_index(self) -> Dict[str, Dict[str, Any]]:
+        """Entries by key: name, integrator, force, dt, steps, last_used"""
+        if not self.index_file.exists():
+            return {}
+        with open(self.index_file, "rb") as f:
+            return dict(tomllib.load(f).get("entries", {}))
+
+    def _save_index(self, entries: Dict[str, Dict[str, Any]]) -> None:
+        part = partial_filename(self.index_file)
+        with open(part, "wb") as f:
+            tomli_w.dump({"entries": entries}, f)
+        os.replace(part, self.index_file)
+
+    def filename(self, key: str, dt: float, steps: int) -> Path:
+        """Trajectory of `key` with `steps` steps (rows - 1)"""
+        return self.directory / SIMSTATE_FILE.format(key, dt, steps)
+
+    def trajectories(self, key: str, dt: float) -> List[Tuple[int, Path]]:
+        """(steps, path) of the trajectories of `key`, shortest first"""
+        return cached_simstates(self.directory, key, dt)
+
+    def files(self, key: str) -> List[Path]:
+        """Trajectories and sidecars of `key`, sharded ones being
+        directories"""
+        return sorted(self.directory.glob(f"{key}__*"))
+
+    def nbytes(self, key: str | None = None) -> int:
+        """Disk usage of `key`, or of every indexed key"""
+        keys = [key] if key is not None else list(self.load_index())
+        return sum(_nbytes(path) for k in keys for path in self.files(k))
+
+    def touch(self, key: str, **entry: Any) -> List[str]:
+        """
+        Mark `key` as just used, updating its index entry with `entry`, then
+        evict down to the budget.
+
+        Returns
+        -------
+        evicted : list of str
+            Keys whose files were removed
+        """
+        entries = self.load_index()
+        entries[key] = {**entries.get(key, {}), **entry, "last_used": time.time()}
+        self._save_index(entries)
+        return self.evict(keep=key)
+
+    def evict(self, keep: str | None = None) -> List[str]:
+        """Remove the least recently used keys other than `keep` until the
+        cache fits the budget; index entries without files are dropped"""
+        entries = self.load_index()
+        sizes = {key: sum(_nbytes(path) for path in self.files(key)) for key in entries}
+        evicted = [key for key, size in sizes.items() if size == 0 and key != keep]
+        total = sum(sizes.values())
+        if self.budget is not None:
+            for key in sorted(entries, key=lambda k: entries[k]["last_used"]):
+                if total <= self.budget:
+                    break
+                if key == keep or key in evicted:
+                    continue
+                for path in self.files(key):
+                    if path.is_dir():
+                        shutil.rmtree(path)
+                    else:
+                        path.unlink(missing_ok=True)
+                total -= sizes[key]
+                evicted.append(key)
+        if evicted:
+            for key in evicted:
+                del entries[key]
+            self._save_index(entries)
+        return evicted
+
+
+def _nbytes(path: Path) -> int:
+    """Size of a file, or of the files in a directory"""
+    if path.is_dir():
+        return sum(p.stat().st_size for p in path.rglob("*") if p.is_file())
+    return path.stat().st_size
@@ -0,0 +1,151 @@
+# SPDX-FileCopyrightText: © 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+#
+# SPDX-License-Identifier: AGPL-3.0-or-later
+
+"""Integrator state of a trajectory, to extend it or resume writing it
+
+A checkpoint names the rows of the trajectory known to be on disk and the
+integrator state after the last of them: the state vector, the previous
+states of multistep schemes (history) and the step-size controller values,
+so that continuing from it reproduces the bits of an uninterrupted run.
+The fixed-step schemes of `Integrator` carry no history nor controller.
+"""
+
+import os
+import struct
+from dataclasses import dataclass, field
+from pathlib import Path
+
+import numpy as np
+
+from project.utils import FloatArray
+from project.utils.simstate import partial_filename
+
+SIMCKPT_EXTENSION = ".simckpt"
+
+MAGIC = b"SIMCKPT\x00"
+VERSION = 1
+HEADER_FMT = (
+    "<"  # little-endian
+    "8s"  # magic
+    "I"  # version
+    "Q"  # steps: rows of the trajectory, the state being the last one
+    "I"  # state_dim: length of the state vector
+    "d"  # dt
+    "16s"  # integrator name
+    "64s"  # force model key, see `force_model_key`
+    "I"  # history: previous states of multistep schemes (0 in older files)
+    "I"  # controller: step-size controller values (0 in older files)
+    "8s"  # future / padding
+)
+HEADER_SIZE = struct.calcsize(HEADER_FMT)  # 128 bytes
+
+
+@dataclass
+class Checkpoint:
+    """
+    State after the `steps`-th row of a trajectory, in the integrator layout
+    [r (3n), v (3n)], stored exactly. `history` holds earlier states, most
+    recent first, as (k, state_dim); `controller` the controller values.
+    """
+
+    steps: int
+    dt: float
+    integrator: str
+    force: str
+    state: FloatArray
+    history: FloatArray = field(default_factory=lambda: np.empty((0, 0)))
+    controller: FloatArray = field(default_factory=lambda: np.empty(0))
+
+
+def checkpoint_filename(filename: Path) -> Path:
+    """Checkpoint of a .simstate file"""
+    return filename.with_suffix(SIMCKPT_EXTENSION)
+
+
+def force_model_key(force_model: object) -> str | None:
+    """Class and physics settings of a force model, e.g.
+    "CPPPointMass(precision='f64')"; runs may only be continued with an
+    identical key. The settings are the attributes named by the model's
+    `key_settings`, by default all public ones, so that I/O options do not
+    split the key. None when a setting is not a scalar (e.g. harmonic
+    fields): such runs are not checkpointed."""
+    names = getattr(force_model, "key_settings", None)
+    if names is None:
+        names = [k for k in vars(force_model) if not k.startswith("_")]
+    settings = []
+    for k in sorted(names):
+        v = getattr(force_model, k)
+        if not isinstance(v, (bool, int, float, str)):
+            return None
+        settings.append(f"{k}={v!r}")
+    key = f"{type(force_model).__name__}({','.join(settings)})"
+    return key if len(key.encode()) <= 64 else None
+
+
+def write_checkpoint(filename: Path, checkpoint: Checkpoint) -> None:
+    """Write `filename` atomically: a crash leaves the previous file"""
+    state = np.ascontiguousarray(checkpoint.state, dtype=np.float64)
+    history = np.ascontiguousarray(checkpoint.history, dtype=np.float64)
+    controller = np.ascontiguousarray(checkpoint.controller, dtype=np.float64)
+    if history.size and history.shape[1] != state.size:
+        raise ValueError("history rows must be states")
+    part = partial_filename(filename)
+    with open(part, "wb") as f:
+        f.write(
+            struct.pack(
+                HEADER_FMT,
+                MAGIC,
+                VERSION,
+                checkpoint.steps,
+                state.size,
+                checkpoint.dt,
+                checkpoint.integrator.encode(),
+                checkpoint.force.encode(),
+                history.shape[0] if history.size else 0,
+                controller.size,
+                b"\x00" * 8,
+            )
+        )
+        state.tofile(f)
+        history.tofile(f)
+        controller.tofile(f)
+        f.flush()
+        os.fsync(f.fileno())
+    os.replace(part, filename)
+
+
+def read_checkpoint(filename: Path) -> Checkpoint:
+    with open(filename, "rb") as f:
+        (
+            magic,
+            version,
+            steps,
+            state_dim,
+            dt,
+            integrator,
+            force,
+            history,
+            controller,
+            _,
+        ) = struct.unpack(HEADER_FMT, f.read(HEADER_SIZE))
+        if magic != MAGIC:
+            raise ValueError("Not a SIMCKPT file")
+        if version != VERSION:
+            raise ValueError(f"File version {version} != expected {VERSION}")
+        size = state_dim * (1 + history) + controller
+        values = np.fromfile(f, dtype="<f8", count=size)
+    if values.size != size:
+        raise ValueError(f"truncated checkpoint: {values.size} of {size} values")
+
+    return Checkpoint(
+        steps=steps,
+        dt=dt,
+        integrator=integrator.rstrip(b"\x00").decode(),
+        force=force.rstrip(b"\x00").decode(),
+        state=values[:state_dim],
+        history=values[state_dim : state_dim * (1 + history)].reshape(
+            history, state_dim
+        ),
+        controller=values[state_dim * (1 + history) :],
+    )
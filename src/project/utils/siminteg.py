@@ -2,10 +2,12 @@
 #
 # SPDX-License-Identifier: AGPL-3.0-or-later
 
+import os
 import struct
 from io import BufferedReader, BufferedWriter
 from pathlib import Path
-from typing import Tuple, cast
+from types import TracebackType
+from typing import Tuple, Type, cast
 
 import numpy as np
 import scipy
@@ -16,7 +18,8 @@ SIMINTEG_EXTENSION = ".siminteg"
 SIMINTEG_FILE = "{}__{}__{}" + SIMINTEG_EXTENSION
 
 MAGIC = b"SIMINTEG"
-VERSION = 2
+VERSION = 3
+COMPLETE_VERSIONS = (2,)  # read as complete files without a summary
 HEADER_FMT = (
     "<"  # little-endian
     "8s"  # magic
@@ -24,40 +27,98 @@ HEADER_FMT = (
     "Q"  # steps
     "I"  # integ_dim
     "d"  # dt
-    "32s"  # future / padding
+    "Q"  # stride: rows hold every stride-th step (0 in older files: 1)
+    "Q"  # rows: rows written so far (v3)
+    "I"  # summary_rows: rows per min/max summary chunk (v3)
+    "12s"  # future / padding
 )
 HEADER_SIZE = struct.calcsize(HEADER_FMT)  # 64 bytes
 
+# Columns: energy, angular momentum (3), linear momentum (3), center of mass (3)
+INTEG_DIM = 10
+SUMMARY_ROWS = 4096  # rows per summary chunk
+
+
+def integ_filename(filename: Path) -> Path:
+    """Integrals of a .simstate file, recorded during propagation"""
+    return filename.with_suffix(SIMINTEG_EXTENSION)
+
+
+def integ_rows(steps: int, stride: int) -> int:
+    """Rows of a file sampling steps 0, stride, 2 stride, ... of `steps`"""
+    return (steps - 1) // stride + 1
+
+
+def summary_chunks(rows: int, summary_rows: int = SUMMARY_ROWS) -> int:
+    """Summary entries covering `rows` rows, the last one possibly partial"""
+    return -(-rows // summary_rows)
+
+
+def siminteg_size(
+    steps: int, integ_dim: int, stride: int = 1, summary_rows: int = SUMMARY_ROWS
+) -> int:
+    """Bytes of a v3 file: header, all rows, then (min, max) per summary chunk"""
+    rows = integ_rows(steps, stride)
+    return HEADER_SIZE + 8 * integ_dim * (rows + 2 * summary_chunks(rows, summary_rows))
+
+
+def pack_header(
+    steps: int,
+    integ_dim: int,
+    dt: float,
+    stride: int = 1,
+    rows: int | None = None,
+    summary_rows: int = SUMMARY_ROWS,
+) -> bytes:
+    """Header of a v3 file holding `rows` rows so far, by default all"""
+    return struct.pack(
+        HEADER_FMT,
+        MAGIC,
+        VERSION,
+        steps,
+        integ_dim,
+        dt,
+        stride,
+        integ_rows(steps, stride) if rows is None else rows,
+        summary_rows,
+        b"\x00" * 12,
+    )
+
 
 def write_header(
     f: BufferedWriter,
     steps: int,
     integ_dim: int,
     dt: float,
+    stride: int = 1,
+    rows: int | None = None,
+    summary_rows: int = SUMMARY_ROWS,
 ) -> None:
-    f.write(
-        struct.pack(
-            HEADER_FMT,
-            MAGIC,
-            VERSION,
-            steps,
-            integ_dim,
-            dt,
-            b"\x00" * 32,
-        )
-    )
+    f.write(pack_header(steps, integ_dim, dt, stride, rows, summary_rows))
 
 
-def read_header(f: BufferedReader) -> Tuple[int, int, float]:
-    magic, version, steps, integ_dim, dt, _ = struct.unpack(HEADER_FMT, f.read(64))
+def read_header(f: BufferedReader) -> Tuple[int, int, float, int, int, int]:
+    """
+    Returns
+    -------
+    header : tuple
+        (steps, integ_dim, dt, stride, rows, summary_rows), summary_rows
+        being 0 for files without a summary
+    """
+    magic, version, steps, integ_dim, dt, stride, rows, summary_rows, _ = struct.unpack(
+        HEADER_FMT, f.read(HEADER_SIZE)
+    )
 
     if magic != MAGIC:
-        raise ValueError("Not a SIMSTATE file")
+        raise ValueError("Not a SIMINTEG file")
 
+    stride = max(stride, 1)
+    if version in COMPLETE_VERSIONS:
+        return steps, integ_dim, dt, stride, integ_rows(steps, stride), 0
     if version != VERSION:
         raise ValueError(f"File version {version} != expected {VERSION}")
 
-    return steps, integ_dim, dt
+    return steps, integ_dim, dt, stride, rows, summary_rows
 
 
 def write_siminteg(filename: Path, data: FloatArray) -> None:
@@ -81,23 +142,35 @@ def write_siminteg(filename: Path, data: FloatArray) -> None:
     with open(filename, "wb") as f:
         write_header(f, steps, integ_dim, dt)
         data.astype(np.float64, copy=False).tofile(f)
+    finish_siminteg(filename)
+
+
+def finish_siminteg(filename: Path) -> None:
+    """
+    Append the min/max summary to a file whose header and rows are written
+    but whose summary is not (streamed natively, or by `write_siminteg`).
+    """
+    with SimintegWriter(filename) as writer:
+        writer.summarize(0, writer.rows)
 
 
 def read_siminteg(
     filename: Path,
-) -> Tuple[np.memmap, Tuple[int, int, float]]:
+) -> Tuple[np.memmap, Tuple[int, int, float, int, int, int]]:
     """
     Read a .siminteg file into memory.
 
     Returns
     -------
     data : np.ndarray
-        Array of shape (integ_dim, steps)
+        Array of shape (rows, integ_dim) of the rows written so far, rows
+        sampling every stride-th step
     header : tuple
-        (steps, integ_dim, dt)
+        (steps, integ_dim, dt, stride, rows, summary_rows)
     """
     with open(filename, "rb") as f:
-        steps, integ_dim, dt = validate_siminteg_file(filename=filename, file=f)
+        header = validate_siminteg_file(filename=filename, file=f)
+    _, integ_dim, _, _, rows, _ = header
 
     # Memmap of remaining data
     mm = np.memmap(
@@ -105,10 +178,10 @@ def read_siminteg(
         dtype="float64",
         mode="r",
         offset=HEADER_SIZE,
-        shape=(steps, integ_dim),
+        shape=(rows, integ_dim),
     )
 
-    return mm, (steps, integ_dim, dt)
+    return mm, header
 
 
 def parse_siminteg_filename(filename: Path) -> Tuple[str, int, int]:
@@ -126,13 +199,16 @@ def parse_siminteg_filename(filename: Path) -> Tuple[str, int, int]:
 
 def validate_siminteg_file(
     filename: Path, file: BufferedReader
-) -> Tuple[int, int, float]:
+) -> Tuple[int, int, float, int, int, int]:
+    if filename.suffix == ".part":  # being written, named after its target
+        filename = filename.with_suffix("")
     _, dt_f, steps_f = parse_siminteg_filename(filename=filename)
-    steps, integ_dim, dt = read_header(f=file)
+    header = read_header(f=file)
+    steps, _, dt, _, _, _ = header
     if dt_f != int(dt) or steps_f != steps - 1:
         raise ValueError("Filename does not match file header")
 
-    return steps, integ_dim, dt
+    return header
 
 
 def validate_siminteg_data(filename: Path, data: FloatArray) -> Tuple[int, int, int]:
@@ -145,13 +221,215 @@ def validate_siminteg_data(filename: Path, data: FloatArray) -> Tuple[int, int,
     return steps, integ_dim, dt_f
 
 
+class SimintegWriter:
+    """
+    Appendable .siminteg (v3) file.
+
+    The file is sized for all rows up front; `append` fills the next rows
+    and the (min, max) summary of the chunks they touch, and only then
+    commits the new row count to the header. A file interrupted at any
+    point therefore reads as its last committed rows, and reopening it
+    resumes from there.
+
+    Parameters
+    ----------
+    filename : Path
+        File to create, or to resume when it exists
+    steps, integ_dim, dt, stride
+        Layout of a new file; an existing file must match the ones given,
+        or is taken as is when `steps` is None
+    """
+
+    def __init__(
+        self,
+        filename: Path,
+        steps: int | None = None,
+        integ_dim: int = INTEG_DIM,
+        dt: float | None = None,
+        stride: int = 1,
+    ) -> None:
+        self.filename = filename
+        if filename.exists():
+            with open(filename, "rb") as f:
+                header = validate_siminteg_file(filename=filename, file=f)
+            (
+                self.steps,
+                self.integ_dim,
+                self.dt,
+                self.stride,
+                self.rows,
+                self.summary_rows,
+            ) = header
+            if self.summary_rows == 0:
+                raise ValueError(f"{filename} is a complete v2 file")
+            layout = (self.steps, self.integ_dim, self.stride)
+            if steps is not None and (steps, integ_dim, stride) != layout:
+                raise ValueError(
+                    f"Cannot resume {filename}: (steps, integ_dim, stride) "
+                    f"{layout} in file, {(steps, integ_dim, stride)} requested"
+                )
+        else:
+            if steps is None or dt is None:
+                raise ValueError(f"{filename} does not exist, steps and dt required")
+            self.steps, self.integ_dim, self.dt, self.stride = (
+                steps,
+                integ_dim,
+                dt,
+                stride,
+            )
+            self.rows, self.summary_rows = 0, SUMMARY_ROWS
+            with open(filename, "wb") as f:
+                write_header(f, steps, integ_dim, dt, stride, 0, self.summary_rows)
+        with open(filename, "r+b") as f:
+            f.truncate(
+                siminteg_size(
+                    self.steps, self.integ_dim, self.stride, self.summary_rows
+                )
+            )
+
+        total = integ_rows(self.steps, self.stride)
+        self.data = np.memmap(
+            filename,
+            dtype="float64",
+            mode="r+",
+            offset=HEADER_SIZE,
+            shape=(total, self.integ_dim),
+        )
+        self.summary = np.memmap(
+            filename,
+            dtype="float64",
+            mode="r+",
+            offset=HEADER_SIZE + self.data.nbytes,
+            shape=(summary_chunks(total, self.summary_rows), 2, self.integ_dim),
+        )
+
+    @property
+    def complete(self) -> bool:
+        return self.rows == self.data.shape[0]
+
+    def append(self, rows: FloatArray) -> None:
+        """Write the next rows, (k, integ_dim), and commit them"""
+        start, stop = self.rows, self.rows + rows.shape[0]
+        if stop > self.data.shape[0]:
+            raise ValueError(f"{stop} rows exceed the {self.data.shape[0]} of the file")
+        self.data[start:stop] = rows
+        self.summarize(start, stop)
+        self.commit(stop)
+
+    def summarize(self, start: int, stop: int) -> None:
+        """Rebuild the summary of the chunks overlapping rows [start, stop)"""
+        if stop <= start:
+            return
+        size = self.summary_rows
+        first, last = start // size, (stop - 1) // size + 1
+        for c in range(first, last):
+            block = self.data[c * size : min((c + 1) * size, stop)]
+            self.summary[c, 0] = block.min(axis=0)
+            self.summary[c, 1] = block.max(axis=0)
+
+    def rewind(self, rows: int) -> None:
+        """Forget the rows after the first `rows`, to continue from there"""
+        if rows > self.rows:
+            raise ValueError(f"{self.filename} holds {self.rows} rows, not {rows}")
+        self.summarize(max(rows - 1, 0), rows)
+        self.commit(rows)
+
+    def commit(self, rows: int) -> None:
+        """Flush rows and summary, then record `rows` in the header"""
+        self.data.flush()
+        self.summary.flush()
+        with open(self.filename, "r+b") as f:
+            write_header(
+                f,
+                self.steps,
+                self.integ_dim,
+                self.dt,
+                self.stride,
+                rows,
+                self.summary_rows,
+            )
+            f.flush()
+            os.fsync(f.fileno())
+        self.rows = rows
+
+    def close(self) -> None:
+        self.data.flush()
+        self.summary.flush()
+        del self.data, self.summary
+
+    def __enter__(self) -> "SimintegWriter":
+        return self
+
+    def __exit__(
+        self,
+        exc_type: Type[BaseException] | None,
+        exc: BaseException | None,
+        tb: TracebackType | None,
+    ) -> None:
+        self.close()
+
+
 class SimintegMemmap:
     def __init__(self, filename: Path) -> None:
-        mm, (steps, integ_dim, dt) = read_siminteg(filename)
+        mm, (steps, integ_dim, dt, stride, rows, summary_rows) = read_siminteg(filename)
         self.mm = mm
         self.steps = steps
         self.integ_dim = integ_dim
         self.dt = dt
+        self.stride = stride
+        self.summary_rows = summary_rows
+        self.summary: FloatArray | None = None
+        """(chunks, 2, integ_dim) column minima and maxima of every
+        `summary_rows` rows written, None in v2 files"""
+        if summary_rows:
+            total = integ_rows(steps, stride)
+            self.summary = np.memmap(
+                filename,
+                dtype="float64",
+                mode="r",
+                offset=HEADER_SIZE + 8 * integ_dim * total,
+                shape=(summary_chunks(rows, summary_rows), 2, integ_dim),
+            )
+
+    @property
+    def complete(self) -> bool:
+        """All rows written, not an interrupted computation"""
+        return self.mm.shape[0] == integ_rows(self.steps, self.stride)
+
+    @property
+    def t(self) -> FloatArray:
+        """Times of the rows [s]"""
+        return np.arange(self.mm.shape[0]) * (self.stride * self.dt)
+
+    def envelope(
+        self, column: int, points: int = 2000
+    ) -> Tuple[FloatArray, FloatArray, FloatArray]:
+        """
+        Minimum and maximum of a column over about `points` time bins, read
+        from the summary rather than the column, for drift plots of long
+        runs (e.g. with `fill_between`).
+
+        Returns
+        -------
+        t, lo, hi : (bins,) arrays
+            Bin start times [s] and the column extrema within each bin
+        """
+        if self.summary is None or self.summary.shape[0] < points:
+            # Short run (or no summary): bin the column itself
+            lo_src = hi_src = np.asarray(self.mm[:, column])
+            rows_per_entry = 1
+        else:
+            lo_src = np.asarray(self.summary[:, 0, column])
+            hi_src = np.asarray(self.summary[:, 1, column])
+            rows_per_entry = self.summary_rows
+        per_bin = max(1, -(-lo_src.shape[0] // points))
+        starts = np.arange(0, lo_src.shape[0], per_bin)
+        t = starts * (rows_per_entry * self.stride * self.dt)
+        return (
+            t,
+            np.minimum.reduceat(lo_src, starts),
+            np.maximum.reduceat(hi_src, starts),
+        )
 
     @property
     def e(self) -> FloatArray:
@@ -159,7 +437,17 @@ class SimintegMemmap:
 
     @property
     def h_vec(self) -> FloatArray:
-        return self.mm[:, 1:]
+        return self.mm[:, 1:4]
+
+    @property
+    def p_vec(self) -> FloatArray:
+        """Linear momentum, absent (no columns) from older files"""
+        return self.mm[:, 4:7]
+
+    @property
+    def com(self) -> FloatArray:
+        """Center of mass position, absent (no columns) from older files"""
+        return self.mm[:, 7:10]
 
     @property
     def h(self) -> FloatArray:
@@ -0,0 +1,209 @@
+# SPDX-FileCopyrightText: © 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+#
+# SPDX-License-Identifier: AGPL-3.0-or-later
+
+"""Level-of-detail pyramid of a .simstate trajectory (.simlod sidecar)
+
+Level k holds the positions of every 2^k-th step (k >= 1, level 0 being the
+trajectory itself), step-major as (rows, bodies, 3). A strided read at a
+coarse time resolution is served from the coarsest level that still has a
+sample at least every `step` steps, so it becomes a short, nearly
+sequential read instead of one page per step of the full-resolution file.
+"""
+
+import math
+import os
+import struct
+from pathlib import Path
+from typing import List, Tuple
+
+import numpy as np
+
+from project.utils import FloatArray, Index
+from project.utils.simstate import SimstateMemmap, partial_filename
+
+SIMLOD_EXTENSION = ".simlod"
+
+MAGIC = b"SIMLOD\x00\x00"
+VERSION = 1
+HEADER_FMT = (
+    "<"  # little-endian
+    "8s"  # magic
+    "I"  # version
+    "Q"  # steps (of the trajectory)
+    "I"  # bodies
+    "I"  # levels
+    "d"  # dt
+    "24s"  # future / padding
+)
+HEADER_SIZE = struct.calcsize(HEADER_FMT)  # 64 bytes
+# Per level: stride, rows, absolute offset, as <u8 after the header
+LEVEL_FIELDS = 3
+
+MIN_LEVEL_ROWS = 256  # coarser levels would be read whole anyway
+BLOCK_BYTES = 1 << 24  # trajectory read per pass while building
+
+
+def lod_filename(filename: Path) -> Path:
+    """Sidecar of a .simstate file"""
+    return filename.with_suffix(SIMLOD_EXTENSION)
+
+
+def write_simlod(
+    filename: Path, sim: SimstateMemmap, min_rows: int = MIN_LEVEL_ROWS
+) -> None:
+    """Build the pyramid of `sim` in one sequential pass
+
+    Parameters
+    ----------
+    filename : Path
+        Output .simlod file, written as `<filename>.part` then renamed
+    sim : SimstateMemmap
+        Trajectory, in any .simstate layout
+    min_rows : int, optional
+        Rows of the coarsest level, at least, by default 256
+    """
+    levels = 0
+    while sim.steps // (2 << levels) >= min_rows:
+        levels += 1
+    strides = [1 << (k + 1) for k in range(levels)]
+    rows = [-(-sim.steps // s) for s in strides]
+    offsets = np.cumsum(
+        [HEADER_SIZE + 8 * LEVEL_FIELDS * levels]
+        + [r * sim.bodies * 3 * 8 for r in rows]
+    )
+
+    part = partial_filename(filename)
+    with open(part, "wb") as f:
+        f.write(
+            struct.pack(
+                HEADER_FMT,
+                MAGIC,
+                VERSION,
+                sim.steps,
+                sim.bodies,
+                levels,
+                sim.dt,
+                b"\x00" * 24,
+            )
+        )
+        np.array([strides, rows, offsets[:-1]], dtype="<u8").T.tofile(f)
+        f.truncate(int(offsets[-1]))
+
+    if levels > 0:
+        out = [
+            np.memmap(
+                part,
+                dtype="<f8",
+                mode="r+",
+                offset=int(offsets[k]),
+                shape=(rows[k], sim.bodies, 3),
+            )
+            for k in range(levels)
+        ]
+        block = max(1, BLOCK_BYTES // (sim.bodies * 3 * 8))
+        sim.advise("sequential")
+        for start in range(0, sim.steps, block):
+            positions = np.asarray(sim.mm[start : start + block, :, :3])
+            for s, level in zip(strides, out):
+                first = -start % s
+                picked = positions[first::s]
+                row = (start + first) // s
+                level[row : row + picked.shape[0]] = picked
+        for level in out:
+            level.flush()
+        del out
+    os.replace(part, filename)
+
+
+class SimlodMemmap:
+    """Decimated levels of a .simlod file, `levels[k - 1]` holding every
+    `strides[k - 1]`-th step"""
+
+    def __init__(self, filename: Path) -> None:
+        with open(filename, "rb") as f:
+            magic, version, steps, bodies, levels, dt, _ = struct.unpack(
+                HEADER_FMT, f.read(HEADER_SIZE)
+            )
+            table = np.fromfile(f, dtype="<u8", count=LEVEL_FIELDS * levels)
+        if magic != MAGIC:
+            raise ValueError("Not a SIMLOD file")
+        if version != VERSION:
+            raise ValueError(f"File version {version} != expected {VERSION}")
+
+        self.steps = steps
+        self.bodies = bodies
+        self.dt = dt
+        self.strides: List[int] = []
+        self.levels: List[np.memmap] = []
+        for stride, rows, offset in table.reshape(levels, LEVEL_FIELDS):
+            self.strides.append(int(stride))
+            self.levels.append(
+                np.memmap(
+                    filename,
+                    dtype="<f8",
+                    mode="r",
+                    offset=int(offset),
+                    shape=(int(rows), bodies, 3),
+                )
+            )
+
+
+def ensure_simlod(filename: Path, sim: SimstateMemmap) -> SimlodMemmap:
+    """Open the sidecar of trajectory `filename`, (re)building it when it is
+    missing or older than the trajectory"""
+    sidecar = lod_filename(filename)
+    if not sidecar.exists() or sidecar.stat().st_mtime < Path(filename).stat().st_mtime:
+        write_simlod(sidecar, sim)
+    return SimlodMemmap(sidecar)
+
+
+class TrajectoryPyramid:
+    """Strided position reads served from the coarsest sufficient level
+
+    Parameters
+    ----------
+    sim : SimstateMemmap
+        Full-resolution trajectory (level 0)
+    lod : SimlodMemmap | None
+        Its pyramid, or that of a longer trajectory it is a prefix of, by
+        default only level 0
+    """
+
+    def __init__(self, sim: SimstateMemmap, lod: SimlodMemmap | None = None) -> None:
+        if lod is not None and (lod.steps < sim.steps or lod.bodies != sim.bodies):
+            raise ValueError("Pyramid does not match the trajectory")
+        self.sim = sim
+        self.lod = lod
+
+    def level_for(self, step: int) -> int:
+        """Coarsest level with a sample at least every `step` steps"""
+        if self.lod is None or step < 2:
+            return 0
+        return min(int(math.log2(step)), len(self.lod.levels))
+
+    def level_for_time(self, resolution: float) -> Tuple[int, int]:
+        """(level, stride) of the coarsest level with a sample at least every
+        `resolution` seconds"""
+        level = self.level_for(int(resolution / abs(self.sim.dt)))
+        return level, 1 << level
+
+    def r_vis(
+        self, start: int, stop: int, step: int, body: Index = slice(None)
+    ) -> FloatArray:
+        """Like `sim.r_vis[start:stop:step, body]`, (samples, 3, bodies),
+        with the same values: the level is the coarsest one at or below
+        `step` whose stride divides both `start` and `step`, so that every
+        requested step is one of its samples.
+        """
+        start, stop, step = slice(start, stop, step).indices(self.sim.steps)
+        aligned = start | step
+        level = min(self.level_for(step), (aligned & -aligned).bit_length() - 1)
+        if level <= 0 or self.lod is None:
+            return self.sim.r_vis[start:stop:step, body]
+
+        if isinstance(body, int):
+            body = slice(body, body + 1)
+        rows = np.arange(start, stop, step)
+        data = self.lod.levels[level - 1][rows >> level, body]
+        return np.transpose(data, (0, 2, 1))
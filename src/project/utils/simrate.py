@@ -0,0 +1,387 @@
+# SPDX-FileCopyrightText: © 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+#
+# SPDX-License-Identifier: AGPL-3.0-or-later
+
+"""Per-body output cadence of a trajectory
+
+A trajectory `name__dt__steps.simstate` can be stored with every body at
+its own stride instead of as rows of all bodies: body b keeps the states
+[r, v] of the steps 0, s_b, 2 s_b, ... and of the last step, so its time
+base is (stride, rows) and the file size follows the dynamics of each body
+rather than bodies x steps. The states at the other steps are
+reconstructed by cubic Hermite interpolation between the bracketing
+samples, exact at the samples themselves.
+
+Such files start with their own magic; `SimstateMemmap` opens them through
+`SimrateMemmap` like any other layout. Strides come from orbital periods
+(`cadence_from_periods`) or from a position tolerance on the interpolation
+(`cadence_for_tolerance`).
+"""
+
+import os
+import struct
+from pathlib import Path
+from types import TracebackType
+from typing import TYPE_CHECKING, Any, Dict, List, Tuple, Type
+
+import numpy as np
+from numpy.typing import ArrayLike
+
+from project.utils import FloatArray, Index, IntArray
+from project.utils.simstate import (
+    SimstateMemmap,
+    body_key,
+    parse_simstate_filename,
+    partial_filename,
+    simstate_view_from_state_view,
+    step_key,
+)
+
+if TYPE_CHECKING:
+    from project.simulation.cpp_force_kernel import HermiteTrajectory
+
+MAGIC = b"SIMRATE\x00"
+VERSION = 1
+HEADER_FMT = (
+    "<"  # little-endian
+    "8s"  # magic
+    "I"  # version
+    "Q"  # steps (of the trajectory)
+    "I"  # bodies
+    "d"  # dt
+    "32s"  # future / padding
+)
+HEADER_SIZE = struct.calcsize(HEADER_FMT)  # 64 bytes
+# Per body: stride, rows, absolute offset of its (rows, 6) samples, as <u8
+# after the header
+BODY_FIELDS = 3
+
+MAX_STRIDE = 1 << 16
+BLOCK_BYTES = 1 << 24  # trajectory read per pass
+
+
+def is_simrate(filename: Path) -> bool:
+    """Whether the trajectory `filename` is stored at per-body cadences"""
+    if not filename.is_file():
+        return False
+    with open(filename, "rb") as f:
+        return f.read(len(MAGIC)) == MAGIC
+
+
+def sample_steps(steps: int, stride: int) -> IntArray:
+    """Steps kept at `stride`: its multiples, then the last step"""
+    kept = np.arange(0, steps, stride, dtype=np.int64)
+    return kept if kept[-1] == steps - 1 else np.append(kept, steps - 1)
+
+
+def cadence_from_periods(
+    periods: ArrayLike, dt: float, samples_per_orbit: int = 512
+) -> IntArray:
+    """Power-of-two strides giving each body at least `samples_per_orbit`
+    samples per orbital period [s]"""
+    steps = np.asarray(periods, dtype=np.float64) / (samples_per_orbit * abs(dt))
+    exponents = np.floor(np.log2(np.maximum(steps, 1.0)))
+    return np.minimum(2 ** exponents.astype(np.int64), MAX_STRIDE)
+
+
+def cadence_for_tolerance(
+    sim: SimstateMemmap, tolerance: float, max_stride: int = MAX_STRIDE
+) -> IntArray:
+    """
+    Largest power-of-two stride of every body whose Hermite interpolation
+    stays within `tolerance` [m] of the stored positions.
+
+    The error of stride s is measured at the midpoints of its intervals,
+    where the cubic Hermite error peaks, over the whole trajectory: stride
+    2s needs the rows at multiples of s only, so the passes read the file
+    about twice in total. Bodies stop at the first stride that fails.
+    """
+    strides = np.ones(sim.bodies, dtype=np.int64)
+    growing = np.ones(sim.bodies, dtype=bool)
+    s = 2
+    while growing.any() and s <= min(max_stride, sim.steps - 1):
+        error = _midpoint_error(sim, s, np.flatnonzero(growing))
+        ok = error <= tolerance
+        bodies = np.flatnonzero(growing)
+        strides[bodies[ok]] = s
+        growing[bodies[~ok]] = False
+        s *= 2
+    return strides
+
+
+def _midpoint_error(sim: SimstateMemmap, stride: int, bodies: IntArray) -> FloatArray:
+    """Largest position error of `bodies` at the midpoints of the intervals
+    of `stride` (even), interpolated from their ends"""
+    half = stride // 2
+    h = stride * abs(sim.dt)
+    rows = np.arange(0, sim.steps, half)
+    rows = rows[: (rows.size - 1) // 2 * 2 + 1]  # whole intervals only
+    block = max(2, BLOCK_BYTES // (sim.bodies * sim.state_dim * 8)) // 2 * 2
+    error = np.zeros(bodies.size)
+    for start in range(0, rows.size - 1, block):
+        data = np.asarray(sim.mm[rows[start : start + block + 1]])[:, bodies]
+        ends, mids = data[::2], data[1::2]
+        r0, v0, r1, v1 = (
+            ends[:-1, :, :3],
+            ends[:-1, :, 3:],
+            ends[1:, :, :3],
+            ends[1:, :, 3:],
+        )
+        predicted = 0.5 * (r0 + r1) + h / 8 * (v0 - v1)
+        distance = np.linalg.norm(predicted - mids[: r0.shape[0], :, :3], axis=-1)
+        error = np.maximum(error, distance.max(axis=0))
+    return error
+
+
+class SimrateWriter:
+    """
+    Stream the per-body samples of a trajectory as it is produced, with
+    the interface of `SimstateWriter`: rows arrive in order and each body
+    keeps those on its time base. The file is built as `<filename>.part`
+    and renamed on close.
+
+    Parameters
+    ----------
+    filename : Path
+        Output file; steps and dt are taken from `trajectory`
+    trajectory : Path
+        The .simstate file (name__dt__steps.simstate) being sampled, the
+        output itself when the run is propagated straight at its cadences
+    strides : ArrayLike
+        Stride of every body
+    """
+
+    def __init__(self, filename: Path, trajectory: Path, strides: ArrayLike) -> None:
+        _, dt, steps_f = parse_simstate_filename(trajectory)
+        self.filename = filename
+        self.steps = steps_f + 1
+        self.strides = np.asarray(strides, dtype=np.int64)
+        self.bodies = self.strides.size
+        self.rows = 0
+        if np.any(self.strides < 1):
+            raise ValueError("strides must be positive")
+
+        self._kept = [sample_steps(self.steps, int(s)) for s in self.strides]
+        sizes = [kept.size for kept in self._kept]
+        offsets = np.cumsum(
+            [HEADER_SIZE + 8 * BODY_FIELDS * self.bodies] + [r * 6 * 8 for r in sizes]
+        )
+        self._part = partial_filename(filename)
+        with open(self._part, "wb") as f:
+            f.write(
+                struct.pack(
+                    HEADER_FMT,
+                    MAGIC,
+                    VERSION,
+                    self.steps,
+                    self.bodies,
+                    dt,
+                    b"\x00" * 32,
+                )
+            )
+            np.array([self.strides, sizes, offsets[:-1]], dtype="<u8").T.tofile(f)
+            f.truncate(int(offsets[-1]))
+        self._out = [
+            np.memmap(self._part, dtype="<f8", mode="r+", offset=int(o), shape=(r, 6))
+            for o, r in zip(offsets[:-1], sizes)
+        ]
+
+    def write(self, y: FloatArray) -> None:
+        """Append rows of shape (rows, 6 * bodies)"""
+        self._append(simstate_view_from_state_view(y, self.bodies))
+
+    def _append(self, data: FloatArray) -> None:
+        """Append rows of shape (rows, bodies, 6)"""
+        start, stop = self.rows, self.rows + data.shape[0]
+        if stop > self.steps:
+            raise ValueError(f"{stop} rows exceed the {self.steps} of the trajectory")
+        for body, (kept, out) in enumerate(zip(self._kept, self._out)):
+            first, last = np.searchsorted(kept, [start, stop])
+            out[first:last] = data[kept[first:last] - start, body]
+        self.rows = stop
+
+    def sync(self) -> None:
+        """Flush the samples written so far to disk"""
+        for out in self._out:
+            out.flush()
+
+    def close(self) -> None:
+        """Finish the file; raises if rows are missing"""
+        for out in self._out:
+            out.flush()
+        del self._out
+        if self.rows != self.steps:
+            self._part.unlink(missing_ok=True)
+            raise ValueError(f"{self.rows} rows written, trajectory has {self.steps}")
+        os.replace(self._part, self.filename)
+
+    def abort(self) -> None:
+        """Drop the partial file"""
+        del self._out
+        self._part.unlink(missing_ok=True)
+
+    def __enter__(self) -> "SimrateWriter":
+        return self
+
+    def __exit__(
+        self,
+        exc_type: Type[BaseException] | None,
+        exc: BaseException | None,
+        tb: TracebackType | None,
+    ) -> None:
+        if exc_type is None:
+            self.close()
+        else:
+            self.abort()
+
+
+def write_simrate(
+    filename: Path,
+    trajectory: Path,
+    strides: ArrayLike | None = None,
+    tolerance: float | None = None,
+) -> IntArray:
+    """
+    Sample the trajectory in `trajectory` per body in one sequential pass.
+
+    Parameters
+    ----------
+    filename : Path
+        Output trajectory (name__dt__steps.simstate, as `trajectory`)
+    trajectory : Path
+        Uniform-step trajectory, in any other .simstate layout
+    strides : ArrayLike | None
+        Stride of every body, e.g. from `cadence_from_periods`
+    tolerance : float | None
+        Position tolerance [m] to derive the strides from when `strides`
+        is None, see `cadence_for_tolerance`
+
+    Returns
+    -------
+    strides : np.ndarray
+        The strides used
+    """
+    sim = SimstateMemmap(trajectory)
+    if sim.dt <= 0:
+        raise ValueError("Per-body cadences need a uniform time step")
+    if strides is None:
+        if tolerance is None:
+            raise ValueError("Give either strides or a tolerance")
+        strides = cadence_for_tolerance(sim, tolerance)
+    block = max(1, BLOCK_BYTES // (sim.bodies * sim.state_dim * 8))
+    with SimrateWriter(filename, trajectory, strides) as w:
+        sim.advise("sequential")
+        for start in range(0, sim.steps, block):
+            w._append(np.asarray(sim.mm[start : start + block]))
+    return w.strides
+
+
+class SimrateMemmap:
+    """
+    Per-body samples of a trajectory stored at per-body cadences, read as
+    the full trajectory.
+
+    `samples[b]` holds the (rows, 6) states of body b at `sample_steps`.
+    Indexing as a (steps, bodies, 6) array (step, body and component, as
+    `TiledSimstate`) or `state(t, body)` reconstructs any body at any step
+    or time by cubic Hermite interpolation of its own samples.
+    """
+
+    dtype = np.dtype(np.float64)
+    ndim = 3
+
+    def __init__(self, filename: Path) -> None:
+        with open(filename, "rb") as f:
+            magic, version, steps, bodies, dt, _ = struct.unpack(
+                HEADER_FMT, f.read(HEADER_SIZE)
+            )
+            table = np.fromfile(f, dtype="<u8", count=BODY_FIELDS * bodies)
+        if magic != MAGIC:
+            raise ValueError("Not a SIMRATE file")
+        if version != VERSION:
+            raise ValueError(f"File version {version} != expected {VERSION}")
+
+        self.steps = steps
+        self.bodies = bodies
+        self.dt = dt
+        self.shape = (steps, bodies, 6)
+        self.strides = np.zeros(bodies, dtype=np.int64)
+        self.samples: List[np.memmap] = []
+        for body, (stride, rows, offset) in enumerate(
+            table.reshape(bodies, BODY_FIELDS)
+        ):
+            self.strides[body] = stride
+            self.samples.append(
+                np.memmap(
+                    filename,
+                    dtype="<f8",
+                    mode="r",
+                    offset=int(offset),
+                    shape=(int(rows), 6),
+                )
+            )
+        self._interpolators: Dict[int, "HermiteTrajectory"] = {}
+
+    def __len__(self) -> int:
+        return self.steps
+
+    @property
+    def nbytes(self) -> int:
+        """Size of the reconstructed trajectory"""
+        return self.steps * self.bodies * 6 * 8
+
+    @property
+    def stored_nbytes(self) -> int:
+        return sum(samples.nbytes for samples in self.samples)
+
+    def sample_steps(self, body: int) -> IntArray:
+        """Steps of the samples of `body`"""
+        return sample_steps(self.steps, int(self.strides[body]))
+
+    def _interpolator(self, body: int) -> "HermiteTrajectory":
+        if body not in self._interpolators:
+            # Imported late: optional native backend
+            from project.simulation.cpp_force_kernel import HermiteTrajectory
+
+            samples = self.samples[body]
+            self._interpolators[body] = HermiteTrajectory(
+                np.asarray(samples).reshape(-1, 1, 6),
+                0.0,
+                self.sample_steps(body) * float(self.dt),
+            )
+        return self._interpolators[body]
+
+    def state(self, t: FloatArray | float, body: IntArray | int) -> FloatArray:
+        """States [r, v] of shape (k, 6) at times `t` [s] of bodies `body`,
+        broadcast against each other"""
+        t_b, body_b = np.broadcast_arrays(
+            np.asarray(t, dtype=np.float64), np.asarray(body, dtype=np.intp)
+        )
+        times, bodies = t_b.ravel(), body_b.ravel()
+        out = np.empty((times.size, 6))
+        for b in np.unique(bodies):
+            picked = bodies == b
+            queries = np.ascontiguousarray(times[picked])
+            out[picked] = self._interpolator(int(b)).evaluate(
+                queries, np.zeros(queries.size, dtype=np.intp), 1
+            )
+        return out
+
+    def __getitem__(self, key: Index | Tuple[Index, ...]) -> FloatArray:
+        rows, rest = step_key(key, self.steps)
+        body, dim = body_key(rest)
+        # Bodies are few: plain NumPy index semantics
+        bodies = np.arange(self.bodies)[body]
+        r, b = np.atleast_1d(rows), np.atleast_1d(bodies)
+        data = np.empty((r.size, b.size, 6))
+        for j, body_j in enumerate(b):
+            data[:, j] = self.state(r * float(self.dt), int(body_j))
+        # Integer keys drop their axis
+        data = data[
+            tuple(0 if np.ndim(i) == 0 else slice(None) for i in (rows, bodies))
+        ]
+        return data[..., dim]
+
+    def __array__(self, dtype: Any = None, copy: Any = None) -> FloatArray:
+        data = self[:]
+        return data if dtype is None else data.astype(dtype)
@@ -0,0 +1,322 @@
+# SPDX-FileCopyrightText: © 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+#
+# SPDX-License-Identifier: AGPL-3.0-or-later
+
+"""Time-sharded trajectories
+
+A sharded trajectory `name__dt__steps.simstate` is a directory instead of a
+file: `manifest.toml` lists consecutive shards, each an ordinary .simstate
+file of its own (any version) holding the rows [start, start + steps) of
+the run. Shards can be copied, backed up or regenerated one at a time.
+
+`ShardedSimstate` presents them as one (steps, bodies, state_dim) array and
+only opens the shards an index touches, keeping the most recently used
+ones mapped; `SimstateMemmap` opens sharded trajectories through it.
+"""
+
+import os
+import shutil
+import tomllib
+from collections import OrderedDict
+from pathlib import Path
+from types import TracebackType
+from typing import Any, Dict, List, Tuple, Type
+
+import numpy as np
+import tomli_w
+
+from project.utils import FloatArray, Index
+from project.utils.simstate import (
+    SIMSTATE_FILE,
+    ChunkedSimstate,
+    SimstateMemmap,
+    SimstateWriter,
+    TiledSimstate,
+    block_runs,
+    parse_simstate_filename,
+    partial_filename,
+    read_simstate,
+    simstate_view_from_state_view,
+    step_key,
+)
+
+MANIFEST = "manifest.toml"
+MANIFEST_VERSION = 1
+DEFAULT_SHARD_STEPS = 1 << 20  # 48 MiB per shard and body (f64, 6 values)
+
+
+def is_sharded(filename: Path) -> bool:
+    """Whether `filename` is a sharded trajectory"""
+    return (filename / MANIFEST).is_file()
+
+
+def shard_filename(filename: Path, index: int, steps: int) -> Path:
+    """Shard `index` of `steps` rows of the sharded trajectory `filename`"""
+    name, dt, _ = parse_simstate_filename(filename)
+    return filename / SIMSTATE_FILE.format(f"{name}-{index:05d}", dt, steps - 1)
+
+
+def read_manifest(filename: Path) -> Dict[str, Any]:
+    """Manifest of a sharded trajectory: version, steps, bodies, state_dim,
+    dt and shards (file, start, steps), checked against the name"""
+    with open(filename / MANIFEST, "rb") as f:
+        manifest = tomllib.load(f)
+    if manifest["version"] != MANIFEST_VERSION:
+        raise ValueError(
+            f"Manifest version {manifest['version']} != expected {MANIFEST_VERSION}"
+        )
+    _, dt_f, steps_f = parse_simstate_filename(filename)
+    if dt_f != int(manifest["dt"]) or steps_f != manifest["steps"] - 1:
+        raise ValueError("Filename does not match manifest")
+    start = 0
+    for shard in manifest["shards"]:
+        if shard["start"] != start:
+            raise ValueError(f"{filename}: shard {shard['file']} is not contiguous")
+        start += shard["steps"]
+    if start != manifest["steps"]:
+        raise ValueError(f"{filename}: shards hold {start} of {manifest['steps']}")
+    return manifest
+
+
+def write_manifest(
+    filename: Path,
+    bodies: int,
+    state_dim: int,
+    dt: float,
+    shards: List[Dict[str, Any]],
+) -> None:
+    """Write the manifest of the shards (file, start, steps) in `filename`
+    atomically"""
+    manifest = {
+        "version": MANIFEST_VERSION,
+        "steps": sum(shard["steps"] for shard in shards),
+        "bodies": bodies,
+        "state_dim": state_dim,
+        "dt": float(dt),
+        "shards": shards,
+    }
+    path = filename / MANIFEST
+    part = partial_filename(path)
+    with open(part, "wb") as f:
+        tomli_w.dump(manifest, f)
+    os.replace(part, path)
+
+
+class ShardedSimstateWriter:
+    """
+    Writer of a sharded trajectory, with the interface of `SimstateWriter`.
+
+    Rows are split into shards of `shard_steps` rows, each written by a
+    `SimstateWriter` (so with the same compression or tiling options) and
+    added to the manifest once complete. The directory is built as
+    `<filename>.part` and renamed on close; aborting removes it.
+
+    Parameters
+    ----------
+    filename : Path
+        Output trajectory `name__dt__steps.simstate`, a directory
+    bodies : int
+        Number of bodies
+    shard_steps : int
+        Rows per shard, the last one holding the remainder
+    state_dim : int
+        Values per body and step
+    **options
+        `SimstateWriter` options of the shards (codec, error_bound, ...)
+    """
+
+    def __init__(
+        self,
+        filename: Path,
+        bodies: int,
+        shard_steps: int = DEFAULT_SHARD_STEPS,
+        state_dim: int = 6,
+        **options: Any,
+    ) -> None:
+        if shard_steps < 1:
+            raise ValueError("shard_steps must be positive")
+        _, dt, steps_f = parse_simstate_filename(filename)
+        if dt < 0:
+            raise ValueError("Sharded trajectories are fixed-step")
+        self.filename = filename
+        self.steps = steps_f + 1
+        self.bodies = bodies
+        self.state_dim = state_dim
+        self.shard_steps = shard_steps
+        self.dt = dt
+        self.rows = 0
+        self._options = options
+        self._shards: List[Dict[str, Any]] = []
+        self._writer: SimstateWriter | None = None
+
+        self._part = partial_filename(filename)
+        shutil.rmtree(self._part, ignore_errors=True)  # left by a failed run
+        self._part.mkdir(parents=True)
+
+    def write(self, y: FloatArray) -> None:
+        """Append rows of shape (rows, state_dim * bodies)"""
+        self._append(simstate_view_from_state_view(y, self.bodies))
+
+    def _append(self, data: FloatArray) -> None:
+        """Append rows of shape (rows, bodies, state_dim)"""
+        if self.rows + data.shape[0] > self.steps:
+            raise ValueError(
+                f"{self.rows + data.shape[0]} rows exceed the {self.steps} in the name"
+            )
+        done = 0
+        while done < data.shape[0]:
+            if self._writer is None:
+                self._open_shard()
+            writer = self._writer
+            assert writer is not None
+            rows = min(data.shape[0] - done, writer.steps - writer.rows)
+            writer._append(data[done : done + rows])
+            done += rows
+            self.rows += rows
+            if writer.rows == writer.steps:
+                self._close_shard()
+
+    def _open_shard(self) -> None:
+        steps = min(self.shard_steps, self.steps - self.rows)
+        path = self._part / shard_filename(self.filename, len(self._shards), steps).name
+        self._writer = SimstateWriter(
+            path, self.bodies, self.state_dim, **self._options
+        )
+
+    def _close_shard(self) -> None:
+        assert self._writer is not None
+        self._writer.close()
+        self._shards.append(
+            {
+                "file": self._writer.filename.name,
+                "start": self.rows - self._writer.steps,
+                "steps": self._writer.steps,
+            }
+        )
+        self._writer = None
+        write_manifest(self._part, self.bodies, self.state_dim, self.dt, self._shards)
+
+    def sync(self) -> None:
+        """Make the rows of the open shard durable (uncompressed shards)"""
+        if self._writer is not None:
+            self._writer.sync()
+
+    def close(self) -> None:
+        """Rename the directory into place; raises if rows are missing"""
+        if self.rows != self.steps:
+            self.abort()
+            raise ValueError(f"{self.rows} rows written, name expects {self.steps}")
+        if self.filename.is_dir():
+            shutil.rmtree(self.filename)
+        os.replace(self._part, self.filename)
+
+    def abort(self) -> None:
+        """Drop the partial directory"""
+        if self._writer is not None:
+            self._writer.abort()
+            self._writer = None
+        shutil.rmtree(self._part, ignore_errors=True)
+
+    def __enter__(self) -> "ShardedSimstateWriter":
+        return self
+
+    def __exit__(
+        self,
+        exc_type: Type[BaseException] | None,
+        exc: BaseException | None,
+        tb: TracebackType | None,
+    ) -> None:
+        if exc_type is None:
+            self.close()
+        else:
+            self.abort()
+
+
+def shard_simstate(
+    source: Path,
+    destination: Path,
+    shard_steps: int = DEFAULT_SHARD_STEPS,
+    **options: Any,
+) -> None:
+    """Copy the trajectory in `source` (any version or sharded) into the
+    sharded trajectory `destination`, one shard in memory at a time"""
+    sim = SimstateMemmap(source)
+    with ShardedSimstateWriter(
+        destination, sim.bodies, shard_steps, sim.state_dim, **options
+    ) as w:
+        for start in range(0, sim.steps, shard_steps):
+            w._append(np.asarray(sim.mm[start : start + shard_steps]))
+
+
+class ShardedSimstate:
+    """
+    Read-only (steps, bodies, state_dim) array over the shards of a sharded
+    trajectory.
+
+    Shards are opened on first access and at most `open_shards` stay
+    mapped, the least recently used being released first, so only the
+    time ranges being read are mapped. The first index selects steps (int,
+    slice or integer array); the remaining ones are applied to the selected
+    rows.
+    """
+
+    dtype = np.dtype(np.float64)
+    ndim = 3
+
+    def __init__(self, filename: Path, open_shards: int = 8) -> None:
+        manifest = read_manifest(filename)
+        self.filename = filename
+        self.dt = float(manifest["dt"])
+        self.shape = (manifest["steps"], manifest["bodies"], manifest["state_dim"])
+        self.files = [filename / shard["file"] for shard in manifest["shards"]]
+        self.starts = np.array(
+            [shard["start"] for shard in manifest["shards"]] + [self.shape[0]],
+            dtype=np.int64,
+        )
+        self._open: OrderedDict[int, "np.memmap | ChunkedSimstate | TiledSimstate"] = (
+            OrderedDict()
+        )
+        self._open_shards = open_shards
+
+    def __len__(self) -> int:
+        return self.shape[0]
+
+    @property
+    def nbytes(self) -> int:
+        return int(np.prod(self.shape)) * self.dtype.itemsize
+
+    def shard(self, index: int) -> "np.memmap | ChunkedSimstate | TiledSimstate":
+        """Array of shard `index`, opened if needed"""
+        if index in self._open:
+            self._open.move_to_end(index)
+            return self._open[index]
+
+        data, (steps, bodies, state_dim, _), _ = read_simstate(self.files[index])
+        if (steps, bodies, state_dim) != (
+            self.starts[index + 1] - self.starts[index],
+            *self.shape[1:],
+        ):
+            raise ValueError(f"{self.files[index]} does not match the manifest")
+
+        self._open[index] = data
+        if len(self._open) > self._open_shards:
+            self._open.popitem(last=False)
+        return data
+
+    def __getitem__(self, key: Index | Tuple[Index, ...]) -> FloatArray:
+        rows, rest = step_key(key, self.shape[0])
+        if isinstance(rows, int):
+            s = int(np.searchsorted(self.starts, rows, side="right")) - 1
+            row = np.asarray(self.shard(s)[rows - self.starts[s]])
+            return np.array(row[rest] if rest else row)
+
+        out = np.empty((rows.size, *self.shape[1:]), dtype=self.dtype)
+        shards = np.searchsorted(self.starts, rows, side="right") - 1
+        for s, start, stop in block_runs(shards):
+            out[start:stop] = self.shard(s)[rows[start:stop] - self.starts[s]]
+
+        return out[(slice(None), *rest)] if rest else out
+
+    def __array__(self, dtype: Any = None, copy: Any = None) -> FloatArray:
+        data = self[:]
+        return data if dtype is None else data.astype(dtype)
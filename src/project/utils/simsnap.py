@@ -0,0 +1,234 @@
+# SPDX-FileCopyrightText: © 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+#
+# SPDX-License-Identifier: AGPL-3.0-or-later
+
+"""Columnar initial-condition snapshots (.simsnap)
+
+Large body catalogues are stored as contiguous columns after a 64-byte
+header, every column 8-byte aligned so that it is memory-mapped in place:
+
+    mu          (n,)    f64, NaN when unknown
+    radius      (n,)    f64, NaN when unknown
+    r_0         (n, 3)  f64
+    v_0         (n, 3)  f64
+    name index  (n + 1) u64 offsets into the name bytes
+    names               utf-8, padded to 8 bytes
+    metadata            TOML text of `BodyList.metadata`
+
+Opening a snapshot reads the header only; `BodyList.load` serves `y_0` and
+`mu` from the columns without building a `Body` per entry.
+"""
+
+import os
+import struct
+import tomllib
+from pathlib import Path
+from types import TracebackType
+from typing import Dict, List, Literal, Sequence, Type
+
+import numpy as np
+import tomli_w
+from numpy.typing import ArrayLike
+
+from project.utils import FloatArray
+from project.utils.simstate import partial_filename
+
+SIMSNAP_EXTENSION = ".simsnap"
+
+MAGIC = b"SIMSNAP\x00"
+VERSION = 1
+HEADER_FMT = (
+    "<"  # little-endian
+    "8s"  # magic
+    "I"  # version
+    "Q"  # bodies
+    "Q"  # name bytes
+    "Q"  # metadata bytes
+    "28s"  # future / padding
+)
+HEADER_SIZE = struct.calcsize(HEADER_FMT)  # 64 bytes
+
+
+def _column_offsets(bodies: int, name_bytes: int) -> Dict[str, int]:
+    """Absolute offsets of the columns of a snapshot of `bodies` bodies"""
+    offsets = {}
+    offset = HEADER_SIZE
+    for column, size in (
+        ("mu", 8 * bodies),
+        ("radius", 8 * bodies),
+        ("r_0", 24 * bodies),
+        ("v_0", 24 * bodies),
+        ("name_index", 8 * (bodies + 1)),
+        ("names", -(-name_bytes // 8) * 8),
+        ("metadata", 0),
+    ):
+        offsets[column] = offset
+        offset += size
+    return offsets
+
+
+class SimsnapMemmap:
+    """
+    Columns of a .simsnap file, memory-mapped: `mu`, `radius` of shape (n,)
+    and `r_0`, `v_0` of shape (n, 3). Names are decoded on access.
+
+    With mode "r+" the columns are writable in place, e.g. to fill the
+    states of a `SimsnapWriter` snapshot.
+    """
+
+    def __init__(self, filename: Path, mode: Literal["r", "r+"] = "r") -> None:
+        with open(filename, "rb") as f:
+            magic, version, bodies, name_bytes, metadata_bytes, _ = struct.unpack(
+                HEADER_FMT, f.read(HEADER_SIZE)
+            )
+        if magic != MAGIC:
+            raise ValueError("Not a SIMSNAP file")
+        if version != VERSION:
+            raise ValueError(f"File version {version} != expected {VERSION}")
+        offsets = _column_offsets(bodies, name_bytes)
+        size = offsets["metadata"] + metadata_bytes
+        if filename.stat().st_size < size:
+            raise ValueError(f"truncated snapshot: {filename.stat().st_size} of {size}")
+
+        self.filename = filename
+        self.n = bodies
+        self._raw = np.memmap(filename, dtype=np.uint8, mode=mode, shape=(size,))
+
+        def column(name: str, dtype: str, shape: tuple[int, ...]) -> np.ndarray:
+            start = offsets[name]
+            count = int(np.prod(shape))
+            itemsize = np.dtype(dtype).itemsize
+            return (
+                self._raw[start : start + count * itemsize].view(dtype).reshape(shape)
+            )
+
+        self.mu: FloatArray = column("mu", "<f8", (bodies,))
+        self.radius: FloatArray = column("radius", "<f8", (bodies,))
+        self.r_0: FloatArray = column("r_0", "<f8", (bodies, 3))
+        self.v_0: FloatArray = column("v_0", "<f8", (bodies, 3))
+        self._name_index = column("name_index", "<u8", (bodies + 1,))
+        start = offsets["names"]
+        self._names = self._raw[start : start + name_bytes]
+        start = offsets["metadata"]
+        self._metadata = self._raw[start : start + metadata_bytes]
+
+    def name(self, index: int) -> str | None:
+        """Name of body `index`, None when unnamed"""
+        start, stop = self._name_index[index], self._name_index[index + 1]
+        return bytes(self._names[start:stop]).decode() or None
+
+    @property
+    def names(self) -> List[str | None]:
+        return [self.name(i) for i in range(self.n)]
+
+    @property
+    def metadata(self) -> Dict[str, str] | None:
+        if self._metadata.size == 0:
+            return None
+        return dict(tomllib.loads(bytes(self._metadata).decode()))
+
+    def flush(self) -> None:
+        self._raw.flush()
+
+
+class SimsnapWriter:
+    """
+    Build a .simsnap file whose states are filled in place: the names,
+    mu, radius and metadata are written up front and `snapshot` maps the
+    file writable, with zero states. The file is built as
+    `<filename>.part` and renamed on close.
+
+    Parameters
+    ----------
+    filename : Path
+        Output snapshot
+    names : Sequence[str | None]
+        Body names, their count setting the number of bodies
+    mu : ArrayLike
+        Gravitational parameters [m^3/s^2], NaN when unknown
+    radius : ArrayLike | None
+        Radii [m], by default unknown
+    metadata : Dict[str, str] | None
+        `BodyList.metadata`
+    """
+
+    def __init__(
+        self,
+        filename: Path,
+        names: Sequence[str | None],
+        mu: ArrayLike,
+        radius: ArrayLike | None = None,
+        metadata: Dict[str, str] | None = None,
+    ) -> None:
+        self.filename = filename
+        bodies = len(names)
+        encoded = [(name or "").encode() for name in names]
+        name_index = np.zeros(bodies + 1, dtype="<u8")
+        np.cumsum([len(e) for e in encoded], out=name_index[1:])
+        text = tomli_w.dumps(metadata).encode() if metadata else b""
+        offsets = _column_offsets(bodies, int(name_index[-1]))
+
+        self._part = partial_filename(filename)
+        with open(self._part, "wb") as f:
+            f.write(
+                struct.pack(
+                    HEADER_FMT,
+                    MAGIC,
+                    VERSION,
+                    bodies,
+                    int(name_index[-1]),
+                    len(text),
+                    b"\x00" * 28,
+                )
+            )
+            f.truncate(offsets["metadata"] + len(text))
+            f.seek(offsets["name_index"])
+            name_index.tofile(f)
+            f.write(b"".join(encoded))
+            f.seek(offsets["metadata"])
+            f.write(text)
+
+        self.snapshot = SimsnapMemmap(self._part, mode="r+")
+        self.snapshot.mu[:] = np.broadcast_to(np.asarray(mu, dtype=np.float64), bodies)
+        self.snapshot.radius[:] = (
+            np.nan if radius is None else np.asarray(radius, dtype=np.float64)
+        )
+
+    def close(self) -> None:
+        self.snapshot.flush()
+        del self.snapshot
+        os.replace(self._part, self.filename)
+
+    def abort(self) -> None:
+        """Drop the partial file"""
+        del self.snapshot
+        self._part.unlink(missing_ok=True)
+
+    def __enter__(self) -> "SimsnapWriter":
+        return self
+
+    def __exit__(
+        self,
+        exc_type: Type[BaseException] | None,
+        exc: BaseException | None,
+        tb: TracebackType | None,
+    ) -> None:
+        if exc_type is None:
+            self.close()
+        else:
+            self.abort()
+
+
+def write_simsnap(
+    filename: Path,
+    names: Sequence[str | None],
+    mu: ArrayLike,
+    r_0: ArrayLike,
+    v_0: ArrayLike,
+    radius: ArrayLike | None = None,
+    metadata: Dict[str, str] | None = None,
+) -> None:
+    """Write a complete snapshot; `r_0` and `v_0` of shape (n, 3)"""
+    with SimsnapWriter(filename, names, mu, radius, metadata) as w:
+        w.snapshot.r_0[:] = r_0
+        w.snapshot.v_0[:] = v_0
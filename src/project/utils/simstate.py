@@ -2,14 +2,36 @@
 #
 # SPDX-License-Identifier: AGPL-3.0-or-later
 
+import mmap
+import os
+import shutil
 import struct
-from io import BufferedReader, BufferedWriter
+from collections import OrderedDict
+from io import BufferedRandom, BufferedReader, BufferedWriter
 from pathlib import Path
-from typing import Literal, Tuple
+from types import TracebackType
+from typing import TYPE_CHECKING, Any, Iterator, List, Literal, Tuple, Type, cast
 
 import numpy as np
 
-from project.utils import FloatArray, Index
+from project.utils import FloatArray, Index, IntArray
+from project.utils.simstate_codec import (
+    DEFAULT_CODEC,
+    DEFAULT_DELTA_ORDER,
+    FILTER_NONE,
+    FILTER_QUANTIZE,
+    QUANTIZED_DELTA_ORDER,
+    codec_id,
+    decode_chunk,
+    decode_quantized_chunk,
+    encode_chunk,
+    encode_quantized_chunk,
+)
+
+if TYPE_CHECKING:
+    from project.simulation.cpp_force_kernel import SimstateReader
+    from project.utils.simrate import SimrateMemmap
+    from project.utils.simshards import ShardedSimstate
 
 SIMSTATE_EXTENSION = ".simstate"
 SIMSTATE_FILE = "{}__{}__{}" + SIMSTATE_EXTENSION  # name, dt, steps
@@ -28,6 +50,62 @@ HEADER_FMT = (
 )
 HEADER_SIZE = struct.calcsize(HEADER_FMT)  # 64 bytes
 
+# v2: independently compressed time chunks. The v1 padding holds the chunk
+# parameters, and the chunk offset table (n_chunks + 1 absolute offsets, the
+# last one marking the end of the chunk data) sits at `table_offset`
+VERSION_CHUNKED = 2
+HEADER_FMT_CHUNKED = (
+    "<"  # little-endian
+    "8s"  # magic
+    "I"  # version
+    "Q"  # steps
+    "I"  # bodies
+    "I"  # state_dim
+    "d"  # dt
+    "B"  # codec
+    "B"  # delta order
+    "H"  # filter (lossless or quantized)
+    "I"  # chunk_steps
+    "Q"  # table_offset
+    "12s"  # future / padding
+)
+CHUNK_BYTES = 1 << 20  # default decompressed chunk size, ~ms to decode
+
+# v3: uncompressed, body-major tiles. Every `tile_steps` steps are stored as
+# (bodies, state_dim, tile_steps), the last tile zero-padded, so the time
+# series of one body component is contiguous within a tile
+VERSION_TILED = 3
+HEADER_FMT_TILED = (
+    "<"  # little-endian
+    "8s"  # magic
+    "I"  # version
+    "Q"  # steps
+    "I"  # bodies
+    "I"  # state_dim
+    "d"  # dt
+    "I"  # tile_steps
+    "24s"  # future / padding
+)
+DEFAULT_TILE_STEPS = 4096  # 32 KiB per series and tile
+
+# Times per entry of the coarse index of variable-step files, one page of
+# the time column (TIME_INDEX_STRIDE in reader.hpp)
+TIME_INDEX_STRIDE = 512
+
+
+def pack_header(steps: int, bodies: int, state_dim: int, dt: float) -> bytes:
+    """Header of an uncompressed (v1) file"""
+    return struct.pack(
+        HEADER_FMT,
+        MAGIC,
+        VERSION,
+        steps,
+        bodies,
+        state_dim,
+        dt,
+        b"\x00" * 28,
+    )
+
 
 def write_header(
     f: BufferedWriter,
@@ -36,36 +114,99 @@ def write_header(
     state_dim: int,
     dt: float,
 ) -> None:
-    f.write(
-        struct.pack(
-            HEADER_FMT,
-            MAGIC,
-            VERSION,
-            steps,
-            bodies,
-            state_dim,
-            dt,
-            b"\x00" * 28,
-        )
+    f.write(pack_header(steps, bodies, state_dim, dt))
+
+
+def pack_header_chunked(
+    steps: int,
+    bodies: int,
+    state_dim: int,
+    dt: float,
+    codec: int,
+    delta_order: int,
+    chunk_steps: int,
+    filter_: int = FILTER_NONE,
+) -> bytes:
+    """Header of a chunked (v2) file, its offset table follows immediately"""
+    return struct.pack(
+        HEADER_FMT_CHUNKED,
+        MAGIC,
+        VERSION_CHUNKED,
+        steps,
+        bodies,
+        state_dim,
+        dt,
+        codec,
+        delta_order,
+        filter_,
+        chunk_steps,
+        HEADER_SIZE,
+        b"\x00" * 12,
     )
 
 
-def read_header(f: BufferedReader) -> Tuple[int, int, int, float]:
-    magic, version, steps, bodies, state_dim, dt, _ = struct.unpack(
-        HEADER_FMT, f.read(64)
+def pack_header_tiled(
+    steps: int, bodies: int, state_dim: int, dt: float, tile_steps: int
+) -> bytes:
+    """Header of a body-major tiled (v3) file"""
+    return struct.pack(
+        HEADER_FMT_TILED,
+        MAGIC,
+        VERSION_TILED,
+        steps,
+        bodies,
+        state_dim,
+        dt,
+        tile_steps,
+        b"\x00" * 24,
     )
 
+
+def read_header(f: BufferedReader) -> Tuple[int, int, int, float]:
+    steps, bodies, state_dim, dt, _, _ = read_header_version(f)
+    return steps, bodies, state_dim, dt
+
+
+def read_header_version(
+    f: BufferedReader,
+) -> Tuple[int, int, int, float, int, Tuple[Any, ...]]:
+    """Like `read_header`, plus the version and its layout fields: the v2
+    chunk fields (codec, delta order, filter, chunk_steps, table_offset),
+    (tile_steps,) for v3 and none for v1"""
+    raw = f.read(HEADER_SIZE)
+    magic, version = struct.unpack_from("<8sI", raw)
+
     if magic != MAGIC:
         raise ValueError("Not a SIMSTATE file")
 
-    if version != VERSION:
-        raise ValueError(f"File version {version} != expected {VERSION}")
+    if version == VERSION:
+        _, _, steps, bodies, state_dim, dt, _ = struct.unpack(HEADER_FMT, raw)
+        return steps, bodies, state_dim, dt, version, ()
 
-    return steps, bodies, state_dim, dt
+    if version == VERSION_CHUNKED:
+        fields = struct.unpack(HEADER_FMT_CHUNKED, raw)
+        steps, bodies, state_dim, dt = fields[2:6]
+        return steps, bodies, state_dim, dt, version, fields[6:11]
+
+    if version == VERSION_TILED:
+        fields = struct.unpack(HEADER_FMT_TILED, raw)
+        steps, bodies, state_dim, dt = fields[2:6]
+        return steps, bodies, state_dim, dt, version, fields[6:7]
+
+    raise ValueError(
+        f"File version {version} not in supported "
+        f"{(VERSION, VERSION_CHUNKED, VERSION_TILED)}"
+    )
 
 
 def write_simstate(
-    filename: Path, data: FloatArray, t: FloatArray | None = None
+    filename: Path,
+    data: FloatArray,
+    t: FloatArray | None = None,
+    codec: str | None = None,
+    chunk_steps: int | None = None,
+    error_bound: float | None = None,
+    tile_steps: int | None = None,
 ) -> None:
     """
     Write a complete simulation file (.simstate) from a full array.
@@ -76,6 +217,18 @@ def write_simstate(
         Path to the output file.
     data : np.ndarray
         Shape (steps, bodies, state_dim), dtype float64.
+    t : np.ndarray | None
+        Shape (steps,), strictly increasing times [s] of a variable-step
+        file (negative dt in the filename), written after the rows.
+    codec : str | None
+        Compress into a chunked v2 file ("zlib", "zstd" or "none"), by
+        default an uncompressed v1 file.
+    chunk_steps : int | None
+        Steps per compressed chunk, by default about 1 MiB of float64.
+    error_bound : float | None
+        Store lossy, see `SimstateWriter`.
+    tile_steps : int | None
+        Store body-major tiles of this many steps, see `SimstateWriter`.
     """
     if data.ndim != 3:
         raise ValueError("data must be (steps, bodies, state_dim)")
@@ -86,21 +239,417 @@ def write_simstate(
         filename=filename, data=data, t=t
     )
 
+    if (
+        t is not None
+        or dt < 0
+        or codec is not None
+        or error_bound is not None
+        or tile_steps is not None
+    ):
+        with SimstateWriter(
+            filename,
+            bodies,
+            state_dim,
+            codec,
+            chunk_steps,
+            error_bound,
+            tile_steps=tile_steps,
+        ) as w:
+            w._append(data, t)
+        return
+
     with open(filename, "wb") as f:
         write_header(f, steps, bodies, state_dim, dt)
         data.astype(np.float64, copy=False).tofile(f)
 
 
+class SimstateWriter:
+    """
+    Stream a .simstate file chunk by chunk, in constant memory.
+
+    The header is written up front from the step count and dt encoded in the
+    filename. Rows arrive in the integrator layout [r (3n), v (3n)] and are
+    interleaved one chunk at a time. The file is built as `<filename>.part`
+    and only renamed to `filename` once every row has been written, so an
+    interrupted run never leaves a truncated trajectory behind.
+
+    With a codec, rows are regrouped into chunks of `chunk_steps` steps that
+    are compressed independently (v2 container), and the chunk offset table
+    reserved after the header is filled in on close.
+
+    With an error bound, chunks are stored lossy for visualization: every
+    position is reconstructed within `error_bound` metres and every velocity
+    within `velocity_error_bound`, as integer multiples of twice the bound
+    around the chunk's first row. Reading back is transparent.
+
+    With `tile_steps`, rows are regrouped into uncompressed body-major tiles
+    (v3), transposed natively when the extension is available, so readers
+    of a few bodies over many steps touch contiguous series instead of one
+    page per step. `tile_steps` >= steps gives a fully body-major file.
+
+    With `extend`, the uncompressed (v1) trajectory in that file is moved to
+    `<filename>.part` and the rows written continue it in place: only the
+    new steps are written. Aborting puts the original file back.
+
+    A negative dt in the filename makes a variable-step file: every row
+    then comes with its time, strictly increasing, and the time column is
+    appended after the rows on close.
+
+    With `keep_partial`, aborting keeps `<filename>.part` for a later
+    `resume`, which continues it after its first `resume` rows (v1 only);
+    `sync` makes the rows written so far durable, see `Propagator`
+    checkpoints.
+
+    Parameters
+    ----------
+    filename : Path
+        Path to the output file (name__dt__steps.simstate).
+    bodies : int
+        Number of bodies.
+    codec : str | None
+        "zlib", "zstd" or "none" for a chunked v2 file, by default an
+        uncompressed v1 file.
+    chunk_steps : int | None
+        Steps per compressed chunk, by default about 1 MiB of float64.
+    error_bound : float | None
+        Absolute position error bound [m], by default lossless. Implies the
+        default codec if `codec` is None.
+    velocity_error_bound : float | None
+        Absolute velocity error bound [m/s], by default error_bound / |dt|,
+        which keeps the position drift over one step within the same bound.
+    tile_steps : int | None
+        Steps per body-major tile, by default step-major rows. Exclusive
+        with compression.
+    extend : Path | None
+        Shorter trajectory (same bodies and dt) that `filename` continues.
+    resume : int | None
+        Rows of an interrupted `<filename>.part` to keep and continue.
+    keep_partial : bool
+        Keep `<filename>.part` when aborted, by default removed.
+    """
+
+    def __init__(
+        self,
+        filename: Path,
+        bodies: int,
+        state_dim: int = 6,
+        codec: str | None = None,
+        chunk_steps: int | None = None,
+        error_bound: float | None = None,
+        velocity_error_bound: float | None = None,
+        tile_steps: int | None = None,
+        extend: Path | None = None,
+        resume: int | None = None,
+        keep_partial: bool = False,
+    ) -> None:
+        _, dt, steps_f = parse_simstate_filename(filename=filename)
+        self.filename = filename
+        self.steps = steps_f + 1
+        self.bodies = bodies
+        self.state_dim = state_dim
+        self.rows = 0
+        self._source = extend
+        self._keep_partial = keep_partial or resume is not None
+        self._variable = dt < 0
+        self._times: BufferedRandom | None = None
+        self._last_time = -np.inf
+
+        if tile_steps is not None and (
+            codec is not None or error_bound is not None or tile_steps < 1
+        ):
+            raise ValueError("Tiles are uncompressed and need tile_steps >= 1")
+        if error_bound is not None and codec is None:
+            codec = DEFAULT_CODEC
+        self._codec = None if codec is None else codec_id(codec)
+        self._tile_steps = tile_steps
+        self._pending: List[FloatArray] = []
+        self._pending_rows = 0
+
+        self._part = partial_filename(filename)
+        if extend is not None or resume is not None:
+            if codec is not None or error_bound is not None or tile_steps is not None:
+                raise ValueError("Only uncompressed trajectories can be continued")
+            if self._variable:
+                raise ValueError("Variable-step trajectories cannot be continued")
+            if extend is not None:
+                self._extend(extend, dt)
+            else:
+                self._resume(cast(int, resume), dt)
+            return
+        self._f = open(self._part, "wb")
+        if self._variable:
+            # Times are collected aside and appended after the rows
+            self._times = open(self._times_filename, "w+b")
+
+        if tile_steps is not None:
+            self.chunk_steps = tile_steps
+            self._f.write(
+                pack_header_tiled(self.steps, bodies, state_dim, dt, tile_steps)
+            )
+            return
+        if self._codec is None:
+            write_header(self._f, self.steps, bodies, state_dim, dt)
+            return
+
+        self._quantum = None
+        if error_bound is not None:
+            if state_dim != 6 or error_bound <= 0:
+                raise ValueError("Lossy storage needs [r, v] states and a bound > 0")
+            if velocity_error_bound is None:
+                velocity_error_bound = error_bound / (abs(dt) or 1)
+            self._quantum = 2 * np.repeat([error_bound, velocity_error_bound], 3)
+        self._order = (
+            DEFAULT_DELTA_ORDER if error_bound is None else QUANTIZED_DELTA_ORDER
+        )
+
+        if chunk_steps is None:
+            chunk_steps = max(16, CHUNK_BYTES // (8 * bodies * state_dim))
+        self.chunk_steps = chunk_steps
+        n_chunks = -(-self.steps // chunk_steps)
+        self._offsets = [HEADER_SIZE + 8 * (n_chunks + 1)]
+        self._f.write(
+            pack_header_chunked(
+                self.steps,
+                bodies,
+                state_dim,
+                dt,
+                self._codec,
+                self._order,
+                chunk_steps,
+                FILTER_NONE if self._quantum is None else FILTER_QUANTIZE,
+            )
+        )
+        self._f.write(b"\x00" * 8 * (n_chunks + 1))
+
+    def _extend(self, source: Path, dt: int) -> None:
+        with open(source, "rb") as f:
+            steps, bodies, state_dim, dt_s, version, _ = read_header_version(f)
+        _, _, steps_f = parse_simstate_filename(source)
+        if (
+            version != VERSION
+            or dt_s < 0
+            or int(dt_s) != dt
+            or (bodies, state_dim) != (self.bodies, self.state_dim)
+            or steps_f != steps - 1
+            or steps > self.steps
+        ):
+            raise ValueError(f"{source} cannot be extended into {self.filename}")
+
+        self._source_steps = steps
+        os.replace(source, self._part)
+        self._f = open(self._part, "r+b")
+        self._f.truncate(HEADER_SIZE + steps * bodies * state_dim * 8)
+        write_header(self._f, self.steps, bodies, state_dim, dt)
+        self._f.seek(0, os.SEEK_END)
+        self.rows = steps
+
+    def _resume(self, rows: int, dt: int) -> None:
+        with open(self._part, "rb") as f:
+            steps, bodies, state_dim, dt_p, version, _ = read_header_version(f)
+        row_bytes = bodies * state_dim * 8
+        if (
+            version != VERSION
+            or int(dt_p) != dt
+            or (steps, bodies, state_dim) != (self.steps, self.bodies, self.state_dim)
+            or self._part.stat().st_size < HEADER_SIZE + rows * row_bytes
+        ):
+            raise ValueError(f"{self._part} cannot be resumed at row {rows}")
+
+        # Rows written after the checkpoint are dropped and computed again
+        self._f = open(self._part, "r+b")
+        self._f.truncate(HEADER_SIZE + rows * row_bytes)
+        self._f.seek(0, os.SEEK_END)
+        self.rows = rows
+
+    def sync(self) -> None:
+        """Make the rows written so far durable (uncompressed files)"""
+        self._f.flush()
+        os.fsync(self._f.fileno())
+
+    @property
+    def _times_filename(self) -> Path:
+        return self._part.with_name(self._part.name + ".t")
+
+    def write(self, y: FloatArray, t: FloatArray | None = None) -> None:
+        """Append rows of shape (rows, state_dim * bodies), with their times
+        `t` [s] for variable-step files"""
+        self._append(simstate_view_from_state_view(y, self.bodies), t)
+
+    def _append(self, data: FloatArray, t: FloatArray | None = None) -> None:
+        """Append rows of shape (rows, bodies, state_dim)"""
+        if self.rows + data.shape[0] > self.steps:
+            raise ValueError(
+                f"{self.rows + data.shape[0]} rows exceed the {self.steps} in the header"
+            )
+        if (t is not None) != self._variable:
+            raise ValueError("Rows have times if and only if dt < 0")
+        if self._times is not None:
+            times = np.asarray(t, dtype="<f8").ravel()
+            if times.size != data.shape[0]:
+                raise ValueError(f"{times.size} times for {data.shape[0]} rows")
+            if np.any(np.diff(times, prepend=self._last_time) <= 0):
+                raise ValueError("Times must be strictly increasing")
+            if times.size:
+                self._last_time = times[-1]
+            times.tofile(self._times)
+        self.rows += data.shape[0]
+        if self._codec is None and self._tile_steps is None:
+            data.astype(np.float64, copy=False).tofile(self._f)
+            return
+
+        self._pending.append(data)
+        self._pending_rows += data.shape[0]
+        if self._pending_rows >= self.chunk_steps or self.rows == self.steps:
+            block = np.concatenate(self._pending)
+            done = 0
+            while block.shape[0] - done >= self.chunk_steps or (
+                self.rows == self.steps and done < block.shape[0]
+            ):
+                self._write_chunk(block[done : done + self.chunk_steps])
+                done += self.chunk_steps
+            self._pending = [block[done:]]
+            self._pending_rows = block.shape[0] - done
+
+    def _write_chunk(self, data: FloatArray) -> None:
+        if self._tile_steps is not None:
+            tile = np.zeros((self.bodies, self.state_dim, self._tile_steps))
+            _transpose_tile(np.asarray(data, dtype=np.float64), tile)
+            tile.tofile(self._f)
+            return
+        codec = self._codec or 0
+        if self._quantum is None:
+            self._f.write(encode_chunk(data, codec, self._order))
+        else:
+            self._f.write(
+                encode_quantized_chunk(data, codec, self._order, self._quantum)
+            )
+        self._offsets.append(self._f.tell())
+
+    def close(self) -> None:
+        """Finish the file; raises if rows are missing"""
+        if self._times is not None:
+            if self.rows == self.steps:
+                self._times.seek(0)
+                shutil.copyfileobj(self._times, self._f)
+            self._close_times()
+        if self._codec is not None and self.rows == self.steps:
+            self._f.seek(HEADER_SIZE)
+            self._f.write(np.asarray(self._offsets, dtype="<u8").tobytes())
+        self._f.close()
+        if self.rows != self.steps:
+            self._part.unlink(missing_ok=True)
+            raise ValueError(f"{self.rows} rows written, header expects {self.steps}")
+        os.replace(self._part, self.filename)
+
+    def _close_times(self) -> None:
+        if self._times is not None:
+            self._times.close()
+            self._times = None
+            self._times_filename.unlink(missing_ok=True)
+
+    def abort(self) -> None:
+        """Drop the partial file, or restore the extended one, or keep it"""
+        self._close_times()
+        if self._keep_partial:
+            self._f.close()
+            return
+        if self._source is not None:
+            steps = self._source_steps
+            self._f.truncate(HEADER_SIZE + steps * self.bodies * self.state_dim * 8)
+            self._f.seek(0)
+            _, dt, _ = parse_simstate_filename(self._source)
+            write_header(self._f, steps, self.bodies, self.state_dim, dt)
+            self._f.close()
+            os.replace(self._part, self._source)
+            return
+        self._f.close()
+        self._part.unlink(missing_ok=True)
+
+    def __enter__(self) -> "SimstateWriter":
+        return self
+
+    def __exit__(
+        self,
+        exc_type: Type[BaseException] | None,
+        exc: BaseException | None,
+        tb: TracebackType | None,
+    ) -> None:
+        if exc_type is None:
+            self.close()
+        else:
+            self.abort()
+
+
+def _transpose_tile(block: FloatArray, tile: FloatArray) -> None:
+    """Write (rows, bodies, state_dim) `block` into the first rows of a
+    (bodies, state_dim, tile_steps) tile"""
+    try:
+        # Imported late: the extension package imports this module
+        from project.simulation.cpp_force_kernel import transpose_tile_cpp
+    except ImportError:  # optional native backend
+        tile[:, :, : block.shape[0]] = block.transpose(1, 2, 0)
+        return
+    transpose_tile_cpp(block, tile)
+
+
+def retile_simstate(
+    source: Path, destination: Path, tile_steps: int = DEFAULT_TILE_STEPS
+) -> None:
+    """Rewrite a .simstate file as body-major tiles, one tile in memory at a
+    time; both names must share the name__dt__steps stem"""
+    sim = SimstateMemmap(source)
+    with SimstateWriter(
+        destination, sim.bodies, sim.state_dim, tile_steps=tile_steps
+    ) as w:
+        for start in range(0, sim.steps, tile_steps):
+            w._append(np.asarray(sim.mm[start : start + tile_steps]))
+
+
+def extend_simstate(
+    source: Path, tail: Path, destination: Path, block_steps: int = 1 << 14
+) -> None:
+    """Continue the uncompressed trajectory `source` in place with `tail`,
+    whose first step is the last of `source`, and rename it `destination`"""
+    sim = SimstateMemmap(tail)
+    with SimstateWriter(destination, sim.bodies, sim.state_dim, extend=source) as w:
+        sim.advise("sequential")
+        for start in range(1, sim.steps, block_steps):
+            w._append(np.asarray(sim.mm[start : start + block_steps]))
+
+
+def partial_filename(filename: Path) -> Path:
+    """Where a file is built before being renamed into place"""
+    return filename.with_name(filename.name + ".part")
+
+
+def cached_simstates(directory: Path, name: str, dt: float) -> List[Tuple[int, Path]]:
+    """(steps, path) of the trajectories of `name` at `dt` in `directory`,
+    shortest first; `steps` as in the filename"""
+    found = []
+    for path in directory.glob(SIMSTATE_FILE.format(name, dt, "*")):
+        try:
+            _, _, steps_f = parse_simstate_filename(path)
+        except ValueError:  # "*" matched more than the steps
+            continue
+        found.append((steps_f, path))
+    return sorted(found)
+
+
 def read_simstate(
     filename: Path,
-) -> Tuple[np.memmap, Tuple[int, int, int, float], np.memmap | None]:
+) -> Tuple[
+    "np.memmap | ChunkedSimstate | TiledSimstate",
+    Tuple[int, int, int, float],
+    np.memmap | None,
+]:
     """
     Read a .simstate file into memory.
 
     Returns
     -------
-    data : np.ndarray
-        Array of shape (steps, bodies, state_dim)
+    data : np.memmap | ChunkedSimstate | TiledSimstate
+        Array of shape (steps, bodies, state_dim), decompressed on access for
+        chunked files and gathered from tiles for tiled files
     header : tuple
         (steps, bodies, state_dim, dt)
     t : np.ndarray | None
@@ -108,22 +657,33 @@ def read_simstate(
     """
     with open(filename, "rb") as f:
         steps, bodies, state_dim, dt = validate_simstate_file(filename=filename, file=f)
+        f.seek(0)
+        *_, version, fields = read_header_version(f)
 
-    # Memmap of remaining data
-    mm = np.memmap(
-        filename=filename,
-        dtype="float64",
-        mode="r",
-        offset=HEADER_SIZE,
-        shape=(steps, bodies, state_dim),
-    )
+    mm: np.memmap | ChunkedSimstate | TiledSimstate
+    if version == VERSION_CHUNKED:
+        mm = ChunkedSimstate(filename, steps, bodies, state_dim, *fields)
+        data_end = mm.data_end
+    elif version == VERSION_TILED:
+        mm = TiledSimstate(filename, steps, bodies, state_dim, *fields)
+        data_end = mm.data_end
+    else:
+        # Memmap of remaining data
+        mm = np.memmap(
+            filename=filename,
+            dtype="float64",
+            mode="r",
+            offset=HEADER_SIZE,
+            shape=(steps, bodies, state_dim),
+        )
+        data_end = HEADER_SIZE + mm.nbytes
 
     if dt < 0:
         t = np.memmap(
             filename=filename,
             dtype="float64",
             mode="r",
-            offset=HEADER_SIZE + mm.nbytes,
+            offset=data_end,
             shape=(steps,),
         )
     else:
@@ -179,9 +739,373 @@ def simstate_view_from_state_view(y: FloatArray, n: int) -> FloatArray:
     return np.concatenate([y_r, y_v], axis=-1)  # shape = (steps, n, 6)
 
 
+def block_runs(blocks: IntArray) -> Iterator[Tuple[int, int, int]]:
+    """(block, start, stop) of each run of equal consecutive entries of
+    `blocks`, e.g. the chunk holding each selected row; none when empty"""
+    if blocks.size == 0:
+        return
+    runs = np.flatnonzero(np.diff(blocks)) + 1
+    for start, stop in zip(
+        np.concatenate([[0], runs]), np.concatenate([runs, [blocks.size]])
+    ):
+        yield int(blocks[start]), int(start), int(stop)
+
+
+def step_key(
+    key: Index | Tuple[Index, ...], steps: int
+) -> Tuple[int | IntArray, Tuple[Index, ...]]:
+    """Split an index of a (steps, ...) array into the selected steps and
+    the indices of the remaining axes: an int for an integer step, else the
+    int64 rows of a slice or integer array, negative steps counted from the
+    end. A leading Ellipsis selects every step and stays in the rest."""
+    step, rest = (key[0], key[1:]) if isinstance(key, tuple) else (key, ())
+    if step is Ellipsis:
+        step, rest = slice(None), (Ellipsis, *rest)
+
+    if isinstance(step, (int, np.integer)):
+        i = int(step) + (steps if step < 0 else 0)
+        if not 0 <= i < steps:
+            raise IndexError(f"step {step} out of range for {steps} steps")
+        return i, rest
+    if isinstance(step, slice):
+        return np.arange(*step.indices(steps)), rest
+    rows = np.asarray(step, dtype=np.int64)
+    rows = np.where(rows < 0, rows + steps, rows)
+    if np.any((rows < 0) | (rows >= steps)):
+        raise IndexError(f"step {step} out of range for {steps} steps")
+    return rows, rest
+
+
+def body_key(rest: Tuple[Index, ...]) -> Tuple[Index, Index]:
+    """Body and component indices following the step index of a (steps,
+    bodies, state_dim) array, an Ellipsis standing for the missing ones"""
+    for k, index in enumerate(rest):
+        if index is Ellipsis:
+            rest = rest[:k] + (slice(None),) * (3 - len(rest)) + rest[k + 1 :]
+            break
+    if len(rest) > 2:
+        raise IndexError("too many indices")
+    body, dim = rest + (slice(None),) * (2 - len(rest))
+    return body, dim
+
+
+class ChunkedSimstate:
+    """
+    Read-only (steps, bodies, state_dim) array over a chunked v2 file.
+
+    Only the chunks touched by an index are decompressed (and dequantized
+    for lossy files), and the most recently used ones are kept, so
+    sequential playback and small random reads both cost about one chunk
+    decode. The first index selects steps
+    (int, slice or integer array); the remaining ones are applied to the
+    selected rows.
+
+    Parameters
+    ----------
+    cache_chunks : int
+        Decompressed chunks kept in memory.
+    """
+
+    dtype = np.dtype(np.float64)
+    ndim = 3
+
+    def __init__(
+        self,
+        filename: Path,
+        steps: int,
+        bodies: int,
+        state_dim: int,
+        codec: int,
+        delta_order: int,
+        filter_: int,
+        chunk_steps: int,
+        table_offset: int,
+        cache_chunks: int = 8,
+    ) -> None:
+        self.shape = (steps, bodies, state_dim)
+        self.codec = codec
+        self.delta_order = delta_order
+        self.lossy = filter_ == FILTER_QUANTIZE
+        self._decode = decode_quantized_chunk if self.lossy else decode_chunk
+        self.chunk_steps = chunk_steps
+
+        n_chunks = -(-steps // chunk_steps)
+        self._raw = np.memmap(filename, dtype=np.uint8, mode="r")
+        self._offsets = np.frombuffer(
+            self._raw[table_offset : table_offset + 8 * (n_chunks + 1)], dtype="<u8"
+        ).astype(np.int64)
+        self.data_end = int(self._offsets[-1])
+
+        self._cache: OrderedDict[int, FloatArray] = OrderedDict()
+        self._cache_chunks = cache_chunks
+
+    def __len__(self) -> int:
+        return self.shape[0]
+
+    @property
+    def nbytes(self) -> int:
+        """Decompressed size"""
+        return int(np.prod(self.shape)) * self.dtype.itemsize
+
+    @property
+    def compressed_nbytes(self) -> int:
+        return int(self._offsets[-1] - self._offsets[0])
+
+    def chunk(self, index: int) -> FloatArray:
+        """Decompressed chunk `index` (read-only)"""
+        if index in self._cache:
+            self._cache.move_to_end(index)
+            return self._cache[index]
+
+        start = index * self.chunk_steps
+        rows = min(self.chunk_steps, self.shape[0] - start)
+        data = self._decode(
+            self._raw[self._offsets[index] : self._offsets[index + 1]],
+            self.codec,
+            self.delta_order,
+            rows,
+            self.shape[1],
+            self.shape[2],
+        )
+        data.flags.writeable = False
+
+        self._cache[index] = data
+        if len(self._cache) > self._cache_chunks:
+            self._cache.popitem(last=False)
+        return data
+
+    def __getitem__(self, key: Index | Tuple[Index, ...]) -> FloatArray:
+        rows, rest = step_key(key, self.shape[0])
+        if isinstance(rows, int):
+            row = self.chunk(rows // self.chunk_steps)[rows % self.chunk_steps]
+            return np.array(row[rest] if rest else row)
+
+        out = np.empty((rows.size, *self.shape[1:]), dtype=self.dtype)
+        for c, start, stop in block_runs(rows // self.chunk_steps):
+            out[start:stop] = self.chunk(c)[rows[start:stop] - c * self.chunk_steps]
+
+        return out[(slice(None), *rest)] if rest else out
+
+    def __array__(self, dtype: Any = None, copy: Any = None) -> FloatArray:
+        data = self[:]
+        return data if dtype is None else data.astype(dtype)
+
+
+class TiledSimstate:
+    """
+    Read-only (steps, bodies, state_dim) array over a body-major tiled v3
+    file.
+
+    `tiles` is the raw (n_tiles, bodies, state_dim, tile_steps) array over
+    the mapped file.
+    Indexing gathers the requested steps from the series of the requested
+    bodies only, so reading a few bodies over many steps stays within a few
+    contiguous runs per tile.
+    """
+
+    def __init__(
+        self,
+        filename: Path,
+        steps: int,
+        bodies: int,
+        state_dim: int,
+        tile_steps: int,
+    ) -> None:
+        self.steps = steps
+        self.bodies = bodies
+        self.state_dim = state_dim
+        self.tile_steps = tile_steps
+        self.shape = (steps, bodies, state_dim)
+        self.dtype = np.dtype(np.float64)
+        self.ndim = 3
+        # The file is mapped whole so that its pages can be advised; the
+        # tiles are a read-only array over the map past the header
+        with open(filename, "rb") as f:
+            self._mmap = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        self.tiles: FloatArray = np.ndarray(
+            (-(-steps // tile_steps), bodies, state_dim, tile_steps),
+            dtype="<f8",
+            buffer=self._mmap,
+            offset=HEADER_SIZE,
+        )
+        self.data_end = HEADER_SIZE + self.tiles.nbytes
+        # Series are read a few at a time: kernel read-around would pull in
+        # whole tiles of other bodies, so reads are prefetched explicitly
+        self._advise = hasattr(mmap, "MADV_RANDOM")
+        if self._advise:
+            self._mmap.madvise(mmap.MADV_RANDOM)
+
+    def __len__(self) -> int:
+        return self.steps
+
+    @property
+    def nbytes(self) -> int:
+        return self.steps * self.bodies * self.state_dim * 8
+
+    def __getitem__(self, key: Index | Tuple[Index, ...]) -> FloatArray:
+        rows, rest = step_key(key, self.steps)
+        body, dim = body_key(rest)
+        # Bodies and components are few: plain NumPy index semantics
+        bodies = np.arange(self.bodies)[body]
+        dims = np.arange(self.state_dim)[dim]
+
+        r = np.atleast_1d(rows)
+        b, d = np.atleast_1d(bodies), np.atleast_1d(dims)
+        data = np.empty((r.size, b.size, d.size), dtype=self.dtype)
+        tiles = r // self.tile_steps
+        if self._advise and r.size and b.size and d.size:
+            self._prefetch(np.unique(tiles), b, d)
+        for c, start, stop in block_runs(tiles):
+            series = self.tiles[c][np.ix_(b, d)]  # (bodies, dims, tile_steps)
+            local = r[start:stop] - c * self.tile_steps
+            data[start:stop] = series[:, :, local].transpose(2, 0, 1)
+        # Integer keys drop their axis
+        return data[
+            tuple(0 if np.ndim(i) == 0 else slice(None) for i in (rows, bodies, dims))
+        ]
+
+    def __array__(self, dtype: Any = None, copy: Any = None) -> FloatArray:
+        data = self[:]
+        return data if dtype is None else data.astype(dtype)
+
+    def _prefetch(self, tiles: IntArray, bodies: IntArray, dims: IntArray) -> None:
+        """Start reading the series spans of `bodies` x `dims` in `tiles`"""
+        series = self.tile_steps * 8
+        first, last = int(dims.min()), int(dims.max()) + 1
+        for c in tiles:
+            for body in np.unique(bodies):
+                index = (int(c) * self.bodies + int(body)) * self.state_dim
+                start = HEADER_SIZE + (index + first) * series
+                aligned = start - start % mmap.PAGESIZE
+                self._mmap.madvise(
+                    mmap.MADV_WILLNEED,
+                    aligned,
+                    start - aligned + (last - first) * series,
+                )
+
+
+class PrefixSimstate:
+    """
+    Read-only view of the first `steps` steps of a longer chunked, tiled,
+    sharded or per-body cadence array: steps are resolved against the
+    prefix, then read from the base.
+    """
+
+    dtype = np.dtype(np.float64)
+    ndim = 3
+
+    def __init__(
+        self,
+        base: "ChunkedSimstate | TiledSimstate | ShardedSimstate | SimrateMemmap",
+        steps: int,
+    ) -> None:
+        self.base = base
+        self.shape = (steps, *base.shape[1:])
+
+    def __len__(self) -> int:
+        return self.shape[0]
+
+    @property
+    def nbytes(self) -> int:
+        return int(np.prod(self.shape)) * self.dtype.itemsize
+
+    def __getitem__(self, key: Index | Tuple[Index, ...]) -> FloatArray:
+        rows, rest = step_key(key, self.shape[0])
+        return self.base[(rows, *rest)]
+
+    def __array__(self, dtype: Any = None, copy: Any = None) -> FloatArray:
+        data = self[:]
+        return data if dtype is None else data.astype(dtype)
+
+
+class TimeIndex:
+    """
+    Step lookup in the sorted time column of a variable-step file, as the
+    native `SimstateReader.steps_at`: the coarse index of every `stride`-th
+    time is searched first, then only one block of the column is read.
+    """
+
+    def __init__(self, t: FloatArray, stride: int = TIME_INDEX_STRIDE) -> None:
+        self.t = t
+        self.stride = stride
+        self.coarse = np.array(t[::stride], dtype=np.float64)
+
+    def steps_at(self, time: FloatArray | float) -> IntArray:
+        """Last step whose time is <= `time`, 0 before the first step"""
+        queries = np.asarray(time, dtype=np.float64)
+        flat = queries.ravel()
+        blocks = np.searchsorted(self.coarse, flat, side="right") - 1
+        out = np.zeros(flat.shape, dtype=np.int64)
+        for block in np.unique(blocks[blocks >= 0]):
+            picked = blocks == block
+            first = int(block) * self.stride
+            column = np.asarray(self.t[first : first + self.stride])
+            out[picked] = first + np.searchsorted(column, flat[picked], "right") - 1
+        return out.reshape(queries.shape)
+
+
+def _map_simstate(filename: Path) -> "SimstateReader | None":
+    """Native reader of an uncompressed .simstate file, None without the
+    extension or for compressed and tiled files"""
+    _, dt_f, steps_f = parse_simstate_filename(filename=filename)
+    try:
+        # Imported late: the extension package imports this module
+        from project.simulation.cpp_force_kernel import SimstateReader
+    except ImportError:  # optional native backend
+        return None
+    try:
+        reader = SimstateReader(str(filename))
+    except RuntimeError:  # not mappable, read_simstate reports what is wrong
+        return None
+    if dt_f != int(reader.dt) or steps_f != reader.steps - 1:
+        raise ValueError("Filename does not match file header")
+    return reader
+
+
 class SimstateMemmap:
-    def __init__(self, filename: Path) -> None:
-        mm, (steps, bodies, state_dim, dt), t = read_simstate(filename)
+    """Lazy view of a .simstate file; `mm` is a memmap for uncompressed files,
+    a `ChunkedSimstate` for compressed ones, a `TiledSimstate` for
+    body-major ones, a `ShardedSimstate` for sharded trajectories and a
+    `SimrateMemmap` for trajectories stored at per-body cadences
+
+    With the native extension, uncompressed files are mapped once by a
+    `SimstateReader` (`native`): `mm` is then a read-only array over its
+    buffer and `r`/`v` views are built in C++ without copying.
+
+    With `steps`, only the first `steps` steps of the file are exposed, so
+    a shorter run is served from a longer trajectory of the same system.
+    """
+
+    def __init__(self, filename: Path, steps: int | None = None) -> None:
+        # Imported late: shards and cadences are read through this module
+        from project.utils.simrate import SimrateMemmap, is_simrate
+        from project.utils.simshards import ShardedSimstate, is_sharded
+
+        sharded = is_sharded(filename)
+        cadenced = not sharded and is_simrate(filename)
+        self.native = None if sharded or cadenced else _map_simstate(filename)
+        mm: (
+            "np.ndarray | ChunkedSimstate | TiledSimstate | ShardedSimstate"
+            " | SimrateMemmap | PrefixSimstate"
+        )
+        if sharded:
+            mm = ShardedSimstate(filename)
+            dt, t = mm.dt, None
+        elif cadenced:
+            mm = SimrateMemmap(filename)
+            dt, t = mm.dt, None
+        elif self.native is not None:
+            mm = np.asarray(self.native)
+            dt, t = self.native.dt, self.native.times()
+        else:
+            mm, (_, _, _, dt), t = read_simstate(filename)
+        if steps is not None and steps < mm.shape[0]:
+            if isinstance(mm, np.ndarray):
+                mm = mm[:steps]
+            else:
+                mm = PrefixSimstate(mm, steps)
+            t = None if t is None else t[:steps]
+        steps, bodies, state_dim = mm.shape
         self.mm = mm
         self.steps = steps
         self.bodies = bodies
@@ -189,6 +1113,13 @@ class SimstateMemmap:
         self.dt = dt
 
         self._t = t
+        self._time_index: TimeIndex | None = None
+        # Native views span the whole file: not for prefixes
+        self._native_views = (
+            self.native
+            if self.native is not None and self.native.steps == steps
+            else None
+        )
 
         self._r_view = _RVView(self, "r")
         self._v_view = _RVView(self, "v")
@@ -220,6 +1151,31 @@ class SimstateMemmap:
             return np.arange(self.steps) * self.dt
         return self._t
 
+    def step_at(self, time: FloatArray | float) -> IntArray:
+        """Steps at or before `time` [s], clamped to the trajectory: a
+        division for fixed-step files, an O(log n) search of the time
+        column for variable-step ones (native when mapped natively)"""
+        if self.native is not None:
+            steps = self.native.steps_at(time)
+        elif self._t is None:
+            steps = np.floor(np.asarray(time, dtype=np.float64) / self.dt)
+        else:
+            if self._time_index is None:
+                self._time_index = TimeIndex(self._t)
+            steps = self._time_index.steps_at(time)
+        return np.clip(steps, 0, self.steps - 1).astype(np.int64)
+
+    def advise(
+        self,
+        pattern: Literal["normal", "sequential", "random", "willneed", "dontneed"],
+        start: int = 0,
+        stop: int | None = None,
+    ) -> None:
+        """Hint the access pattern of steps [start, stop) to the kernel; only
+        natively mapped files take hints"""
+        if self.native is not None:
+            self.native.advise(pattern, start, stop)
+
 
 class _RVView:
     def __init__(self, parent: "SimstateMemmap", rv: Literal["r", "v"]) -> None:
@@ -227,6 +1183,12 @@ class _RVView:
         self._rv = rv
 
     def __getitem__(self, key: Index | Tuple[Index, ...]) -> FloatArray:
+        native = self._parent._native_views
+        if native is not None:
+            view = native.rv(key, self._rv == "v")
+            if view is not None:
+                return view
+
         data = self._parent.mm
         last_dim = slice(0, 3) if self._rv == "r" else slice(3, 6)
 
@@ -245,9 +1207,9 @@ class _RVView:
 
         # Promote ints to slices for safe indexing
         if isinstance(step, int):
-            step = slice(step, step + 1)
+            step = slice(step, step + 1 or None)
         if isinstance(body, int):
-            body = slice(body, body + 1)
+            body = slice(body, body + 1 or None)
 
         return data[step, body, last_dim]
 
@@ -257,6 +1219,12 @@ class _RVVisView:
         self._base = base_view
 
     def __getitem__(self, key: Index | Tuple[Index, ...]) -> FloatArray:
+        native = self._base._parent._native_views
+        if native is not None:
+            view = native.rv(key, self._base._rv == "v", True)
+            if view is not None:
+                return view
+
         # base returns (steps, bodies, 3)
         data = self._base[key]
         return np.transpose(data, (0, 2, 1))  # (steps, 3, bodies)
@@ -0,0 +1,149 @@
+# SPDX-FileCopyrightText: © 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+#
+# SPDX-License-Identifier: AGPL-3.0-or-later
+
+"""Chunk codecs of the .simstate v2 container
+
+A chunk of `rows` steps is stored per body and component: the float64 bit
+patterns of each time series are differenced `order` times as unsigned
+integers (wrapping, so exactly invertible), then the 8 bytes of every value
+are split into 8 byte planes (byte-shuffle) before compression. Smooth
+trajectories leave mostly zero high-order bytes in the differences, which
+the byte planes expose as long runs to the codec.
+
+Quantized (lossy) chunks replace the bit patterns by integer multiples of a
+per-component quantum q around a per-chunk reference (the chunk's first
+row), so every value is reconstructed within q / 2 (plus float64 rounding)
+and the integer series difference to a few significant bits.
+"""
+
+import zlib
+from typing import Callable, Dict, Tuple
+
+import numpy as np
+
+from project.utils import FloatArray
+
+try:
+    import zstandard
+except ImportError:  # optional dependency
+    zstandard = None
+
+CODEC_NONE = 0
+CODEC_ZLIB = 1
+CODEC_ZSTD = 2
+
+CODEC_IDS: Dict[str, int] = {"none": CODEC_NONE, "zlib": CODEC_ZLIB, "zstd": CODEC_ZSTD}
+DEFAULT_CODEC = "zstd" if zstandard is not None else "zlib"
+DEFAULT_DELTA_ORDER = 3
+QUANTIZED_DELTA_ORDER = 2  # rounding noise dominates higher differences
+
+FILTER_NONE = 0
+FILTER_QUANTIZE = 1
+
+
+def _codec(codec: int) -> Tuple[Callable[[bytes], bytes], Callable[[bytes], bytes]]:
+    """(compress, decompress) pair of a codec id"""
+    if codec == CODEC_NONE:
+        return bytes, bytes
+    if codec == CODEC_ZLIB:
+        return lambda b: zlib.compress(b, 1), zlib.decompress
+    if codec == CODEC_ZSTD:
+        if zstandard is None:
+            raise ValueError("zstd codec requires the 'zstandard' package")
+        return (
+            zstandard.ZstdCompressor(level=3).compress,
+            zstandard.ZstdDecompressor().decompress,
+        )
+    raise ValueError(f"Unknown codec id {codec}")
+
+
+def codec_id(codec: str) -> int:
+    if codec not in CODEC_IDS:
+        raise ValueError(f"Unknown codec '{codec}', expected one of {list(CODEC_IDS)}")
+    _codec(CODEC_IDS[codec])  # fail early if unavailable
+    return CODEC_IDS[codec]
+
+
+def encode_chunk(data: FloatArray, codec: int, order: int) -> bytes:
+    """Compress a (rows, bodies, state_dim) float64 block"""
+    return _encode_series(
+        _series(np.asarray(data, dtype=np.float64)).view(np.uint64), codec, order
+    )
+
+
+def decode_chunk(
+    buffer: bytes, codec: int, order: int, rows: int, bodies: int, state_dim: int
+) -> FloatArray:
+    """Inverse of `encode_chunk`, returns a (rows, bodies, state_dim) block"""
+    series = _decode_series(buffer, codec, order, bodies * state_dim, rows)
+    return _block(series.view(np.float64), bodies, state_dim)
+
+
+def encode_quantized_chunk(
+    data: FloatArray, codec: int, order: int, quantum: FloatArray
+) -> bytes:
+    """Compress a (rows, bodies, state_dim) block to multiples of `quantum`
+    (one per state component) around its first row"""
+    bodies = data.shape[1]
+    series = _series(np.asarray(data, dtype=np.float64))
+    reference = series[:, 0].copy()
+    q = np.rint((series - reference[:, None]) / np.tile(quantum, bodies)[:, None])
+    # Multiples must fit int64 with headroom, else the cast wraps silently
+    if q.size and not np.abs(q).max() < 2**62:
+        raise ValueError(
+            "error_bound too small for the range of the values: quantized "
+            "offsets exceed 2**62"
+        )
+    q = q.astype(np.int64)
+    return (
+        reference.tobytes()
+        + np.asarray(quantum, dtype=np.float64).tobytes()
+        + _encode_series(q.view(np.uint64), codec, order)
+    )
+
+
+def decode_quantized_chunk(
+    buffer: bytes, codec: int, order: int, rows: int, bodies: int, state_dim: int
+) -> FloatArray:
+    """Inverse of `encode_quantized_chunk`, up to quantum / 2"""
+    cols = bodies * state_dim
+    head = 8 * (cols + state_dim)
+    reference = np.frombuffer(buffer[: 8 * cols], dtype=np.float64)
+    quantum = np.frombuffer(buffer[8 * cols : head], dtype=np.float64)
+    q = _decode_series(buffer[head:], codec, order, cols, rows).view(np.int64)
+    series = reference[:, None] + q * np.tile(quantum, bodies)[:, None]
+    return _block(series, bodies, state_dim)
+
+
+def _series(data: FloatArray) -> FloatArray:
+    """(rows, bodies, state_dim) -> contiguous (bodies * state_dim, rows)"""
+    return np.ascontiguousarray(data.reshape(data.shape[0], -1).T)
+
+
+def _block(series: FloatArray, bodies: int, state_dim: int) -> FloatArray:
+    """Inverse of `_series`"""
+    return np.ascontiguousarray(series.T).reshape(-1, bodies, state_dim)
+
+
+def _encode_series(series: np.ndarray, codec: int, order: int) -> bytes:
+    """Difference (cols, rows) uint64 series along time, shuffle, compress"""
+    for _ in range(order):
+        series[:, 1:] = np.diff(series, axis=1)
+    planes = np.ascontiguousarray(series.view(np.uint8).reshape(-1, 8).T)
+    return _codec(codec)[0](planes.tobytes())
+
+
+def _decode_series(
+    buffer: bytes, codec: int, order: int, cols: int, rows: int
+) -> np.ndarray:
+    """Inverse of `_encode_series`"""
+    planes = np.frombuffer(_codec(codec)[1](buffer), dtype=np.uint8)
+    series = (
+        np.ascontiguousarray(planes.reshape(8, -1).T)
+        .view(np.uint64)
+        .reshape(cols, rows)
+    )
+    for _ in range(order):
+        np.cumsum(series, axis=1, out=series)
+    return series
@@ -0,0 +1,129 @@
+# SPDX-FileCopyrightText: © 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+#
+# SPDX-License-Identifier: AGPL-3.0-or-later
+
+from datetime import datetime
+from pathlib import Path
+
+import numpy as np
+import pytest
+
+from project.simulation.elements import (
+    ECLIPTIC_J2000,
+    elements_to_states,
+    read_mpcorb,
+    unpack_epoch,
+    write_catalogue_simsnap,
+)
+from project.utils import D, Dir, datetime_to_jd
+from project.utils.data import BodyList
+
+MU_SUN = 1.32712440018e20  # [m^3/s^2]
+
+
+def reference_states(elements: np.ndarray, mu: float) -> np.ndarray:
+    """States in the element reference plane through the true anomaly, by
+    bisection on Kepler's equation"""
+    a, e, i, node, peri, m = elements.T
+    m = np.mod(m, 2 * np.pi)
+    lo, hi = np.zeros_like(m), np.full_like(m, 2 * np.pi)
+    for _ in range(60):
+        mid = 0.5 * (lo + hi)
+        below = mid - e * np.sin(mid) < m
+        lo, hi = np.where(below, mid, lo), np.where(below, hi, mid)
+    E = 0.5 * (lo + hi)
+    nu = 2 * np.arctan2(np.sqrt(1 + e) * np.sin(E / 2), np.sqrt(1 - e) * np.cos(E / 2))
+    p = a * (1 - e**2)
+    r = p / (1 + e * np.cos(nu))
+    u = peri + nu
+    h = np.sqrt(mu * p)
+    pos = r[:, None] * np.stack(
+        [
+            np.cos(node) * np.cos(u) - np.sin(node) * np.sin(u) * np.cos(i),
+            np.sin(node) * np.cos(u) + np.cos(node) * np.sin(u) * np.cos(i),
+            np.sin(u) * np.sin(i),
+        ],
+        axis=1,
+    )
+    vel = -(mu / h)[:, None] * np.stack(
+        [
+            np.cos(node) * (np.sin(u) + e * np.sin(peri))
+            + np.sin(node) * (np.cos(u) + e * np.cos(peri)) * np.cos(i),
+            np.sin(node) * (np.sin(u) + e * np.sin(peri))
+            - np.cos(node) * (np.cos(u) + e * np.cos(peri)) * np.cos(i),
+            -(np.cos(u) + e * np.cos(peri)) * np.sin(i),
+        ],
+        axis=1,
+    )
+    return np.hstack([pos, vel])
+
+
+def test_states_match_reference() -> None:
+    """Bulk conversion, including eccentricities close to 1, a partial last
+    lane block, epoch propagation and the frame offset."""
+    k = 10_003
+    rng = np.random.default_rng(1)
+    elements = np.column_stack(
+        [
+            rng.uniform(0.5, 40.0, k) * D.au,
+            np.concatenate([rng.uniform(0.0, 0.99, k - 3), [0.0, 0.995, 0.9999]]),
+            rng.uniform(0.0, np.pi, k),
+            rng.uniform(0.0, 2 * np.pi, k),
+            rng.uniform(0.0, 2 * np.pi, k),
+            rng.uniform(-4 * np.pi, 4 * np.pi, k),
+        ]
+    )
+    r, v = elements_to_states(elements, MU_SUN, rotation=np.eye(3))
+    expected = reference_states(elements, MU_SUN)
+    scale = elements[:, :1]
+    np.testing.assert_allclose(r / scale, expected[:, :3] / scale, atol=1e-9)
+    speed = np.sqrt(MU_SUN / scale)
+    np.testing.assert_allclose(v / speed, expected[:, 3:] / speed, atol=1e-8)
+
+    # Advancing by dt is the conversion at M + n dt
+    dt = rng.uniform(-1e8, 1e8, k)
+    center = rng.normal(size=6) * 1e9
+    r_dt, v_dt = elements_to_states(elements, MU_SUN, dt, center)
+    advanced = elements.copy()
+    advanced[:, 5] += np.sqrt(MU_SUN / elements[:, 0] ** 3) * dt
+    r_m, v_m = elements_to_states(advanced, MU_SUN)
+    np.testing.assert_allclose((r_dt - center[:3]) / scale, r_m / scale, atol=1e-9)
+    np.testing.assert_allclose((v_dt - center[3:]) / speed, v_m / speed, atol=1e-8)
+
+    with pytest.raises(RuntimeError):
+        elements_to_states(np.array([[D.au, 1.2, 0.0, 0.0, 0.0, 0.0]]), MU_SUN)
+
+
+def test_mpcorb_catalogue_snapshot(tmp_path: Path) -> None:
+    """MPCORB lines become test particles of a snapshot, heliocentric about
+    the Sun of the body list and on their ecliptic orbits."""
+    a, e, incl = 2.7660512, 0.0794013, 10.58780
+    line = (
+        f"{'00001':<8}{3.34:5.2f} {0.15:5.2f} K2555 {188.70269:9.5f}  "
+        f"{73.27343:9.5f}  {80.25221:9.5f}  {incl:9.5f}  {e:9.7f} "
+        f"{0.21424651:11.8f} {a:11.7f}"
+    )
+    line = f"{line:<166}{'(1) Ceres':<28}"
+    mpcorb = tmp_path / "MPCORB.DAT"
+    mpcorb.write_text(f"MINOR PLANET CENTER ORBIT DATABASE\n{'-' * 160}\n{line}\n\n")
+    catalogue = read_mpcorb(mpcorb)
+    assert catalogue.names == ["(1) Ceres"] and len(catalogue) == 1
+    np.testing.assert_allclose(catalogue.elements[0, :2], [a * D.au, e])
+    assert catalogue.epoch[0] == unpack_epoch("K2555")
+    assert unpack_epoch("K25AV") == datetime_to_jd(datetime(2025, 10, 31))
+
+    body_list = BodyList.load(Dir.data / "sun_earth_moon_20260101.toml")
+    write_catalogue_simsnap(tmp_path / "ceres.simsnap", catalogue, body_list)
+    seeded = BodyList.load(tmp_path / "ceres.simsnap")
+    n = len(body_list)
+    assert len(seeded) == n + 1 and seeded[n].name == "(1) Ceres"
+    np.testing.assert_array_equal(seeded.y_0[: 3 * n], body_list.r_0)
+    assert seeded.mu[n] == 0.0
+
+    r = seeded.r_0.reshape(-1, 3)[n] - body_list.r_0[:3]
+    v = seeded.v_0.reshape(-1, 3)[n] - body_list.v_0[:3]
+    mu = body_list.mu[0]
+    energy = v @ v / 2 - mu / np.linalg.norm(r)
+    np.testing.assert_allclose(-mu / (2 * energy), a * D.au, rtol=1e-12)
+    h = ECLIPTIC_J2000.T @ np.cross(r, v)
+    np.testing.assert_allclose(np.rad2deg(np.arccos(h[2] / np.linalg.norm(h))), incl)
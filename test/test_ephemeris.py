@@ -0,0 +1,110 @@
+# SPDX-FileCopyrightText: © 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+#
+# SPDX-License-Identifier: AGPL-3.0-or-later
+
+from pathlib import Path
+
+import numpy as np
+import pytest
+
+from project.simulation.cpp_force_kernel import rk4_cpp
+from project.simulation.ephemeris import (
+    HermiteInterpolator,
+    SimephemMemmap,
+    load_ephemeris,
+    write_simephem,
+)
+from project.simulation.model import CPPPointMass
+from project.simulation.propagator import Propagator
+from project.utils import Dir
+from project.utils.data import BodyList
+from project.utils.simstate import SimstateMemmap, write_simstate
+
+TIME_STEP = 3600
+STEPS = 2000
+TOLERANCE = 10.0  # [m]
+
+
+@pytest.fixture(scope="module")
+def ephemeris(tmp_path_factory: pytest.TempPathFactory) -> tuple[Path, Path]:
+    tmp = tmp_path_factory.mktemp("ephemeris")
+    body_list = BodyList.load(Dir.data / "sun_earth_moon_20260101.toml")
+    traj = tmp / f"sem__{TIME_STEP}__{STEPS}.simstate"
+    Propagator("rk4", CPPPointMass(), progress=False).propagate(
+        time_step=TIME_STEP,
+        stop_time=STEPS * TIME_STEP,
+        body_list=body_list,
+        filename=traj,
+    )
+    ephem = traj.with_suffix(".simephem")
+    write_simephem(ephem, SimstateMemmap(traj), TOLERANCE)
+    return traj, ephem
+
+
+def test_segments_meet_tolerance_at_stored_steps(ephemeris: tuple[Path, Path]) -> None:
+    traj, ephem = ephemeris
+    sim, eph = SimstateMemmap(traj), SimephemMemmap(ephem)
+    assert ephem.stat().st_size < traj.stat().st_size / 20
+
+    steps = np.arange(sim.steps)
+    for b in range(sim.bodies):
+        state = eph.state(steps * float(TIME_STEP), b)
+        assert np.abs(state[:, :3] - sim.r[:, b][:, 0]).max() <= TOLERANCE
+        assert np.abs(state[:, 3:] - sim.v[:, b][:, 0]).max() <= TOLERANCE / TIME_STEP
+
+
+def test_segments_interpolate_between_steps(ephemeris: tuple[Path, Path]) -> None:
+    """Mid-step states must match a half RK4 step from the stored state."""
+    traj, ephem = ephemeris
+    sim, eph = SimstateMemmap(traj), SimephemMemmap(ephem)
+    mu = BodyList.load(Dir.data / "sun_earth_moon_20260101.toml").mu
+
+    for i in [0, 777, STEPS - 1]:
+        row = sim.mm[i]
+        y = np.concatenate([row[:, :3].ravel(), row[:, 3:].ravel()])
+        expected = rk4_cpp(y, TIME_STEP / 2, 2, mu)[-1]
+        t = (i + 0.5) * TIME_STEP
+        state = eph.state(np.full(sim.bodies, t), np.arange(sim.bodies))
+        np.testing.assert_allclose(
+            state[:, :3].ravel(), expected[: 3 * sim.bodies], rtol=0, atol=2 * TOLERANCE
+        )
+
+    with pytest.raises(RuntimeError):
+        eph.state(STEPS * TIME_STEP + 1.0, 0)
+
+
+def test_batch_queries_match_between_backends(
+    ephemeris: tuple[Path, Path], tmp_path: Path
+) -> None:
+    """Hermite queries on plain and compressed files, threaded or not, agree
+    with each other and with the Chebyshev segments"""
+    traj, ephem = ephemeris
+    sim = SimstateMemmap(traj)
+    compressed = tmp_path / traj.name
+    write_simstate(compressed, np.asarray(sim.mm), codec="zlib")
+
+    rng = np.random.default_rng(0)
+    times = rng.uniform(0.0, (STEPS - 1) * TIME_STEP, 100_000)
+    bodies = rng.integers(0, sim.bodies, times.size)
+
+    hermite = load_ephemeris(traj)
+    assert isinstance(hermite, HermiteInterpolator)
+    state = hermite.state(times, bodies)
+    np.testing.assert_array_equal(state, hermite.state(times, bodies, threads=1))
+    np.testing.assert_allclose(
+        state, load_ephemeris(compressed).state(times, bodies), rtol=1e-9
+    )
+    assert load_ephemeris(compressed).state(np.empty(0), 0).shape == (0, 6)
+    np.testing.assert_allclose(
+        state[:, :3],
+        load_ephemeris(ephem).state(times, bodies)[:, :3],
+        atol=2 * TOLERANCE,
+        rtol=0,
+    )
+
+    # Stored steps are reproduced exactly
+    np.testing.assert_array_equal(
+        hermite.state(np.arange(sim.steps) * float(TIME_STEP), 1), sim.mm[:, 1]
+    )
+    with pytest.raises(RuntimeError):
+        hermite.state(-1.0, 0)
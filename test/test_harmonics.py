@@ -0,0 +1,75 @@
+# SPDX-FileCopyrightText: © 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+#
+# SPDX-License-Identifier: AGPL-3.0-or-later
+
+import numpy as np
+import pytest
+
+from project.simulation.cpp_force_kernel import (
+    HarmonicField,
+    harmonic_cpp,
+    point_mass_cpp,
+)
+from project.simulation.harmonics import load_gravity_fields
+from project.utils import Dir
+from project.utils.data import BodyList
+
+MU_EARTH = 3.986004418e14
+R_EARTH = 6378136.3
+J2 = 1.08262668e-3
+
+
+def _two_body(r: list[float]) -> tuple[np.ndarray, np.ndarray]:
+    state = np.concatenate([[0.0, 0.0, 0.0], r, np.zeros(6)])
+    return state, np.array([MU_EARTH, 1e-6])
+
+
+def test_j2_matches_closed_form():
+    """A C20-only field must reproduce the textbook J2 acceleration."""
+    r = np.array([7.0e6, -2.0e6, 3.0e6])
+    state, mu = _two_body(list(r))
+    c = np.zeros((3, 1))
+    c[2, 0] = -J2 / np.sqrt(5.0)
+    field = HarmonicField(0, R_EARTH, c, np.zeros_like(c))
+
+    out = np.empty(12)
+    point_mass = np.empty(12)
+    harmonic_cpp(state, mu, [field], 0.0, out)
+    point_mass_cpp(state, mu, point_mass)
+
+    x, y, z = r
+    r2 = r @ r
+    k = -1.5 * J2 * MU_EARTH * R_EARTH**2 / r2**2.5
+    expected = k * np.array(
+        [x * (1 - 5 * z**2 / r2), y * (1 - 5 * z**2 / r2), z * (3 - 5 * z**2 / r2)]
+    )
+    np.testing.assert_allclose(out[9:12] - point_mass[9:12], expected, rtol=1e-12)
+
+
+def test_fields_conserve_momentum():
+    """Field forces act in reaction pairs, tesseral terms and rotation included."""
+    body_list = BodyList.load(Dir.data / "sun_earth_moon_20260101.toml")
+    fields = load_gravity_fields(body_list)
+    assert [f.body for f in fields] == [1]
+    assert fields[0].order > 0
+
+    out = np.empty(6 * body_list.n)
+    harmonic_cpp(body_list.y_0, body_list.mu, fields, 3600.0, out)
+    a = out[3 * body_list.n :].reshape(-1, 3)
+    total = body_list.mu @ a
+    assert np.all(np.abs(total) < 1e-12 * np.abs(body_list.mu[:, None] * a).max())
+
+
+@pytest.mark.parametrize("cutoff", [0.0, 1.0e6])
+def test_cutoff_reduces_to_point_mass(cutoff: float):
+    """Beyond the cutoff a primary only acts as a point mass."""
+    state, mu = _two_body([7.0e6, 0.0, 1.0e6])
+    c = np.zeros((3, 3))
+    c[2, 0] = -J2 / np.sqrt(5.0)
+    field = HarmonicField(0, R_EARTH, c, np.zeros_like(c), cutoff=cutoff)
+
+    out = np.empty(12)
+    point_mass = np.empty(12)
+    harmonic_cpp(state, mu, [field], 0.0, out)
+    point_mass_cpp(state, mu, point_mass)
+    np.testing.assert_allclose(out, point_mass, rtol=1e-14)
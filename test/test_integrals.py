@@ -0,0 +1,162 @@
+# SPDX-FileCopyrightText: © 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+#
+# SPDX-License-Identifier: AGPL-3.0-or-later
+
+from pathlib import Path
+
+import numpy as np
+import pytest
+
+from project.simulation import integrals as integrals_module
+from project.simulation.cpp_force_kernel import rk4_cpp
+from project.simulation.integrals import G, calculate_integrals
+from project.simulation.integrator import FunctionProtocol
+from project.simulation.model import CPPPointMass, NumpyPointMass
+from project.simulation.propagator import Propagator
+from project.utils import Dir
+from project.utils.data import BodyList
+from project.utils import siminteg
+from project.utils.siminteg import SimintegMemmap, SimintegWriter, integ_filename
+from project.utils.simstate import (
+    SimstateMemmap,
+    simstate_view_from_state_view,
+    write_simstate,
+)
+
+
+def _reference_integrals(data: np.ndarray, mu: np.ndarray) -> np.ndarray:
+    """Energy, angular and linear momentum and center of mass per step,
+    written out with NumPy"""
+    m = mu / G
+    r, v = data[:, :, :3], data[:, :, 3:6]
+    kinetic = 0.5 * np.einsum("i,tij,tij->t", m, v, v)
+    i, j = np.triu_indices(mu.size, k=1)
+    dist = np.linalg.norm(r[:, i] - r[:, j], axis=2)
+    potential = -np.sum(m[i] * mu[j] / dist, axis=1)
+    h = np.einsum("i,tij->tj", m, np.cross(r, v))
+    p = np.einsum("i,tij->tj", m, v)
+    com = np.einsum("i,tij->tj", m, r) / m.sum()
+    return np.column_stack([kinetic + potential, h, p, com])
+
+
+def _assert_integrals_close(actual: np.ndarray, expected: np.ndarray) -> None:
+    # Momenta sum terms of both signs: errors scale with the column, not the sum
+    scale = np.abs(expected).max(axis=0)
+    np.testing.assert_allclose(actual / scale, expected / scale, rtol=1e-12, atol=1e-10)
+
+
+def test_native_integrals_match_reference(tmp_path: Path) -> None:
+    """Parallel native integrals must match the NumPy formulas and be written
+    straight into the cache file, which is then reused."""
+    body_list = BodyList.load(Dir.data / "sun_earth_moon_20260101.toml")
+    time_step, steps = 3600, 2000
+    y = rk4_cpp(body_list.y_0, time_step, steps + 1, body_list.mu)
+    data = simstate_view_from_state_view(y, body_list.n)
+    filename = tmp_path / f"integ__{time_step}__{steps}.simstate"
+    write_simstate(filename, data)
+    sim = SimstateMemmap(filename)
+
+    expected = _reference_integrals(data, body_list.mu)
+    _assert_integrals_close(
+        calculate_integrals(sim, body_list.mu, verbose=False, threads=3), expected
+    )
+
+    cache = filename.with_suffix(".siminteg")
+    integrals = calculate_integrals(sim, body_list.mu, cache, verbose=False)
+    _assert_integrals_close(integrals, expected)
+    np.testing.assert_array_equal(SimintegMemmap(cache).mm, integrals)
+
+    # A cached file is loaded, not recomputed
+    np.testing.assert_array_equal(
+        calculate_integrals(sim, 2 * body_list.mu, cache, verbose=False), integrals
+    )
+
+
+def test_integrals_cache_resumes_with_summary(
+    tmp_path: Path, monkeypatch: pytest.MonkeyPatch
+) -> None:
+    """An interrupted cache keeps its committed rows and is completed from
+    there; the per-chunk min/max summary bounds the columns it covers."""
+    monkeypatch.setattr(integrals_module, "BLOCK_STEPS", 256)
+    monkeypatch.setattr(siminteg, "SUMMARY_ROWS", 64)
+    body_list = BodyList.load(Dir.data / "sun_earth_moon_20260101.toml")
+    time_step, steps, done = 3600, 2000, 700
+    y = rk4_cpp(body_list.y_0, time_step, steps + 1, body_list.mu)
+    data = simstate_view_from_state_view(y, body_list.n)
+    filename = tmp_path / f"resume__{time_step}__{steps}.simstate"
+    write_simstate(filename, data)
+    sim = SimstateMemmap(filename)
+    expected = calculate_integrals(sim, body_list.mu, verbose=False)
+
+    cache = filename.with_suffix(".siminteg")
+    with SimintegWriter(cache, steps + 1, dt=time_step) as writer:
+        writer.append(expected[:done])
+    partial = SimintegMemmap(cache)
+    assert not partial.complete and partial.mm.shape[0] == done
+
+    computed = []
+
+    def counting(d: np.ndarray, *args: object) -> None:
+        computed.append(d.shape[0])
+        integrals_cpp(d, *args)
+
+    integrals_cpp = integrals_module.integrals_cpp
+    monkeypatch.setattr(integrals_module, "integrals_cpp", counting)
+    np.testing.assert_array_equal(
+        calculate_integrals(sim, body_list.mu, cache, verbose=False), expected
+    )
+    assert sum(computed) == steps + 1 - done
+
+    integ = SimintegMemmap(cache)
+    assert integ.complete and integ.summary is not None
+    chunks = expected[: (integ.summary.shape[0] - 1) * 64].reshape(-1, 64, 10)
+    np.testing.assert_array_equal(integ.summary[:-1, 0], chunks.min(axis=1))
+    np.testing.assert_array_equal(integ.summary[:-1, 1], chunks.max(axis=1))
+    np.testing.assert_array_equal(
+        integ.summary[-1, 1], expected[(steps + 1) // 64 * 64 :].max(axis=0)
+    )
+
+    t, lo, hi = integ.envelope(0, points=8)
+    assert (
+        t[0] == 0
+        and lo.min() == expected[:, 0].min()
+        and hi.max() == expected[:, 0].max()
+    )
+
+
+@pytest.mark.parametrize("force_model", [CPPPointMass(), NumpyPointMass()])
+def test_integrals_recorded_during_propagation(
+    tmp_path: Path, force_model: FunctionProtocol
+) -> None:
+    """Integrals emitted while propagating (fused natively, or per chunk)
+    must match a second pass over the trajectory at the requested cadence,
+    without changing the trajectory."""
+    body_list = BodyList.load(Dir.data / "sun_earth_moon_20260101.toml")
+    time_step, steps, every = 3600, 1000, 8  # last state sampled too
+    plain = tmp_path / f"plain__{time_step}__{steps}.simstate"
+    monitored = tmp_path / "monitored" / plain.name
+    monitored.parent.mkdir()
+
+    for filename, integrals_every in [(plain, None), (monitored, every)]:
+        Propagator(
+            "rk4",
+            force_model,
+            progress=False,
+            chunk_steps=64,
+            integrals_every=integrals_every,
+        ).propagate(
+            time_step=time_step,
+            stop_time=steps * time_step,
+            body_list=body_list,
+            filename=filename,
+        )
+    assert plain.read_bytes() == monitored.read_bytes()
+    assert not integ_filename(plain).exists()
+
+    integ = SimintegMemmap(integ_filename(monitored))
+    assert integ.stride == every and integ.mm.shape == (steps // every + 1, 10)
+    np.testing.assert_array_equal(integ.t, np.arange(0, steps + 1, every) * time_step)
+    sim = SimstateMemmap(monitored)
+    _assert_integrals_close(
+        integ.mm, _reference_integrals(np.asarray(sim.mm[::every]), body_list.mu)
+    )
@@ -9,6 +9,8 @@ from project.simulation.model import (
     CPPPointMass,
     NumbaPointMass,
     NumpyPointMass,
+    Precision,
+    rk4_tangent,
 )
 from project.utils import Dir
 from project.utils.data import BodyList
@@ -19,7 +21,7 @@ def solar_system_state():
     """
     Load a realistic N-body test state once per module.
     """
-    bl = BodyList.load(Dir.data / "solar_system_2460967.toml")
+    bl = BodyList.load(Dir.data / "solar_system_20260101.toml")
     return bl.y_0.copy(), bl.n, bl.mu
 
 
@@ -72,3 +74,71 @@ def test_pointmass_single_derivative_consistency(
         atol=atol,
         err_msg="NumPy and C++ kernels disagree on single derivative",
     )
+
+
+@pytest.mark.parametrize(
+    "precision,rtol",
+    [
+        ("f32", 1e-2),
+        ("dd", 1e-13),
+    ],
+)
+def test_pointmass_precision_consistency(
+    solar_system_state,
+    precision: Precision,
+    rtol: float,
+):
+    """
+    Reduced and extended precision C++ kernels must agree with the float64
+    kernel to within their own resolution.
+    """
+    state, n, mu = solar_system_state
+    out_f64 = np.empty_like(state)
+    out = np.empty_like(state)
+
+    CPPPointMass()(state, out=out_f64, n=n, mu=mu)
+    CPPPointMass(precision)(state, out=out, n=n, mu=mu)
+
+    np.testing.assert_allclose(
+        out,
+        out_f64,
+        rtol=rtol,
+        atol=1e-13,
+        err_msg=f"{precision} and f64 C++ kernels disagree on single derivative",
+    )
+
+
+def test_rk4_tangent_matches_finite_difference(solar_system_state):
+    """
+    Dual-number sensitivities of the final state to mu must match a central
+    finite difference of two float64 runs.
+    """
+    state, _, mu = solar_system_state
+    time_step = 60.0
+    stop_time = 3600.0
+
+    d_mu = np.zeros_like(mu)
+    d_mu[0] = 1.0
+    eps = mu[0] * 1e-4
+
+    _, dy = rk4_tangent(
+        state, np.zeros_like(state), time_step, stop_time, mu, d_mu=d_mu
+    )
+
+    kernel = CPPPointMass()
+    y_plus = kernel._rk4_backend(
+        state, time_step, stop_time, n=mu.size, mu=mu + eps * d_mu, progress=False
+    )
+    y_minus = kernel._rk4_backend(
+        state, time_step, stop_time, n=mu.size, mu=mu - eps * d_mu, progress=False
+    )
+    fd = (y_plus[-1] - y_minus[-1]) / (2 * eps)
+
+    # Positions and velocities have very different scales, compare separately
+    for part in np.split(np.arange(state.size), 2):
+        np.testing.assert_allclose(
+            dy[-1, part],
+            fd[part],
+            rtol=1e-4,
+            atol=1e-4 * np.max(np.abs(fd[part])),
+        )
@@ -0,0 +1,71 @@
+# SPDX-FileCopyrightText: © 2026 Michelangelo Secondo <michelangelo@secondo.aero>
+#
+# SPDX-License-Identifier: AGPL-3.0-or-later
+
+import numpy as np
+
+from project.simulation.cpp_force_kernel import (
+    SPEED_OF_LIGHT,
+    eih_cpp,
+    point_mass_cpp,
+    rk4_eih_cpp,
+)
+from project.utils import Dir
+from project.utils.data import BodyList
+
+MU_SUN = 1.32712440018e20
+MU_MERCURY = 2.2032e13
+A_MERCURY = 5.790905e10
+E_MERCURY = 0.205630
+
+
+def _eccentricity_angle(y: np.ndarray, mu: float) -> float:
+    r = y[3:6] - y[0:3]
+    v = y[9:12] - y[6:9]
+    e = ((v @ v - mu / np.linalg.norm(r)) * r - (r @ v) * v) / mu
+    return float(np.arctan2(e[1], e[0]))
+
+
+def test_eih_reduces_to_newton():
+    """Corrections vanish as c grows and stay at the 1e-8 level for c."""
+    body_list = BodyList.load(Dir.data / "solar_system_20260101.toml")
+    newton = np.empty(6 * body_list.n)
+    eih = np.empty(6 * body_list.n)
+    point_mass_cpp(body_list.y_0, body_list.mu, newton)
+
+    eih_cpp(body_list.y_0, body_list.mu, eih, 1e30)
+    np.testing.assert_allclose(eih, newton, rtol=1e-13)
+
+    eih_cpp(body_list.y_0, body_list.mu, eih)
+    rel = np.abs(eih - newton).max() / np.abs(newton[3 * body_list.n :]).max()
+    assert 1e-10 < rel < 1e-6
+
+
+def test_mercury_perihelion_precession():
+    """Sun-Mercury perihelion advance must match 6 pi mu / (c^2 a (1 - e^2))."""
+    mu = np.array([MU_SUN, MU_MERCURY])
+    mu_total = mu.sum()
+    r_p = A_MERCURY * (1 - E_MERCURY)
+    v_p = np.sqrt(mu_total * (1 + E_MERCURY) / r_p)
+
+    # Barycentric two-body state at perihelion
+    state = np.zeros(12)
+    state[3] = r_p * MU_SUN / mu_total
+    state[0] = -r_p * MU_MERCURY / mu_total
+    state[10] = v_p * MU_SUN / mu_total
+    state[7] = -v_p * MU_MERCURY / mu_total
+
+    period = 2 * np.pi * np.sqrt(A_MERCURY**3 / mu_total)
+    orbits = 10
+    time_step = period / 20_000
+    y = rk4_eih_cpp(state, time_step, orbits * 20_000 + 1, mu)
+
+    advance = _eccentricity_angle(y[-1], mu_total) - _eccentricity_angle(y[0], mu_total)
+    expected = (
+        orbits
+        * 6
+        * np.pi
+        * mu_total
+        / (SPEED_OF_LIGHT**2 * A_MERCURY * (1 - E_MERCURY**2))
+    )
+    np.testing.assert_allclose(advance, expected, rtol=1e-3)
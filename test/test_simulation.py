@@ -3,18 +3,50 @@
 # SPDX-License-Identifier: AGPL-3.0-or-later
 
 import os
+from pathlib import Path
 from typing import Literal
 
 import numpy as np
 import pytest
 from numpy.typing import ArrayLike
 
+from project.simulation import Simulation
+from project.simulation.cpp_force_kernel import rk4_simstate_cpp
+from project.simulation.integrator import FunctionProtocol, Integrator
+from project.simulation.model import CPPPointMass, NumbaPointMass, NumpyPointMass
+from project.simulation.propagator import Propagator
 from project.utils import Dir
+from project.utils.data import BodyList
+from project.utils.simcache import TrajectoryCache, trajectory_key
+from project.utils.simcheckpoint import (
+    Checkpoint,
+    checkpoint_filename,
+    force_model_key,
+    read_checkpoint,
+    write_checkpoint,
+)
+from project.utils.siminteg import integ_filename
+from project.utils.simlod import (
+    SimlodMemmap,
+    TrajectoryPyramid,
+    lod_filename,
+    write_simlod,
+)
+from project.utils.simrate import SimrateMemmap, cadence_from_periods, write_simrate
+from project.utils.simshards import ShardedSimstate, read_manifest, shard_simstate
+from project.utils.simsnap import SimsnapMemmap, write_simsnap
 from project.utils.simstate import (
+    ChunkedSimstate,
     SimstateMemmap,
+    SimstateWriter,
+    TiledSimstate,
+    pack_header,
+    partial_filename,
+    retile_simstate,
     simstate_view_from_state_view,
     write_simstate,
 )
+from project.utils.simstate_codec import encode_quantized_chunk, zstandard
 
 FILENAME_MM_TEST = Dir.test / "test__1__2.simstate"
 
@@ -93,3 +125,670 @@ def test_memmap(
     mm = SimstateMemmap(FILENAME_MM_TEST)
     actual = getattr(mm, rv)[step, body]
     np.testing.assert_allclose(actual, np.array(expected))
+
+
+@pytest.mark.parametrize(
+    "force_model",
+    [NumpyPointMass(), NumbaPointMass(), CPPPointMass(), CPPPointMass("dd")],
+)
+def test_streamed_propagation_matches_full(
+    tmp_path: Path, force_model: FunctionProtocol
+) -> None:
+    """Chunks written straight to disk must equal the materialized trajectory,
+    including a last chunk shorter than the others."""
+    body_list = BodyList.load(Dir.data / "sun_earth_moon_20260101.toml")
+    time_step, steps = 60, 100
+    filename = tmp_path / f"stream__{time_step}__{steps}.simstate"
+
+    Propagator("rk4", force_model, progress=False, chunk_steps=7).propagate(
+        time_step=time_step,
+        stop_time=steps * time_step,
+        body_list=body_list,
+        filename=filename,
+    )
+
+    y = Integrator.rk4(
+        body_list.y_0,
+        time_step,
+        steps * time_step,
+        force_model,
+        n=body_list.n,
+        mu=body_list.mu,
+        progress=False,
+    )
+    mm = SimstateMemmap(filename)
+    assert mm.steps == steps + 1
+    np.testing.assert_array_equal(mm.mm, simstate_view_from_state_view(y, body_list.n))
+    assert not filename.with_name(filename.name + ".part").exists()
+
+
+def test_simstate_writer_drops_incomplete_file(tmp_path: Path) -> None:
+    """An interrupted stream must not leave a file under the final name."""
+    filename = tmp_path / "partial__1__4.simstate"
+    with pytest.raises(RuntimeError):
+        with SimstateWriter(filename, 2) as writer:
+            writer.write(np.zeros((2, 12)))
+            raise RuntimeError("interrupted")
+    assert not filename.exists()
+    assert list(tmp_path.iterdir()) == []
+
+    with pytest.raises(ValueError):
+        with SimstateWriter(filename, 2) as writer:
+            writer.write(np.zeros((2, 12)))
+    assert list(tmp_path.iterdir()) == []
+
+
+@pytest.mark.parametrize("direct_io", [False, True])
+def test_native_writer_overlap_is_transparent(tmp_path: Path, direct_io: bool) -> None:
+    """The writer thread and O_DIRECT must not change a single byte, whatever
+    the buffer size relative to the file."""
+    body_list = BodyList.load(Dir.data / "sun_earth_moon_20260101.toml")
+    time_step, steps = 60, 500
+    header = pack_header(steps + 1, body_list.n, 6, time_step)
+
+    files = []
+    for overlap, buffer_steps in [(False, 1000), (True, 3), (True, 64)]:
+        filename = tmp_path / f"{overlap}_{buffer_steps}.simstate"
+        stats = rk4_simstate_cpp(
+            body_list.y_0,
+            time_step,
+            steps + 1,
+            body_list.mu,
+            str(filename),
+            header,
+            buffer_steps=buffer_steps,
+            direct_io=direct_io,
+            overlap=overlap,
+        )
+        assert stats["steps"] == steps + 1
+        files.append(filename.read_bytes())
+
+    assert len(files[0]) == len(header) + (steps + 1) * body_list.n * 6 * 8
+    assert files[0] == files[1] == files[2]
+
+
+@pytest.mark.parametrize(
+    "codec",
+    [
+        "none",
+        "zlib",
+        pytest.param(
+            "zstd",
+            marks=pytest.mark.skipif(zstandard is None, reason="zstandard missing"),
+        ),
+    ],
+)
+def test_compressed_simstate_is_lossless(tmp_path: Path, codec: str) -> None:
+    """A chunked v2 file must read back exactly, through every kind of index,
+    including ones spanning chunk boundaries."""
+    body_list = BodyList.load(Dir.data / "sun_earth_moon_20260101.toml")
+    time_step, steps = 60, 300
+    raw = tmp_path / f"raw__{time_step}__{steps}.simstate"
+    streamed = tmp_path / f"streamed__{time_step}__{steps}.simstate"
+    packed = tmp_path / f"packed__{time_step}__{steps}.simstate"
+
+    for filename, c in [(raw, None), (streamed, codec)]:
+        Propagator(
+            "rk4", NumpyPointMass(), progress=False, chunk_steps=45, codec=c
+        ).propagate(
+            time_step=time_step,
+            stop_time=steps * time_step,
+            body_list=body_list,
+            filename=filename,
+        )
+    mm_raw = SimstateMemmap(raw)
+    write_simstate(packed, np.asarray(mm_raw.mm), codec=codec, chunk_steps=64)
+
+    np.testing.assert_array_equal(np.asarray(SimstateMemmap(streamed).mm), mm_raw.mm)
+    mm = SimstateMemmap(packed)
+    assert isinstance(mm.mm, ChunkedSimstate)
+    for key in [
+        7,
+        -1,
+        (slice(10, 250, 7), 1),
+        (slice(None, None, -3), slice(0, 2)),
+        (np.array([300, 0, 129, 128]), 2, slice(3, 6)),
+        slice(5, 5),
+        np.array([], dtype=np.int64),
+    ]:
+        np.testing.assert_array_equal(mm.mm[key], mm_raw.mm[key])
+    np.testing.assert_array_equal(mm.r_vis[100:200, 1], mm_raw.r_vis[100:200, 1])
+    np.testing.assert_array_equal(mm.v[5], mm_raw.v[5])
+    for bad in ([0, steps + 1], [-steps - 2]):
+        with pytest.raises(IndexError):
+            mm.mm[np.array(bad)]
+
+
+@pytest.mark.parametrize("tile_steps", [64, 1000])
+def test_tiled_simstate_matches_step_major(tmp_path: Path, tile_steps: int) -> None:
+    """Body-major tiles (and a fully body-major file) must read back exactly
+    like the step-major file they were transposed from."""
+    body_list = BodyList.load(Dir.data / "sun_earth_moon_20260101.toml")
+    time_step, steps = 60, 300
+    raw = tmp_path / f"raw__{time_step}__{steps}.simstate"
+    streamed = tmp_path / "streamed" / raw.name
+    retiled = tmp_path / "retiled" / raw.name
+    streamed.parent.mkdir()
+    retiled.parent.mkdir()
+
+    for filename, t in [(raw, None), (streamed, tile_steps)]:
+        Propagator(
+            "rk4", NumpyPointMass(), progress=False, chunk_steps=45, tile_steps=t
+        ).propagate(
+            time_step=time_step,
+            stop_time=steps * time_step,
+            body_list=body_list,
+            filename=filename,
+        )
+    retile_simstate(raw, retiled, tile_steps)
+    assert streamed.read_bytes() == retiled.read_bytes()
+
+    mm_raw = SimstateMemmap(raw)
+    mm = SimstateMemmap(retiled)
+    assert isinstance(mm.mm, TiledSimstate)
+    for key in [
+        7,
+        -1,
+        (slice(10, 250, 7), 1),
+        (slice(None, None, -3), slice(0, 2)),
+        (np.array([300, 0, 129, 128]), 2, slice(3, 6)),
+        (5, -1, 4),
+        slice(5, 5),
+        (np.array([], dtype=np.int64), 1),
+    ]:
+        np.testing.assert_array_equal(mm.mm[key], mm_raw.mm[key])
+    np.testing.assert_array_equal(mm.r_vis[100:200, 1], mm_raw.r_vis[100:200, 1])
+    np.testing.assert_array_equal(np.asarray(mm.mm), mm_raw.mm)
+
+
+def test_lod_pyramid_serves_strided_reads(tmp_path: Path) -> None:
+    """Pyramid levels must hold every 2^k-th position, and strided reads must
+    come from the coarsest level at or below the stride."""
+    rng = np.random.default_rng(0)
+    filename = tmp_path / "lod__60__3000.simstate"
+    write_simstate(filename, rng.standard_normal((3001, 3, 6)))
+    sim = SimstateMemmap(filename)
+    write_simlod(lod_filename(filename), sim, min_rows=16)
+    lod = SimlodMemmap(lod_filename(filename))
+    pyramid = TrajectoryPyramid(sim, lod)
+
+    assert lod.strides == [2, 4, 8, 16, 32, 64, 128]
+    for stride, level in zip(lod.strides, lod.levels):
+        np.testing.assert_array_equal(level, sim.mm[::stride, :, :3])
+
+    assert pyramid.level_for(1) == 0
+    assert pyramid.level_for(12) == 3
+    assert pyramid.level_for(10**6) == len(lod.levels)
+    assert pyramid.level_for_time(600.0) == (3, 8)
+    np.testing.assert_array_equal(pyramid.r_vis(0, 3000, 8), sim.r_vis[0:3000:8])
+    np.testing.assert_array_equal(pyramid.r_vis(7, 99, 1, 2), sim.r_vis[7:99, 2])
+
+    # Unaligned starts and steps fall back to the finest exact level
+    for start, step in [(5, 12), (16, 12), (8, 24), (96, 100)]:
+        np.testing.assert_array_equal(
+            pyramid.r_vis(start, 2001, step, 1), sim.r_vis[start:2001:step, 1]
+        )
+
+
+def test_lossy_simstate_respects_error_bound(tmp_path: Path) -> None:
+    """Quantized storage must decode transparently within the requested
+    position and velocity bounds."""
+    body_list = BodyList.load(Dir.data / "sun_earth_moon_20260101.toml")
+    time_step, steps = 3600, 500
+    raw = tmp_path / f"raw__{time_step}__{steps}.simstate"
+    lossy = tmp_path / f"lossy__{time_step}__{steps}.simstate"
+    error_bound = 1e3
+
+    for filename, bound in [(raw, None), (lossy, error_bound)]:
+        Propagator(
+            "rk4", NumpyPointMass(), progress=False, error_bound=bound
+        ).propagate(
+            time_step=time_step,
+            stop_time=steps * time_step,
+            body_list=body_list,
+            filename=filename,
+        )
+
+    mm_raw, mm = SimstateMemmap(raw), SimstateMemmap(lossy)
+    assert isinstance(mm.mm, ChunkedSimstate) and mm.mm.lossy
+    assert lossy.stat().st_size < raw.stat().st_size / 4
+
+    r_err = np.abs(mm.r[:] - mm_raw.r[:])
+    v_err = np.abs(mm.v[:] - mm_raw.v[:])
+    assert r_err.max() <= error_bound * (1 + 1e-9)
+    assert v_err.max() <= error_bound / time_step * (1 + 1e-9)
+    assert r_err.max() > 0  # actually quantized
+    np.testing.assert_array_equal(mm.r_vis[42, 1], mm.r_vis[40:50, 1][2:3])
+
+    # Offsets that would wrap int64 are rejected instead of breaking the bound
+    data = np.zeros((2, 1, 6))
+    data[1, 0, 0] = 1e20
+    with pytest.raises(ValueError, match="error_bound"):
+        encode_quantized_chunk(data, 0, 0, np.full(6, 1e-3))
+
+
+def test_native_reader_views_match_memmap(tmp_path: Path) -> None:
+    """Views of the natively mapped file must equal NumPy indexing of a plain
+    memmap, without copying and without write access."""
+    rng = np.random.default_rng(1)
+    filename = tmp_path / "native__60__400.simstate"
+    data = rng.standard_normal((401, 4, 6))
+    write_simstate(filename, data)
+    sim = SimstateMemmap(filename)
+    assert sim.native is not None and sim.native.times() is None
+    assert not sim.mm.flags.writeable
+    np.testing.assert_array_equal(sim.mm, data)
+
+    for key in [
+        7,
+        (3, 2),
+        slice(10, 250, 7),
+        (slice(None, None, -3), slice(0, 4, 2)),
+        (slice(5, 5), 1),
+        (-1, -2),
+    ]:
+        step, body = key if isinstance(key, tuple) else (key, slice(None))
+        step = slice(step, step + 1 or None) if isinstance(step, int) else step
+        body = slice(body, body + 1 or None) if isinstance(body, int) else body
+        r, v = sim.r[key], sim.v_vis[key]
+        np.testing.assert_array_equal(r, data[step, body, :3])
+        np.testing.assert_array_equal(v, data[step, body, 3:].transpose(0, 2, 1))
+        assert not r.flags.writeable and not r.flags.owndata
+
+    # Index arrays fall back to NumPy indexing
+    np.testing.assert_array_equal(sim.r[np.array([4, 0]), 1], data[[4, 0], 1:2, :3])
+    sim.advise("willneed", 100, 200)
+    sim.advise("sequential")
+    for start, stop in [(200, 100), (0, 402)]:
+        with pytest.raises(IndexError):
+            sim.advise("willneed", start, stop)
+
+    compressed = tmp_path / "compressed" / filename.name
+    compressed.parent.mkdir()
+    write_simstate(compressed, data, codec="zlib")
+    assert SimstateMemmap(compressed).native is None
+
+
+@pytest.mark.parametrize("force_model", [NumpyPointMass(), CPPPointMass()])
+def test_extend_matches_fresh_propagation(
+    tmp_path: Path, force_model: FunctionProtocol
+) -> None:
+    """Extending a checkpointed run must write the bytes of a run propagated
+    to the longer time from the start; the shorter run stays available as
+    a prefix view."""
+    body_list = BodyList.load(Dir.data / "sun_earth_moon_20260101.toml")
+    dt, short, long = 3600, 300, 500
+    fresh = tmp_path / "fresh" / f"sem__{dt}__{long}.simstate"
+    source = tmp_path / f"sem__{dt}__{short}.simstate"
+    extended = tmp_path / fresh.name
+    fresh.parent.mkdir()
+
+    propagator = Propagator("rk4", force_model, progress=False, chunk_steps=64)
+    propagator.propagate(dt, long * dt, body_list, fresh)
+    propagator.propagate(dt, short * dt, body_list, source)
+    prefix = np.array(SimstateMemmap(source).mm)
+
+    with pytest.raises(ValueError, match="cannot extend"):
+        Propagator("euler", force_model, progress=False).extend(
+            source, body_list, extended
+        )
+    assert source.exists() and checkpoint_filename(source).exists()
+    for options in ({"shard_steps": 120}, {"codec": "zlib"}):
+        with pytest.raises(ValueError, match="cannot extend"):
+            Propagator("rk4", force_model, progress=False, **options).extend(
+                source, body_list, extended
+            )
+    assert sorted(p.name for p in tmp_path.iterdir()) == sorted(
+        ["fresh", source.name, checkpoint_filename(source).name]
+    )
+
+    propagator.extend(source, body_list, extended)
+    assert not source.exists() and not checkpoint_filename(source).exists()
+    assert extended.read_bytes() == fresh.read_bytes()
+    assert read_checkpoint(checkpoint_filename(extended)).steps == long + 1
+
+    view = SimstateMemmap(extended, steps=short + 1)
+    assert view.steps == short + 1 and view.t[-1] == short * dt
+    np.testing.assert_array_equal(view.mm, prefix)
+    np.testing.assert_array_equal(view.r[-1], prefix[-1:, :, :3])
+
+    # Chunked files are served the same way
+    chunked = tmp_path / "chunked" / extended.name
+    chunked.parent.mkdir()
+    write_simstate(chunked, np.asarray(SimstateMemmap(extended).mm), codec="zlib")
+    np.testing.assert_array_equal(
+        SimstateMemmap(chunked, steps=short + 1).r[-2:, 1], prefix[-2:, 1:2, :3]
+    )
+
+
+@pytest.mark.parametrize("force_model", [NumpyPointMass(), CPPPointMass()])
+def test_resume_matches_uninterrupted_propagation(
+    tmp_path: Path, force_model: FunctionProtocol
+) -> None:
+    """A propagation interrupted by Ctrl-C keeps its partial files and last
+    checkpoint; resuming it writes the bytes of an uninterrupted run."""
+    body_list = BodyList.load(Dir.data / "sun_earth_moon_20260101.toml")
+    dt, steps = 3600, 500
+    fresh = tmp_path / "fresh" / f"sem__{dt}__{steps}.simstate"
+    resumed = tmp_path / fresh.name
+    fresh.parent.mkdir()
+
+    def propagator() -> Propagator:
+        return Propagator(
+            "rk4",
+            force_model,
+            progress=False,
+            chunk_steps=64,
+            integrals_every=7,
+            checkpoint_steps=100,
+        )
+
+    propagator().propagate(dt, steps * dt, body_list, fresh)
+
+    interrupted = propagator()
+    chunks = interrupted.integrator_chunks
+
+    def interrupt(*args, **kwargs):  # type: ignore[no-untyped-def]
+        for i, chunk in enumerate(chunks(*args, **kwargs)):
+            if i == 5:
+                raise KeyboardInterrupt
+            yield chunk
+
+    interrupted.integrator_chunks = interrupt
+    with pytest.raises(KeyboardInterrupt):
+        interrupted.propagate(dt, steps * dt, body_list, resumed)
+    assert not resumed.exists()
+    assert partial_filename(resumed).exists()
+    assert read_checkpoint(checkpoint_filename(resumed)).steps == 65 + 4 * 64
+
+    propagator().resume(resumed, body_list)
+    assert not partial_filename(resumed).exists()
+    assert resumed.read_bytes() == fresh.read_bytes()
+    assert integ_filename(resumed).read_bytes() == integ_filename(fresh).read_bytes()
+    assert read_checkpoint(checkpoint_filename(resumed)).steps == steps + 1
+
+
+def test_sharded_trajectory_matches_single_file(tmp_path: Path) -> None:
+    """A run written as time shards reads back as the single-file run, and
+    only the shards an index touches are opened."""
+    body_list = BodyList.load(Dir.data / "sun_earth_moon_20260101.toml")
+    dt, steps = 3600, 500
+    single = tmp_path / "single" / f"sem__{dt}__{steps}.simstate"
+    sharded = tmp_path / single.name
+    single.parent.mkdir()
+    Propagator("rk4", NumpyPointMass(), progress=False, chunk_steps=64).propagate(
+        dt, steps * dt, body_list, single
+    )
+    Propagator(
+        "rk4", NumpyPointMass(), progress=False, chunk_steps=64, shard_steps=120
+    ).propagate(dt, steps * dt, body_list, sharded)
+    assert sharded.is_dir() and not partial_filename(sharded).exists()
+    assert len(read_manifest(sharded)["shards"]) == 5
+
+    expected = np.array(SimstateMemmap(single).mm)
+    sim = SimstateMemmap(sharded)
+    assert isinstance(sim.mm, ShardedSimstate)
+    assert (sim.steps, sim.bodies, sim.dt) == (steps + 1, body_list.n, dt)
+    np.testing.assert_array_equal(sim.mm[250], expected[250])
+    assert list(sim.mm._open) == [2]
+    np.testing.assert_array_equal(sim.r[115:125, 1], expected[115:125, 1:2, :3])
+    np.testing.assert_array_equal(sim.mm[[-1, 0, 361]], expected[[-1, 0, 361]])
+    np.testing.assert_array_equal(sim.mm, expected)
+    np.testing.assert_array_equal(SimstateMemmap(sharded, steps=200).mm, expected[:200])
+    assert sim.mm[5:5].shape == (0, body_list.n, 6)
+    assert SimstateMemmap(sharded, steps=0).mm[:].shape == (0, body_list.n, 6)
+
+    # Shards may be compressed, and any trajectory can be resharded
+    resharded = tmp_path / "zlib" / single.name
+    shard_simstate(sharded, resharded, shard_steps=64, codec="zlib")
+    np.testing.assert_array_equal(SimstateMemmap(resharded).mm[::7], expected[::7])
+
+
+@pytest.mark.parametrize("codec", [None, "zlib"])
+def test_variable_step_time_index(tmp_path: Path, codec: str | None) -> None:
+    """Variable-step files store their time column, and times map to the
+    step at or before them, natively for mapped files."""
+    rng = np.random.default_rng(7)
+    steps = 3000
+    t = np.cumsum(rng.uniform(1.0, 100.0, steps))
+    data = rng.standard_normal((steps, 2, 6))
+    filename = tmp_path / f"var__-1__{steps - 1}.simstate"
+    with pytest.raises(ValueError, match="if and only if"):
+        write_simstate(filename, data, codec=codec)
+    with pytest.raises(ValueError, match="increasing"):
+        write_simstate(filename, data, t=t[::-1].copy(), codec=codec)
+    write_simstate(filename, data, t=t, codec=codec)
+
+    sim = SimstateMemmap(filename)
+    assert (sim.native is not None) == (codec is None)
+    np.testing.assert_array_equal(sim.t, t)
+    np.testing.assert_array_equal(sim.mm, data)
+
+    queries = np.concatenate(
+        [[-5.0, t[0], t[-1], t[-1] + 1.0], t[::97], rng.uniform(0, t[-1], 500)]
+    )
+    expected = np.maximum(np.searchsorted(t, queries, side="right") - 1, 0)
+    np.testing.assert_array_equal(sim.step_at(queries), expected)
+    assert sim.step_at(t[1234]) == 1234
+    assert SimstateMemmap(filename, steps=100).step_at(t[-1]) == 99
+
+    fixed = tmp_path / f"fixed__60__{steps - 1}.simstate"
+    write_simstate(fixed, data, codec=codec)
+    np.testing.assert_array_equal(
+        SimstateMemmap(fixed).step_at([-1.0, 0.0, 59.9, 60.0, 1e9]),
+        [0, 0, 0, 1, steps - 1],
+    )
+
+
+def test_per_body_cadence(tmp_path: Path) -> None:
+    """A trajectory stored at per-body cadences opens as the trajectory:
+    samples are exact and the other steps are reconstructed within the
+    tolerance that chose the strides."""
+    body_list = BodyList.load(Dir.data / "sun_earth_moon_20260101.toml")
+    dt, steps = 3600, 1000
+    full = tmp_path / "full" / f"sem__{dt}__{steps}.simstate"
+    filename = tmp_path / full.name
+    full.parent.mkdir()
+    Propagator("rk4", NumpyPointMass(), progress=False, chunk_steps=64).propagate(
+        dt, steps * dt, body_list, full
+    )
+    reference = SimstateMemmap(full)
+    expected = np.array(reference.mm)
+
+    Propagator(
+        "rk4",
+        NumpyPointMass(),
+        progress=False,
+        chunk_steps=64,
+        output_strides=[8, 4, 2],
+    ).propagate(dt, steps * dt, body_list, filename)
+    sim = SimstateMemmap(filename)
+    assert isinstance(sim.mm, SimrateMemmap) and sim.steps == steps + 1
+    streamed = sim.mm
+    np.testing.assert_array_equal(streamed.strides, [8, 4, 2])
+    for body in range(3):
+        kept = streamed.sample_steps(body)
+        assert kept[-1] == steps
+        np.testing.assert_array_equal(streamed.samples[body], expected[kept, body])
+        np.testing.assert_array_equal(streamed[kept, body], expected[kept, body])
+    np.testing.assert_allclose(streamed[::3], expected[::3], rtol=1e-6)
+    np.testing.assert_allclose(
+        sim.r_vis[10:20, 1], reference.r_vis[10:20, 1], rtol=1e-6
+    )
+    assert streamed[..., 0].shape == (steps + 1, 3)
+    assert streamed[5, ...].shape == (3, 6)
+    with pytest.raises(IndexError):
+        streamed[steps + 1]
+    prefix = SimstateMemmap(filename, steps=500)
+    np.testing.assert_array_equal(prefix.mm[-1], streamed[499])
+
+    tolerance = 10.0
+    tolerant = tmp_path / "tolerant" / full.name
+    tolerant.parent.mkdir()
+    Propagator(
+        "rk4",
+        NumpyPointMass(),
+        progress=False,
+        chunk_steps=64,
+        output_tolerance=tolerance,
+    ).propagate(dt, steps * dt, body_list, tolerant)
+    assert [p.name for p in tolerant.parent.iterdir()] == [tolerant.name]
+    sampled = SimstateMemmap(tolerant).mm
+    assert isinstance(sampled, SimrateMemmap)
+    assert sampled.stored_nbytes < sampled.nbytes / 4 and sampled.strides.min() >= 1
+    error = np.linalg.norm(sampled[:, :, :3] - expected[:, :, :3], axis=-1)
+    assert error.max() <= 2 * tolerance
+    # Existing trajectories are resampled the same way
+    again = tmp_path / "again" / full.name
+    again.parent.mkdir()
+    strides = write_simrate(again, full, tolerance=tolerance)
+    np.testing.assert_array_equal(strides, sampled.strides)
+    np.testing.assert_array_equal(
+        cadence_from_periods([3.2e7, 2.4e6, 1.0], dt, samples_per_orbit=64),
+        [128, 8, 1],
+    )
+
+    for options in (
+        {"output_strides": [8, 4, 2], "output_tolerance": 1.0},
+        {"output_strides": [8, 4, 2], "codec": "zlib"},
+        {"output_tolerance": 1.0, "shard_steps": 100},
+    ):
+        with pytest.raises(ValueError):
+            Propagator("rk4", NumpyPointMass(), **options)
+
+    # Samples cannot be appended to
+    with pytest.raises(ValueError, match="cannot extend"):
+        Propagator(
+            "rk4", NumpyPointMass(), progress=False, output_strides=[8, 4, 2]
+        ).extend(full, body_list, tmp_path / f"sem__{dt}__{2 * steps}.simstate")
+
+
+def test_checkpoint_round_trip(tmp_path: Path) -> None:
+    """Multistep history and controller values survive a checkpoint."""
+    checkpoint = Checkpoint(
+        steps=11,
+        dt=60.0,
+        integrator="rk4",
+        force="NumpyPointMass()",
+        state=np.arange(12.0),
+        history=np.arange(36.0).reshape(3, 12),
+        controller=np.array([0.9, 1e-12]),
+    )
+    write_checkpoint(tmp_path / "a.simckpt", checkpoint)
+    read = read_checkpoint(tmp_path / "a.simckpt")
+    assert (read.steps, read.dt, read.integrator, read.force) == (
+        11,
+        60.0,
+        "rk4",
+        "NumpyPointMass()",
+    )
+    for name in ("state", "history", "controller"):
+        np.testing.assert_array_equal(getattr(read, name), getattr(checkpoint, name))
+
+    # I/O settings do not change the key runs are continued under
+    assert force_model_key(CPPPointMass(direct_io=True)) == force_model_key(
+        CPPPointMass()
+    )
+    assert force_model_key(CPPPointMass("f32")) == "CPPPointMass(precision='f32')"
+
+
+def test_snapshot_round_trip(tmp_path: Path) -> None:
+    """A .simsnap snapshot serves y_0 and mu from its mapped columns and
+    rebuilds the same bodies as the TOML file it was dumped from."""
+    body_list = BodyList.load(Dir.data / "sun_earth_moon_20260101.toml")
+    body_list.dump(tmp_path / "sem.simsnap")
+    snapshot = BodyList.load(tmp_path / "sem.simsnap")
+    assert len(snapshot) == len(body_list) and snapshot.n == body_list.n
+    assert snapshot.metadata == body_list.metadata
+    np.testing.assert_array_equal(snapshot.y_0, body_list.y_0)
+    np.testing.assert_array_equal(snapshot.mu, body_list.mu)
+    assert isinstance(snapshot.mu.base, np.memmap)
+    assert [b.model_dump() for b in snapshot] == [b.model_dump() for b in body_list]
+    assert snapshot[-1].name == body_list[-1].name
+    snapshot.dump(tmp_path / "sem.toml")
+    np.testing.assert_array_equal(
+        BodyList.load(tmp_path / "sem.toml").y_0, body_list.y_0
+    )
+    assert [b.name for b in snapshot[1:]] == [b.name for b in body_list[1:]]
+
+    # A read-only sequence over the snapshot, equal to the bodies it holds
+    assert snapshot and snapshot == body_list and not snapshot != list(body_list)
+    assert body_list[2] in snapshot and snapshot.index(body_list[2]) == 2
+    assert snapshot.count(body_list[1]) == 1
+    assert snapshot.copy() == body_list and snapshot + body_list == [*body_list] * 2
+    assert [b.name for b in reversed(snapshot)] == [b.name for b in body_list][::-1]
+    with pytest.raises(TypeError, match="read-only"):
+        snapshot.append(body_list[0])
+    with pytest.raises(TypeError, match="read-only"):
+        del snapshot[0]
+
+    n = 100_000
+    rng = np.random.default_rng(0)
+    r_0, v_0 = rng.normal(size=(n, 3)), rng.normal(size=(n, 3))
+    names = [f"{i}" if i % 3 else None for i in range(n)]
+    write_simsnap(tmp_path / "large.simsnap", names, rng.random(n), r_0, v_0)
+    large = BodyList.load(tmp_path / "large.simsnap")
+    np.testing.assert_array_equal(large.y_0, np.hstack([r_0.ravel(), v_0.ravel()]))
+    assert large[3].name is None and large[4].name == "4"
+    assert large[4].radius is None
+    assert SimsnapMemmap(tmp_path / "large.simsnap").names[:3] == [None, "1", "2"]
+
+
+def test_trajectory_cache_keys_and_eviction(
+    tmp_path: Path, monkeypatch: pytest.MonkeyPatch
+) -> None:
+    """Cache keys follow the contents of a run, not its name; runs of one key
+    share files, and the least recently used keys go first over budget."""
+    body_list = BodyList.load(Dir.data / "sun_earth_moon_20260101.toml")
+    key = trajectory_key(body_list.y_0, body_list.mu, "rk4", "NumbaPointMass()", 60)
+    mu = body_list.mu.copy()
+    mu[1] *= 1 + 1e-15
+    assert key == trajectory_key(
+        body_list.y_0.copy(), body_list.mu, "rk4", "NumbaPointMass()", 60.0
+    )
+    assert (
+        len(
+            {
+                key,
+                trajectory_key(body_list.y_0, mu, "rk4", "NumbaPointMass()", 60),
+                trajectory_key(
+                    body_list.y_0, body_list.mu, "euler", "NumbaPointMass()", 60
+                ),
+                trajectory_key(
+                    body_list.y_0, body_list.mu, "rk4", "NumpyPointMass()", 60
+                ),
+                trajectory_key(
+                    body_list.y_0, body_list.mu, "rk4", "NumbaPointMass()", 30
+                ),
+            }
+        )
+        == 5
+    )
+
+    # Simulations of one system share a key: the longer run extends the
+    # shorter, the shorter is then a prefix of it
+    monkeypatch.setattr(Dir, "simulation", tmp_path / "simulation")
+    short = Simulation("sun_earth_moon_20260101", dt=3600, time=3600 * 40)
+    long = Simulation("sun_earth_moon_20260101", dt=3600, time=3600 * 80)
+    again = Simulation("sun_earth_moon_20260101", dt=3600, time=3600 * 40)
+    assert short.key == long.key == again.key and again.file == long.file
+    np.testing.assert_array_equal(again.mm.mm, long.mm.mm[:41])
+    cache = TrajectoryCache(Dir.simulation)
+    assert cache.load_index()[long.key]["steps"] == 80
+    assert [p.suffix for p in cache.files(long.key)] == [
+        ".simckpt",
+        ".simlod",
+        ".simstate",
+    ]
+
+    # Eviction: least recently used first, never the key just used
+    cache = TrajectoryCache(tmp_path / "lru", budget=250)
+    for name in ["a", "b", "c"]:
+        (cache.directory / f"{name}__1__9.simstate").write_bytes(b"x" * 100)
+        (cache.directory / f"{name}__1__9.simckpt").write_bytes(b"x" * 10)
+        assert cache.touch(name, steps=9) == ([] if name != "c" else ["a"])
+    assert cache.touch("b") == []
+    (cache.directory / "d__1__9.simstate").write_bytes(b"x" * 200)
+    assert cache.touch("d") == ["c", "b"]
+    assert list(cache.load_index()) == ["d"] and cache.nbytes() == 200
+    assert not list(cache.directory.glob("[abc]__*"))